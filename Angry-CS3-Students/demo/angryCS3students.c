@@ -153,6 +153,7 @@ typedef struct state {
   scene_t *scene;
   
   vector_t *rubber_center;
+  body_handle_t rubber;
   
   bool return_press;
   bool front_page;
@@ -217,17 +218,16 @@ void setup(state_t *state, size_t n_pigs, size_t remaining_birds) {
 // Helper function that updates the scene when a bird leaves the screen
 void wrap_scene(state_t *state) {
     body_t *bird = get_body(state->scene, BIRD_ID);
-    size_t idx = get_idx(state->scene, BIRD_ID);
     vector_t vec = body_get_centroid(bird);
     if (vec.y <= 0 || vec.x >= WINDOW_W || vec.x <= 0) {
-        list_t *rubberband = make_rubberband(state->scene, state->rubber_center);
-        body_t *rubber = get_body(state->scene, RUBBER_ID);
-        body_set_shape(rubber, rubberband);
+        vertex_array_t *rubberband = make_rubberband(state->scene, state->rubber_center);
+        body_t *rubber = scene_get_body_by_handle(state->scene, state->rubber);
+        body_set_vertices(rubber, rubberband);
 
         // remove the bird
 
         if (state->remaining_birds > 0) {
-          scene_remove_body(state->scene, idx);
+          body_remove(bird);
           state->remaining_birds--;
 
           state->return_press = false;
@@ -247,49 +247,60 @@ void wrap_scene(state_t *state) {
         }
     }
 
-    // Go through all bodies in the scene and remove if their centroids are out of bounds
-    for (size_t i = 0; i < scene_bodies(state->scene); i++) {
-        body_t *curr_body = scene_get_body(state->scene, i);
-        vector_t centroid = body_get_centroid(curr_body);
-        size_t *info = body_get_info(curr_body);
-
-        if (*info == EGG_ID) {
-            if (centroid.x < 0 || centroid.x > WINDOW_W || centroid.y < 0 || centroid.y > WINDOW_H) {
-            scene_remove_body(state->scene, i);
-            } 
+    // Remove the eggs whose centroids are out of bounds
+    const body_ptr_array_t *eggs = scene_get_tagged(state->scene, EGG_ID);
+    for (size_t i = 0; i < body_ptr_array_size(eggs); i++) {
+        body_t *egg = body_ptr_array_get(eggs, i);
+        vector_t centroid = body_get_centroid(egg);
+        if (centroid.x < 0 || centroid.x > WINDOW_W || centroid.y < 0 || centroid.y > WINDOW_H) {
+            body_remove(egg);
         }
+    }
 
-        // If we collide, since we don't have angular physics implemented, we will
-        // bounce off the wall, remove the wall, and then make a tiny explosion around the wall
-        collision_info_t collision = find_collision(body_get_shape(bird), body_get_shape(curr_body));
-        if (collision.collided == true && *info==WALL_ID) {
-            scene_remove_body(state->scene, i);
-            scene_tick(state->scene, 0);
-
-            vector_t explosion_center = body_get_centroid(curr_body);
-
-            for (size_t i = 0; i < scene_bodies(state->scene); i++) {
-                body_t *body = scene_get_body(state->scene, i);
+    // If we collide, since we don't have angular physics implemented, we will
+    // bounce off the wall, remove the wall, and then make a tiny explosion around the wall.
+    // Only the bodies near the bird can be walls it hits.
+    body_ptr_array_t near_bird, blasted;
+    body_ptr_array_init(&near_bird, 0);
+    body_ptr_array_init(&blasted, 0);
+    scene_query_box(state->scene, body_get_bounds(bird), &near_bird);
+    for (size_t i = 0; i < body_ptr_array_size(&near_bird); i++) {
+        body_t *wall = body_ptr_array_get(&near_bird, i);
+        size_t *info = body_get_info(wall);
+        // An earlier explosion may have removed this wall
+        if (*info != WALL_ID || body_is_removed(wall)) {
+            continue;
+        }
+        collision_info_t collision = find_collision_bodies(bird, wall);
+        if (collision.collided == true) {
+            vector_t explosion_center = body_get_centroid(wall);
+            body_remove(wall);
+
+            scene_query_radius(state->scene, explosion_center, EXPLOSION_RADIUS - 50, &blasted);
+            for (size_t j = 0; j < body_ptr_array_size(&blasted); j++) {
+                body_t *body = body_ptr_array_get(&blasted, j);
                 vector_t body_position = body_get_centroid(body);
                 size_t* info = body_get_info(body);
 
                 if (vec_distance(explosion_center, body_position) <= EXPLOSION_RADIUS - 50
                     && *info != BIRD_ID && *info != PLAT_ID && *info != SLING_ID && *info != RUBBER_ID) {
                     // add explosion effect?
-                    scene_remove_body(state->scene, i);
+                    body_remove(body);
                 }
             }
-        } 
+        }
     }
+    body_ptr_array_free(&near_bird);
+    body_ptr_array_free(&blasted);
 
     // Reset the center of the rubberband after shooting 
     if (body_get_centroid(bird).x >= RUBBER_CENTER.x && state->return_press == true) {
         state->rubber_center->x = RUBBER_CENTER.x;
         state->rubber_center->y = RUBBER_CENTER.y;
 
-        list_t *rubberband = make_rubberband(state->scene, state->rubber_center);
-        body_t *rubber = get_body(state->scene, RUBBER_ID);
-        body_set_shape(rubber, rubberband);
+        vertex_array_t *rubberband = make_rubberband(state->scene, state->rubber_center);
+        body_t *rubber = scene_get_body_by_handle(state->scene, state->rubber);
+        body_set_vertices(rubber, rubberband);
     }
 }
 
@@ -330,16 +341,18 @@ void check_level(state_t *state) {
     size_t* rubber_id = malloc(sizeof(size_t));
     *rubber_id = RUBBER_ID;
 
-    list_t *rubberband = make_rubberband(state->scene, state->rubber_center);
-    body_t *rubberband_b = body_init_with_info(rubberband, INFINITY, RUBBER_COLOR, rubber_id, free);
+    vertex_array_t *rubberband = make_rubberband(state->scene, state->rubber_center);
+    body_t *rubberband_b = body_init_with_vertices(rubberband, INFINITY, RUBBER_COLOR, rubber_id, free);
+    body_set_tag(rubberband_b, *rubber_id);
 
     size_t* sling_id = malloc(sizeof(size_t));
     *sling_id =SLING_ID;
 
-    list_t *slingshot = make_slingshot();
-    body_t *slingshot_b = body_init_with_info(slingshot, INFINITY, SLINGSHOT_COLOR, sling_id, free);
+    vertex_array_t *slingshot = make_slingshot();
+    body_t *slingshot_b = body_init_with_vertices(slingshot, INFINITY, SLINGSHOT_COLOR, sling_id, free);
+    body_set_tag(slingshot_b, *sling_id);
 
-    scene_add_body(state->scene, rubberband_b);
+    state->rubber = scene_add_body(state->scene, rubberband_b);
     scene_add_body(state->scene, slingshot_b);
 }   
 
@@ -461,16 +474,7 @@ void on_key_press(char key, key_event_type_t type, double held_time,
                 check_level(state);
             }
         } else if (state->level_play && !state->passed) {
-            body_t *bird;
-
-            for (size_t i = 0; i < scene_bodies(state->scene); i++) {
-                size_t* info = body_get_info(scene_get_body(state->scene, i));
-
-                if (*info == BIRD_ID) {
-                    bird = scene_get_body(state->scene, i);
-                    break;
-                }
-            }
+            body_t *bird = scene_first_tag(state->scene, BIRD_ID);
 
             if (key == SPACEBAR && body_get_velocity(bird).y < 0) {
                 vector_t new_vel = vec_add(body_get_velocity(bird), vec_multiply(held_time, (vector_t) {ACCEL, -ACCEL}));
@@ -505,9 +509,9 @@ void on_key_press(char key, key_event_type_t type, double held_time,
                     create_downward_gravity(state->scene, GRAVITY_CONST, bird, GRAVITY_ID);
                     state->return_press = true;
                 }
-                list_t *rubberband = make_rubberband(state->scene, rubber_center);
-                body_t *rubber = get_body(state->scene, RUBBER_ID);
-                body_set_shape(rubber, rubberband);
+                vertex_array_t *rubberband = make_rubberband(state->scene, rubber_center);
+                body_t *rubber = scene_get_body_by_handle(state->scene, state->rubber);
+                body_set_vertices(rubber, rubberband);
 
                 if (state->remaining_birds > 0) {
                     body_set_centroid(bird, *(rubber_center));
@@ -546,13 +550,17 @@ void on_key_press(char key, key_event_type_t type, double held_time,
                     body_set_color(bird, white);
                     
                     // Define each of the split bodies
-                    list_t *split1 = make_circle(SPLIT_RAD);
-                    list_t *split2 = make_circle(SPLIT_RAD);
-                    list_t *split3 = make_circle(SPLIT_RAD);
-
-                    body_t *split1_b = body_init_with_info(split1, 1, BIRD_SPLIT_COLOR, bird_id, free);
-                    body_t *split2_b = body_init_with_info(split2, 1, BIRD_SPLIT_COLOR, bird_id, free);
-                    body_t *split3_b = body_init_with_info(split3, 1, BIRD_SPLIT_COLOR, bird_id, free);
+                    shape_t *split = circle_shape(SPLIT_RAD);
+
+                    body_t *split1_b = body_init_with_shape(split, 1, BIRD_SPLIT_COLOR, bird_id, free);
+                    body_set_tag(split1_b, *bird_id);
+                    body_set_collidable(split1_b, true);
+                    body_t *split2_b = body_init_with_shape(split, 1, BIRD_SPLIT_COLOR, bird_id, free);
+                    body_set_tag(split2_b, *bird_id);
+                    body_set_collidable(split2_b, true);
+                    body_t *split3_b = body_init_with_shape(split, 1, BIRD_SPLIT_COLOR, bird_id, free);
+                    body_set_tag(split3_b, *bird_id);
+                    body_set_collidable(split3_b, true);
                     
                     body_set_centroid(split1_b, centroid);
                     body_set_centroid(split2_b, centroid);
@@ -592,17 +600,22 @@ void on_key_press(char key, key_event_type_t type, double held_time,
                     body_set_color(bird, white);
                     body_set_velocity(bird, (vector_t) {25*ACCEL, 25*ACCEL}); 
 
-                    for (size_t i = 0; i < scene_bodies(state->scene); i++) {
-                        body_t *body = scene_get_body(state->scene, i);
+                    // Only bodies whose boxes reach the explosion can have their centroids in it
+                    body_ptr_array_t blasted;
+                    body_ptr_array_init(&blasted, 0);
+                    scene_query_radius(state->scene, explosion_center, EXPLOSION_RADIUS, &blasted);
+                    for (size_t i = 0; i < body_ptr_array_size(&blasted); i++) {
+                        body_t *body = body_ptr_array_get(&blasted, i);
                         vector_t body_position = body_get_centroid(body);
                         size_t* info = body_get_info(body);
 
                         if (vec_distance(explosion_center, body_position) <= EXPLOSION_RADIUS 
                             && *info != BIRD_ID && *info != PLAT_ID && *info != SLING_ID && *info != RUBBER_ID) {
                             // add explosion effect?
-                            scene_remove_body(state->scene, i);
+                            body_remove(body);
                         }
                     }
+                    body_ptr_array_free(&blasted);
                     make_collisions(state->scene, BIRD_ID);
                     free(white);
                 }
@@ -615,8 +628,9 @@ void on_key_press(char key, key_event_type_t type, double held_time,
                     size_t* egg_id = malloc(sizeof(size_t));
                     *egg_id = EGG_ID;
 
-                    list_t *egg = make_circle(7);
-                    body_t *egg_b = body_init_with_info(egg, 1, BIRD_EGG_COLOR, egg_id, free);
+                    body_t *egg_b = body_init_with_shape(circle_shape(7), 1, BIRD_EGG_COLOR, egg_id, free);
+                    body_set_tag(egg_b, *egg_id);
+                    body_set_collidable(egg_b, true);
                     body_set_centroid(egg_b, centroid);
                     scene_add_body(state->scene, egg_b);
 
@@ -642,20 +656,6 @@ void on_key_press(char key, key_event_type_t type, double held_time,
 
 /* SCORE */
 
-size_t count_same_bodies(scene_t *scene, size_t id) {
-    size_t curr = 0;
-
-    for (size_t i = 0; i < scene_bodies(scene); i++) {
-      body_t *body = scene_get_body(scene, i);
-      size_t* info = body_get_info(body);
-
-      if (*info == id) {
-        curr++;
-      }
-    }
-    return curr;
-}
-
 void calculate_score(state_t *state) {
   size_t factor = 1;
   double time_left = state->stop_clock - state->time;
@@ -664,7 +664,7 @@ void calculate_score(state_t *state) {
     printf("time left: %f\n", time_left);
   }
 
-  size_t curr_pigs = count_same_bodies(state->scene, PIG_ID);
+  size_t curr_pigs = scene_count_tag(state->scene, PIG_ID);
   if (curr_pigs < state->prev_pigs) {
       state->score += (state->prev_pigs - curr_pigs) * PIG_TOKENS * factor;
       printf("hit pig\n");
@@ -673,7 +673,7 @@ void calculate_score(state_t *state) {
   }
   state->prev_pigs = curr_pigs;
 
-  size_t curr_coins = count_same_bodies(state->scene, COIN_ID);
+  size_t curr_coins = scene_count_tag(state->scene, COIN_ID);
   if (curr_coins < state->prev_coins) {
     state->score += (state->prev_coins - curr_coins) * COIN_TOKENS * factor;
     printf("hit coin\n");
@@ -682,7 +682,7 @@ void calculate_score(state_t *state) {
   }
   state->prev_coins = curr_coins;
 
-  size_t curr_clocks = count_same_bodies(state->scene, CLOCK_ID);
+  size_t curr_clocks = scene_count_tag(state->scene, CLOCK_ID);
   if (curr_clocks < state->prev_clocks) {
     state->stop_clock = state->time + CLOCK_TIMER;
     printf("hit clock\n");
@@ -699,22 +699,17 @@ void center_and_forces(scene_t *scene, body_t *pop_up) {
   vector_t rand_center = {(rand() % (WINDOW_W - LEFT_SPAWN_LIMIT)) + LEFT_SPAWN_LIMIT, (rand() % WINDOW_H)};
   body_set_centroid(pop_up, rand_center);
 
-    for (size_t i = 0; i < scene_bodies(scene); i++) {
-        body_t *body = scene_get_body(scene, i);
-        size_t *info = body_get_info(body);
-
-        if (*info == BIRD_ID) {
-          create_destructive_collision2(scene, pop_up, body);
-        }
-    }
+  // Birds pop the pop up
+  create_tagged_destructive_collision2(scene, body_get_tag(pop_up), BIRD_ID);
 }
 
 void make_coin(scene_t *scene) {
   size_t* id = malloc(sizeof(size_t));
   *id = COIN_ID;
 
-  list_t *shape = make_circle(COIN_RADIUS);
-  body_t *coin = body_init_with_info(shape, COIN_MASS, COIN_COLOR, id, free);
+  body_t *coin = body_init_with_shape(circle_shape(COIN_RADIUS), COIN_MASS, COIN_COLOR, id, free);
+  body_set_tag(coin, *id);
+  body_set_collidable(coin, true);
   center_and_forces(scene, coin);
   scene_add_body(scene, coin);
 }
@@ -734,8 +729,9 @@ void make_clock(scene_t *scene) {
   size_t* id = malloc(sizeof(size_t));
   *id = CLOCK_ID;
 
-  list_t *shape = make_circle(CLOCK_RADIUS);
-  body_t *clock = body_init_with_info(shape, CLOCK_MASS, CLOCK_COLOR, id, free);
+  body_t *clock = body_init_with_shape(circle_shape(CLOCK_RADIUS), CLOCK_MASS, CLOCK_COLOR, id, free);
+  body_set_tag(clock, *id);
+  body_set_collidable(clock, true);
   center_and_forces(scene, clock);
   scene_add_body(scene, clock);
 }
@@ -812,6 +808,8 @@ state_t *emscripten_init() {
     
     state_t *state = malloc(sizeof(state_t));
     state->scene = scene_init();
+    // Platforms, walls and pigs stay put until they are hit
+    scene_set_broadphase(state->scene, SCENE_BROADPHASE_SWEEP);
     state->front_page = true;
     state->sequential = true;
     state->background = sdl_get_texture(make_path((char*)BACK_PATH));
@@ -897,7 +895,7 @@ void emscripten_main(state_t *state) {
     if (state->level_play && !state->failed) {
         // If we are in the middle of a game
         if (!state->passed) {
-            if (state->remaining_birds == 0 && count_same_bodies(state->scene, EGG_ID) == 0) {
+            if (state->remaining_birds == 0 && scene_count_tag(state->scene, EGG_ID) == 0) {
                 // Checks if game is over
                 if (state->prev_pigs > 0) {
                     state->failed = true;
@@ -997,6 +995,7 @@ void emscripten_main(state_t *state) {
 void emscripten_free(state_t *state) { 
     list_free(state->text);
     scene_free(state->scene);
+    body_free_pools();
     free(state->rubber_center);
     sdl_destroy_texture(state->background);
     free(state);
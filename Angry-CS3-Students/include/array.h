@@ -0,0 +1,140 @@
+#ifndef __ARRAY_H__
+#define __ARRAY_H__
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Bounds checks for the typed arrays below.
+ * These are assertions in debug builds and compile away when
+ * ARRAY_NO_BOUNDS_CHECK or NDEBUG is defined (e.g. 'make NO_ASAN=true'),
+ * so element access is a plain load the compiler can see through.
+ */
+#if defined(ARRAY_NO_BOUNDS_CHECK) || defined(NDEBUG)
+#define ARRAY_CHECK(cond) ((void)0)
+#else
+#define ARRAY_CHECK(cond) assert(cond)
+#endif
+
+/**
+ * Defines a growable array type holding elements of the given type by value,
+ * with static inline accessors.
+ * Unlike list_t, the element type is known to the compiler, so accesses can
+ * be inlined and vectorized instead of going through a void* function call.
+ *
+ * DEFINE_ARRAY(vec, vector_t) defines vec_array_t along with:
+ *   void vec_array_init(vec_array_t *array, size_t capacity);
+ *   void vec_array_free(vec_array_t *array);
+ *   size_t vec_array_size(const vec_array_t *array);
+ *   vector_t vec_array_get(const vec_array_t *array, size_t index);
+ *   vector_t *vec_array_at(vec_array_t *array, size_t index);
+ *   void vec_array_set(vec_array_t *array, size_t index, vector_t value);
+ *   void vec_array_reserve(vec_array_t *array, size_t capacity);
+ *   void vec_array_push(vec_array_t *array, vector_t value);
+ *   vector_t vec_array_pop(vec_array_t *array);
+ *   vector_t vec_array_remove(vec_array_t *array, size_t index);
+ *   vector_t vec_array_swap_remove(vec_array_t *array, size_t index);
+ *   void vec_array_truncate(vec_array_t *array, size_t size);
+ *
+ * The array struct itself is a value (usually embedded in another struct);
+ * init and free manage only its element storage.
+ * remove() preserves the order of the remaining elements;
+ * swap_remove() moves the last element into the gap in constant time.
+ * Out-of-range indices fail an ARRAY_CHECK.
+ */
+#define DEFINE_ARRAY(name, type)                                               \
+  typedef struct {                                                             \
+    type *data;                                                                \
+    size_t size;                                                               \
+    size_t capacity;                                                           \
+  } name##_array_t;                                                            \
+                                                                               \
+  static inline void name##_array_init(name##_array_t *array,                  \
+                                       size_t capacity) {                      \
+    array->size = 0;                                                           \
+    array->capacity = capacity;                                                \
+    array->data = NULL;                                                        \
+    if (capacity > 0) {                                                        \
+      array->data = malloc(sizeof(type) * capacity);                           \
+      assert(array->data != NULL);                                             \
+    }                                                                          \
+  }                                                                            \
+                                                                               \
+  static inline void name##_array_free(name##_array_t *array) {                \
+    free(array->data);                                                         \
+    array->data = NULL;                                                        \
+    array->size = 0;                                                           \
+    array->capacity = 0;                                                       \
+  }                                                                            \
+                                                                               \
+  static inline size_t name##_array_size(const name##_array_t *array) {        \
+    return array->size;                                                        \
+  }                                                                            \
+                                                                               \
+  static inline type name##_array_get(const name##_array_t *array,             \
+                                      size_t index) {                          \
+    ARRAY_CHECK(index < array->size);                                          \
+    return array->data[index];                                                 \
+  }                                                                            \
+                                                                               \
+  static inline type *name##_array_at(name##_array_t *array, size_t index) {   \
+    ARRAY_CHECK(index < array->size);                                          \
+    return &array->data[index];                                                \
+  }                                                                            \
+                                                                               \
+  static inline void name##_array_set(name##_array_t *array, size_t index,     \
+                                      type value) {                            \
+    ARRAY_CHECK(index < array->size);                                          \
+    array->data[index] = value;                                                \
+  }                                                                            \
+                                                                               \
+  static inline void name##_array_reserve(name##_array_t *array,               \
+                                          size_t capacity) {                   \
+    if (capacity > array->capacity) {                                          \
+      type *data = realloc(array->data, sizeof(type) * capacity);              \
+      assert(data != NULL);                                                    \
+      array->data = data;                                                      \
+      array->capacity = capacity;                                              \
+    }                                                                          \
+  }                                                                            \
+                                                                               \
+  static inline void name##_array_push(name##_array_t *array, type value) {    \
+    if (array->size == array->capacity) {                                      \
+      name##_array_reserve(array, array->capacity == 0 ? 4                     \
+                                                       : 2 * array->capacity); \
+    }                                                                          \
+    array->data[array->size++] = value;                                        \
+  }                                                                            \
+                                                                               \
+  static inline type name##_array_pop(name##_array_t *array) {                 \
+    ARRAY_CHECK(array->size > 0);                                              \
+    return array->data[--array->size];                                         \
+  }                                                                            \
+                                                                               \
+  static inline type name##_array_remove(name##_array_t *array,                \
+                                         size_t index) {                       \
+    ARRAY_CHECK(index < array->size);                                          \
+    type removed = array->data[index];                                         \
+    memmove(&array->data[index], &array->data[index + 1],                      \
+            sizeof(type) * (array->size - index - 1));                         \
+    array->size--;                                                             \
+    return removed;                                                            \
+  }                                                                            \
+                                                                               \
+  static inline type name##_array_swap_remove(name##_array_t *array,           \
+                                              size_t index) {                  \
+    ARRAY_CHECK(index < array->size);                                          \
+    type removed = array->data[index];                                         \
+    array->data[index] = array->data[--array->size];                           \
+    return removed;                                                            \
+  }                                                                            \
+                                                                               \
+  static inline void name##_array_truncate(name##_array_t *array,              \
+                                           size_t size) {                      \
+    ARRAY_CHECK(size <= array->size);                                          \
+    array->size = size;                                                        \
+  }
+
+#endif // #ifndef __ARRAY_H__
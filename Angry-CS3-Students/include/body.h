@@ -1,10 +1,16 @@
 #ifndef __BODY_H__
 #define __BODY_H__
 
+#include "array.h"
+#include "broadphase.h"
 #include "color.h"
 #include "list.h"
+#include "shape.h"
+#include "vec_batch.h"
 #include "vector.h"
+#include "vertex_array.h"
 #include <stdbool.h>
+#include <stdint.h>
 
 /**
  * A rigid body constrained to the plane.
@@ -14,11 +20,45 @@
  */
 typedef struct body body_t;
 
+/**
+ * A stable 32-bit reference to a body, which unlike a body_t * can be kept
+ * after the body is freed: body_from_handle() then returns NULL instead of
+ * a dangling pointer. Every body gets a handle when it is initialized.
+ */
+typedef uint32_t body_handle_t;
+
+/**
+ * A handle that never refers to a body.
+ */
+#define BODY_HANDLE_NONE ((body_handle_t)0)
+
+/**
+ * The tag of a body that has not been given one (see body_set_tag()).
+ */
+#define BODY_NO_TAG SIZE_MAX
+
+/**
+ * Tags must be less than this, since scenes index bodies by tag.
+ */
+#define BODY_MAX_TAGS 256
+
+/**
+ * Contiguous storage for the linear state of many bodies
+ * (see body_store_init()).
+ */
+typedef struct body_store body_store_t;
+
+/**
+ * A growable array of body pointers (see DEFINE_ARRAY() in array.h).
+ * Does not own the bodies it points to.
+ */
+DEFINE_ARRAY(body_ptr, body_t *)
+
 /**
  * Initializes a body without any info.
  * Acts like body_init_with_info() where info and info_freer are NULL.
  */
-body_t *body_init(list_t *shape, double mass, rgb_color_t color);
+body_t *body_init(list_t *shape, real_t mass, rgb_color_t color);
 
 /**
  * Allocates memory for a body with the given parameters.
@@ -33,11 +73,62 @@ body_t *body_init(list_t *shape, double mass, rgb_color_t color);
  * @param info_freer if non-NULL, a function call on the info to free it
  * @return a pointer to the newly allocated body
  */
-body_t *body_init_with_info(list_t *shape, double mass, rgb_color_t color,
+body_t *body_init_with_info(list_t *shape, real_t mass, rgb_color_t color,
                             void *info, free_func_t info_freer);
 
+/**
+ * Allocates memory for a body whose shape is a packed vertex array.
+ * This is the native form of body_init_with_info(); the list version copies
+ * its shape into a vertex array, frees the list, and calls this function.
+ *
+ * @param shape the vertices describing the initial shape of the body.
+ *   The body takes ownership of the array.
+ * @param mass the mass of the body (if INFINITY, stops the body from moving)
+ * @param color the color of the body, used to draw it on the screen
+ * @param info additional information to associate with the body
+ * @param info_freer if non-NULL, a function call on the info to free it
+ * @return a pointer to the newly allocated body
+ */
+body_t *body_init_with_vertices(vertex_array_t *shape, real_t mass,
+                                rgb_color_t color, void *info,
+                                free_func_t info_freer);
+
+/**
+ * Allocates memory for a body whose local-space shape is a shared shape,
+ * e.g. one from shape_intern(). Many bodies can use the same shape.
+ * The body starts with its centroid at the shape's local origin
+ * and an angle of 0.
+ *
+ * @param shape the body's shape. The body adds a reference to it.
+ * @param mass the mass of the body (if INFINITY, stops the body from moving)
+ * @param color the color of the body, used to draw it on the screen
+ * @param info additional information to associate with the body
+ * @param info_freer if non-NULL, a function call on the info to free it
+ * @return a pointer to the newly allocated body
+ */
+body_t *body_init_with_shape(shape_t *shape, real_t mass, rgb_color_t color,
+                             void *info, free_func_t info_freer);
+
+/**
+ * Replaces the shape of a body, freeing the old shape.
+ * The centroid is not recomputed, but the moment of inertia is.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param shape a list of vectors describing the new shape, which the body
+ *   takes ownership of
+ */
 void body_set_shape(body_t *body, list_t *shape);
 
+/**
+ * Replaces the shape of a body with a packed vertex array,
+ * freeing the old shape. The centroid is not recomputed,
+ * but the moment of inertia is.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param shape the new vertices, which the body takes ownership of
+ */
+void body_set_vertices(body_t *body, vertex_array_t *shape);
+
 /**
  * Releases the memory allocated for a body.
  *
@@ -45,15 +136,91 @@ void body_set_shape(body_t *body, list_t *shape);
  */
 void body_free(body_t *body);
 
+/**
+ * Releases the memory that every body is allocated from, and the table
+ * that handles are looked up in. Bodies are created outside of any scene,
+ * so this memory is shared by all of them and is not freed by scene_free().
+ * Programs should call this once they are done with bodies.
+ * Asserts that every body has been freed. Later calls to body_init() start
+ * afresh, so handles from before this call must not be used after it.
+ */
+void body_free_pools(void);
+
 /**
  * Gets the current shape of a body.
  * Returns a newly allocated vector list, which must be list_free()d.
+ * To read the shape without copying it, use body_shape_view().
  *
  * @param body a pointer to a body returned from body_init()
  * @return the polygon describing the body's current position
  */
 list_t *body_get_shape(body_t *body);
 
+/**
+ * Gets the current shape of a body as a packed vertex array.
+ * Returns a newly allocated copy, which must be vertex_array_free()d.
+ * Unlike body_get_shape(), this costs a single allocation.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the vertices describing the body's current position
+ */
+vertex_array_t *body_get_vertices(body_t *body);
+
+/**
+ * Gets a read-only view of the current shape of a body, without copying it.
+ * Prefer this to body_get_shape() and body_get_vertices() when the shape
+ * is only read, e.g. for collision checks and drawing.
+ * The body stores its shape in local space, relative to its centroid, and
+ * moving or rotating it only updates its position and angle; the world-space
+ * vertices are recomputed here, the first time they are needed afterwards.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the vertices describing the body's current position, owned by the
+ *   body and valid until it is next moved, rotated, reshaped or freed
+ */
+const vertex_array_t *body_shape_view(body_t *body);
+
+/**
+ * Gets a bounding box of the current shape of a body, in constant time.
+ * The box is the shape's own bounding box, turned with the body and boxed
+ * again, so it is only recomputed when the body rotates or is reshaped,
+ * and the world-space vertices are never needed.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return a box containing the body's current shape; the smallest such
+ *   box when the body is unrotated or turned by a multiple of 90 degrees
+ */
+aabb_t body_get_bounds(body_t *body);
+
+/**
+ * Gets the radius of a circle about a body's centroid that contains it.
+ * Unlike the bounding box, this does not change as the body moves or rotates.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the distance from the centroid to the body's farthest vertex
+ */
+real_t body_get_radius(body_t *body);
+
+/**
+ * Gets the candidate separating axes of the current shape of a body:
+ * the shape's axes (see shape_t) rotated by the body's angle.
+ * They are only recomputed after the body rotates or is reshaped, and a
+ * body that has never been rotated uses its shape's own axes.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the unit axes, owned by the body or its shape and valid until
+ *   the body is next rotated, reshaped or freed
+ */
+const vertex_array_t *body_axes_view(body_t *body);
+
+/**
+ * Gets the local-space shape of a body, which may be shared with others.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the body's shape, valid until the body is reshaped or freed
+ */
+const shape_t *body_get_local_shape(body_t *body);
+
 /**
  * Gets the current center of mass of a body.
  * While this could be calculated with polygon_centroid(), that becomes too slow
@@ -79,7 +246,18 @@ vector_t body_get_velocity(body_t *body);
  * @param body a pointer to a body returned from body_init()
  * @return the mass passed to body_init(), which must be greater than 0
  */
-double body_get_mass(body_t *body);
+real_t body_get_mass(body_t *body);
+
+/**
+ * Gets the moment of inertia of a body about its centroid,
+ * treating it as a polygon of uniform density.
+ * The shape's mass properties are computed once, when the shape is set,
+ * so this does not walk the vertices.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the body's moment of inertia (INFINITY if its mass is infinite)
+ */
+real_t body_get_inertia(body_t *body);
 
 /**
  * Gets the display color of a body.
@@ -120,7 +298,7 @@ void body_set_centroid(body_t *body, vector_t x);
  * @param body a pointer to a body returned from body_init()
  * @param mass the body's new mass
  */
-void body_set_mass(body_t *body, double mass);
+void body_set_mass(body_t *body, real_t mass);
 
 /**
  * Changes a body's velocity (the time-derivative of its position).
@@ -138,7 +316,7 @@ void body_set_velocity(body_t *body, vector_t v);
  * @param body a pointer to a body returned from body_init()
  * @param angle the body's new angle in radians. Positive is counterclockwise.
  */
-void body_set_rotation(body_t *body, double angle);
+void body_set_rotation(body_t *body, real_t angle);
 
 /* 
  * Changes the color of a body
@@ -203,4 +381,139 @@ void body_remove(body_t *body);
  */
 bool body_is_removed(body_t *body);
 
+/**
+ * Sets the type tag of a body, e.g. whether it is a bird or a pig,
+ * which scenes use to count and find bodies of a type in constant time
+ * (see scene_count_tag()).
+ * A scene indexes a body by the tag it has when it is added,
+ * so tag bodies before adding them to a scene.
+ * Asserts that the tag is less than BODY_MAX_TAGS.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param tag the body's type
+ */
+void body_set_tag(body_t *body, size_t tag);
+
+/**
+ * Gets the type tag of a body.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the tag passed to body_set_tag(), or BODY_NO_TAG if there was none
+ */
+size_t body_get_tag(body_t *body);
+
+/**
+ * Sets whether a body takes part in its scene's collision stage
+ * (see scene_add_collision_handler()). Its shape is used to test
+ * it against other collidable bodies. Bodies are not collidable
+ * until this is called.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param collidable whether the body should collide
+ */
+void body_set_collidable(body_t *body, bool collidable);
+
+/**
+ * Gets whether a body takes part in its scene's collision stage.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the value passed to body_set_collidable(), or false
+ */
+bool body_is_collidable(body_t *body);
+
+/**
+ * Gets a body's handle.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the handle, which stays the same for the body's whole life
+ */
+body_handle_t body_get_handle(body_t *body);
+
+/**
+ * Gets the body a handle refers to, in constant time.
+ *
+ * @param handle a handle from body_get_handle(), or BODY_HANDLE_NONE
+ * @return the body, or NULL if it has been freed
+ */
+body_t *body_from_handle(body_handle_t handle);
+
+/**
+ * Gets the slot of a handle in the table of handles.
+ * No two live bodies share a slot, and slots are reused as bodies are freed,
+ * so they stay below the largest number of bodies alive at once.
+ * Lets other modules keep per-body data in an array indexed by slot.
+ *
+ * @param handle a handle from body_get_handle()
+ * @return the handle's slot
+ */
+size_t body_handle_slot(body_handle_t handle);
+
+/**
+ * Allocates an empty body store.
+ * A store keeps the position, velocity, force, impulse and inverse mass of
+ * the bodies added to it in structure-of-arrays form (see particle_arrays_t),
+ * so that body_store_tick() can integrate all of them with one batched kernel
+ * instead of visiting each body in turn.
+ * Stored bodies are used exactly like any other; their accessors simply read
+ * and write the store.
+ *
+ * @param capacity the number of bodies to allocate space for.
+ *   The store grows as needed.
+ * @return the new store
+ */
+body_store_t *body_store_init(size_t capacity);
+
+/**
+ * Releases a store. Any bodies still in it are removed from it first,
+ * but not freed.
+ *
+ * @param store a pointer to a store returned from body_store_init()
+ */
+void body_store_free(body_store_t *store);
+
+/**
+ * Gets the number of bodies in a store.
+ *
+ * @param store a pointer to a store returned from body_store_init()
+ * @return the number of bodies added and not yet removed or freed
+ */
+size_t body_store_size(body_store_t *store);
+
+/**
+ * Gets the number of bodies in a store that are marked for removal,
+ * without visiting the bodies.
+ *
+ * @param store a pointer to a store returned from body_store_init()
+ * @return the number of stored bodies for which body_is_removed() is true
+ */
+size_t body_store_removed(body_store_t *store);
+
+/**
+ * Moves a body's linear state into a store.
+ * Asserts that the body is not already in a store.
+ *
+ * @param store a pointer to a store returned from body_store_init()
+ * @param body the body to add
+ */
+void body_store_add(body_store_t *store, body_t *body);
+
+/**
+ * Moves a body's linear state back out of its store.
+ * body_free() does this automatically.
+ * Asserts that the body is in the store.
+ *
+ * @param store the store the body was added to
+ * @param body the body to remove
+ */
+void body_store_remove(body_store_t *store, body_t *body);
+
+/**
+ * Ticks every body in a store, with the same result as calling body_tick()
+ * on each of them, including any that are marked for removal.
+ *
+ * @param store a pointer to a store returned from body_store_init()
+ * @param dt the number of seconds elapsed since the last tick
+ */
+void body_store_tick(body_store_t *store, double dt);
+
 #endif // #ifndef __BODY_H__
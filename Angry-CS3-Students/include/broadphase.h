@@ -0,0 +1,307 @@
+#ifndef __BROADPHASE_H__
+#define __BROADPHASE_H__
+
+#include "array.h"
+#include "vector.h"
+#include "vertex_array.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * An axis-aligned bounding box.
+ */
+typedef struct {
+  vector_t min;
+  vector_t max;
+} aabb_t;
+
+/**
+ * A pair of boxes that may be colliding,
+ * given by their indices in the array of boxes, with first < second.
+ */
+typedef struct {
+  size_t first;
+  size_t second;
+} box_pair_t;
+
+DEFINE_ARRAY(aabb, aabb_t)
+DEFINE_ARRAY(box_pair, box_pair_t)
+DEFINE_ARRAY(proxy, size_t)
+
+/**
+ * Computes the smallest box containing a polygon.
+ * Asserts that the polygon has at least one vertex.
+ *
+ * @param vertices the polygon's vertices
+ * @return the polygon's bounding box
+ */
+aabb_t aabb_of(const vertex_array_t *vertices);
+
+/**
+ * Determines whether two boxes overlap. Boxes that only touch overlap.
+ *
+ * @param box1 the first box
+ * @param box2 the second box
+ * @return whether the boxes have a point in common
+ */
+bool aabb_overlap(aabb_t box1, aabb_t box2);
+
+/**
+ * A uniform grid that finds the pairs of overlapping boxes
+ * without testing every pair.
+ * Each box is entered in every square cell it covers, and only boxes
+ * that share a cell are tested against each other, so the work grows
+ * with the number of boxes that are actually close together.
+ * Cells are found by hashing, so the grid covers the whole plane.
+ */
+typedef struct grid grid_t;
+
+/**
+ * Allocates memory for an empty grid.
+ * The cell size should be around the size of a typical box;
+ * boxes that cover very many cells are tested against every box instead.
+ * Asserts that the cell size is positive.
+ *
+ * @param cell_size the width and height of each cell
+ * @return a pointer to the newly allocated grid
+ */
+grid_t *grid_init(real_t cell_size);
+
+/**
+ * Releases the memory allocated for a grid.
+ *
+ * @param grid a pointer to a grid returned from grid_init()
+ */
+void grid_free(grid_t *grid);
+
+/**
+ * Finds every pair of overlapping boxes.
+ * The grid keeps no boxes between calls; it only reuses its memory.
+ *
+ * @param grid a pointer to a grid returned from grid_init()
+ * @param boxes the boxes to test
+ * @param n_boxes the number of boxes
+ * @param pairs an array that is replaced with the overlapping pairs,
+ *   each once, sorted by first and then by second index
+ */
+void grid_find_pairs(grid_t *grid, const aabb_t *boxes, size_t n_boxes,
+                     box_pair_array_t *pairs);
+
+/**
+ * A sweep-and-prune broadphase that keeps track of which of its boxes
+ * overlap from one update to the next.
+ * The ends of the boxes are kept sorted along both axes, and each update
+ * re-sorts them with an insertion sort. Boxes that barely move only swap
+ * places with a few neighbors, so an update takes close to linear time,
+ * and only the pairs that start or stop overlapping are reported.
+ * Suits scenes where most bodies are still or slow.
+ *
+ * Boxes are added as proxies, identified by small integers that are
+ * reused once a removed proxy's pairs have been reported.
+ */
+typedef struct sweep sweep_t;
+
+/**
+ * Allocates memory for a sweep with no boxes.
+ *
+ * @return a pointer to the newly allocated sweep
+ */
+sweep_t *sweep_init(void);
+
+/**
+ * Releases the memory allocated for a sweep.
+ *
+ * @param sweep a pointer to a sweep returned from sweep_init()
+ */
+void sweep_free(sweep_t *sweep);
+
+/**
+ * Adds a box to a sweep.
+ * Its pairs are found by the next sweep_update().
+ *
+ * @param sweep a pointer to a sweep returned from sweep_init()
+ * @param box the box
+ * @return the box's proxy
+ */
+size_t sweep_add(sweep_t *sweep, aabb_t box);
+
+/**
+ * Moves a box in a sweep.
+ * Its pairs are updated by the next sweep_update().
+ * Asserts that the proxy is in the sweep.
+ *
+ * @param sweep a pointer to a sweep returned from sweep_init()
+ * @param proxy the proxy returned by sweep_add()
+ * @param box the box's new bounds
+ */
+void sweep_move(sweep_t *sweep, size_t proxy, aabb_t box);
+
+/**
+ * Removes a box from a sweep.
+ * Its pairs are reported as removed by the next sweep_update().
+ * Asserts that the proxy is in the sweep.
+ *
+ * @param sweep a pointer to a sweep returned from sweep_init()
+ * @param proxy the proxy returned by sweep_add()
+ */
+void sweep_remove(sweep_t *sweep, size_t proxy);
+
+/**
+ * Brings a sweep up to date with the boxes added, moved and removed since
+ * the last update, and reports how its overlapping pairs changed.
+ * A pair that started and stopped overlapping in between is not reported.
+ *
+ * @param sweep a pointer to a sweep returned from sweep_init()
+ * @param added an array that is replaced with the pairs of proxies that
+ *   started overlapping, sorted as in grid_find_pairs()
+ * @param removed an array that is replaced with the pairs of proxies that
+ *   stopped overlapping or had a box removed, sorted the same way
+ */
+void sweep_update(sweep_t *sweep, box_pair_array_t *added,
+                  box_pair_array_t *removed);
+
+/**
+ * Gets the number of overlapping pairs a sweep knows of.
+ *
+ * @param sweep a pointer to a sweep returned from sweep_init()
+ * @return the number of pairs of proxies that overlapped at the last
+ *   sweep_update(), less any with a box removed since
+ */
+size_t sweep_pairs(sweep_t *sweep);
+
+/**
+ * A dynamic bounding volume tree: a balanced binary tree of boxes in which
+ * each box contains its children's, so that finding the boxes near a point
+ * or region only visits a few branches.
+ * Each box is stored enlarged by a margin (a "fat" box), so a box that
+ * moves a little stays inside its fat box and the tree does not change.
+ * Boxes that leave their fat box are taken out and inserted again, and the
+ * tree is rebalanced with rotations as boxes are inserted and removed.
+ *
+ * Boxes are added as proxies, identified by small integers that are
+ * reused once the box is removed. Each carries a pointer for the caller.
+ * Queries are exact: they test the boxes as given, not the fat boxes.
+ */
+typedef struct aabb_tree aabb_tree_t;
+
+/**
+ * Allocates memory for an empty tree.
+ * Asserts that the margin is not negative.
+ *
+ * @param margin how far the stored boxes extend past the real ones
+ * @return a pointer to the newly allocated tree
+ */
+aabb_tree_t *aabb_tree_init(real_t margin);
+
+/**
+ * Releases the memory allocated for a tree.
+ *
+ * @param tree a pointer to a tree returned from aabb_tree_init()
+ */
+void aabb_tree_free(aabb_tree_t *tree);
+
+/**
+ * Adds a box to a tree.
+ *
+ * @param tree a pointer to a tree returned from aabb_tree_init()
+ * @param box the box
+ * @param data a pointer to keep with the box, e.g. the body it bounds
+ * @return the box's proxy
+ */
+size_t aabb_tree_insert(aabb_tree_t *tree, aabb_t box, void *data);
+
+/**
+ * Removes a box from a tree.
+ * Asserts that the proxy is in the tree.
+ *
+ * @param tree a pointer to a tree returned from aabb_tree_init()
+ * @param proxy the proxy returned by aabb_tree_insert()
+ */
+void aabb_tree_remove(aabb_tree_t *tree, size_t proxy);
+
+/**
+ * Moves a box in a tree.
+ * Asserts that the proxy is in the tree.
+ *
+ * @param tree a pointer to a tree returned from aabb_tree_init()
+ * @param proxy the proxy returned by aabb_tree_insert()
+ * @param box the box's new bounds
+ * @return whether the box left its fat box and was inserted again
+ */
+bool aabb_tree_move(aabb_tree_t *tree, size_t proxy, aabb_t box);
+
+/**
+ * Gets the pointer kept with a box.
+ * Asserts that the proxy is in the tree.
+ *
+ * @param tree a pointer to a tree returned from aabb_tree_init()
+ * @param proxy the proxy returned by aabb_tree_insert()
+ * @return the data passed to aabb_tree_insert()
+ */
+void *aabb_tree_data(aabb_tree_t *tree, size_t proxy);
+
+/**
+ * Gets the height of a tree, which stays logarithmic in the number of boxes.
+ *
+ * @param tree a pointer to a tree returned from aabb_tree_init()
+ * @return the number of boxes on the longest path from the root to a box,
+ *   or 0 if the tree is empty
+ */
+size_t aabb_tree_height(aabb_tree_t *tree);
+
+/**
+ * Finds the boxes in a tree that overlap a box.
+ *
+ * @param tree a pointer to a tree returned from aabb_tree_init()
+ * @param box the box to look in
+ * @param proxies an array that is replaced with the proxies of the boxes,
+ *   in no particular order
+ */
+void aabb_tree_query_box(aabb_tree_t *tree, aabb_t box,
+                         proxy_array_t *proxies);
+
+/**
+ * Finds the boxes in a tree that contain a point.
+ *
+ * @param tree a pointer to a tree returned from aabb_tree_init()
+ * @param point the point
+ * @param proxies an array that is replaced with the proxies of the boxes,
+ *   in no particular order
+ */
+void aabb_tree_query_point(aabb_tree_t *tree, vector_t point,
+                           proxy_array_t *proxies);
+
+/**
+ * Finds the boxes in a tree that come within a distance of a point.
+ *
+ * @param tree a pointer to a tree returned from aabb_tree_init()
+ * @param center the point
+ * @param radius the distance
+ * @param proxies an array that is replaced with the proxies of the boxes,
+ *   in no particular order
+ */
+void aabb_tree_query_radius(aabb_tree_t *tree, vector_t center, real_t radius,
+                            proxy_array_t *proxies);
+
+/**
+ * Finds the boxes in a tree that a line segment passes through.
+ *
+ * @param tree a pointer to a tree returned from aabb_tree_init()
+ * @param from the start of the segment
+ * @param to the end of the segment
+ * @param proxies an array that is replaced with the proxies of the boxes,
+ *   in the order the segment enters them
+ */
+void aabb_tree_query_ray(aabb_tree_t *tree, vector_t from, vector_t to,
+                         proxy_array_t *proxies);
+
+/**
+ * Finds every pair of overlapping boxes in a tree.
+ *
+ * @param tree a pointer to a tree returned from aabb_tree_init()
+ * @param pairs an array that is replaced with the pairs of proxies,
+ *   sorted as in grid_find_pairs()
+ */
+void aabb_tree_find_pairs(aabb_tree_t *tree, box_pair_array_t *pairs);
+
+#endif // #ifndef __BROADPHASE_H__
@@ -2,8 +2,10 @@
 #define __COLLISION_H__
 
 #include <stdbool.h>
+#include "body.h"
 #include "list.h"
 #include "vector.h"
+#include "vertex_array.h"
 
 /**
  * Represents the status of a collision between two shapes.
@@ -34,4 +36,37 @@ typedef struct {
  */
 collision_info_t find_collision(list_t *shape1, list_t *shape2);
 
+/**
+ * Computes the status of the collision between two convex polygons
+ * stored as packed vertex arrays.
+ * This is the native form of find_collision(); the list version copies its
+ * shapes into vertex arrays and calls this function.
+ *
+ * @param shape1 the first shape
+ * @param shape2 the second shape
+ * @return whether the shapes are colliding, and if so, the collision axis.
+ * The axis should be a unit vector pointing from shape1 towards shape2.
+ */
+collision_info_t find_collision_array(const vertex_array_t *shape1,
+                                      const vertex_array_t *shape2);
+
+/**
+ * Computes the status of the collision between two bodies.
+ * Bodies far apart are ruled out by their bounding circles and then their
+ * bounding boxes (see body_get_radius() and body_get_bounds()), which is
+ * much cheaper than find_collision_array(), so this should be preferred
+ * when most of the pairs tested are not touching.
+ * The remaining pairs are tested on the bodies' precomputed axes
+ * (see body_axes_view()), with no allocation. With PHYSICS_FIXED they are
+ * tested by find_collision_array() instead, so that both give the same
+ * result bit for bit.
+ *
+ * @param body1 the first body
+ * @param body2 the second body
+ * @return whether the bodies are colliding, and if so, the collision axis,
+ *   as from find_collision_array() on the bodies' current shapes up to
+ *   rounding; of two parallel edges, only the first's normal is an axis
+ */
+collision_info_t find_collision_bodies(body_t *body1, body_t *body2);
+
 #endif // #ifndef __COLLISION_H__
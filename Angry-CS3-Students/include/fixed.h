@@ -0,0 +1,215 @@
+#ifndef __FIXED_H__
+#define __FIXED_H__
+
+#include <assert.h>
+#include <stdint.h>
+
+/**
+ * Q32.32 fixed-point numbers, used by the deterministic physics mode.
+ *
+ * Building with -DPHYSICS_FIXED (or 'make PHYSICS_FIXED=1') runs body_tick(),
+ * find_collision() and handler_physics_collision() in fixed point.
+ * Integer arithmetic gives the same bits on every compiler and target,
+ * including Emscripten, so a replayed shot ends in exactly the same state.
+ * The public API still takes and returns vector_t; values are converted at
+ * the boundary. Any Q32.32 value under 2^21 in magnitude is exactly
+ * representable as a double, so for scene-sized quantities the conversion
+ * back to double loses nothing.
+ *
+ * Every operation here rounds to nearest, with ties away from zero.
+ */
+typedef int64_t fixed_t;
+
+/**
+ * A 2-dimensional vector of fixed-point numbers.
+ */
+typedef struct {
+  fixed_t x;
+  fixed_t y;
+} fixed_vector_t;
+
+#define FIXED_FRAC_BITS 32
+#define FIXED_ONE ((fixed_t)1 << FIXED_FRAC_BITS)
+#define FIXED_MAX INT64_MAX
+
+/**
+ * Converts a double to fixed point.
+ * Asserts that the value is in range, i.e. less than 2^31 in magnitude.
+ *
+ * @param x the value to convert
+ * @return the nearest fixed-point value
+ */
+static inline fixed_t fixed_from_double(double x) {
+  // Scaling by a power of two is exact
+  double scaled = x * (double)FIXED_ONE;
+  assert(scaled > -9.2e18 && scaled < 9.2e18);
+  return (fixed_t)(scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+}
+
+/**
+ * Converts a fixed-point number to a double.
+ * This is exact when the value is less than 2^21 in magnitude.
+ *
+ * @param x the value to convert
+ * @return x as a double
+ */
+static inline double fixed_to_double(fixed_t x) {
+  return (double)x / (double)FIXED_ONE;
+}
+
+/**
+ * Multiplies two fixed-point numbers.
+ * The 128-bit product is built from 32-bit halves so that no target needs
+ * a 128-bit integer type.
+ *
+ * @param a the first factor
+ * @param b the second factor
+ * @return a * b
+ */
+static inline fixed_t fixed_mul(fixed_t a, fixed_t b) {
+  int negative = (a < 0) != (b < 0);
+  uint64_t ua = a < 0 ? -(uint64_t)a : (uint64_t)a;
+  uint64_t ub = b < 0 ? -(uint64_t)b : (uint64_t)b;
+  uint64_t a_hi = ua >> 32, a_lo = ua & 0xFFFFFFFFu;
+  uint64_t b_hi = ub >> 32, b_lo = ub & 0xFFFFFFFFu;
+  uint64_t product = ((a_hi * b_hi) << 32) + a_hi * b_lo + a_lo * b_hi +
+                     ((a_lo * b_lo + ((uint64_t)1 << 31)) >> 32);
+  return negative ? -(fixed_t)product : (fixed_t)product;
+}
+
+/**
+ * Divides two fixed-point numbers, by long division one bit at a time.
+ * Asserts that the divisor is nonzero.
+ *
+ * @param a the dividend
+ * @param b the divisor
+ * @return a / b
+ */
+static inline fixed_t fixed_div(fixed_t a, fixed_t b) {
+  assert(b != 0);
+  int negative = (a < 0) != (b < 0);
+  uint64_t ua = a < 0 ? -(uint64_t)a : (uint64_t)a;
+  uint64_t ub = b < 0 ? -(uint64_t)b : (uint64_t)b;
+  uint64_t quotient = ua / ub;
+  uint64_t remainder = ua % ub;
+  // One extra bit past the fraction for rounding
+  for (int i = 0; i <= FIXED_FRAC_BITS; i++) {
+    remainder <<= 1;
+    quotient <<= 1;
+    if (remainder >= ub) {
+      remainder -= ub;
+      quotient |= 1;
+    }
+  }
+  quotient = (quotient + 1) >> 1;
+  return negative ? -(fixed_t)quotient : (fixed_t)quotient;
+}
+
+/**
+ * Computes the square root of a fixed-point number, digit by digit.
+ * The result is rounded down. Asserts that x is not negative.
+ *
+ * @param x the value
+ * @return sqrt(x)
+ */
+static inline fixed_t fixed_sqrt(fixed_t x) {
+  assert(x >= 0);
+  // sqrt(x / 2^32) * 2^32 = sqrt(x * 2^32), so take the integer square root
+  // of the 96-bit number x followed by 32 zero bits, two bits at a time
+  uint64_t remainder = 0, root = 0;
+  for (int i = 0; i < 48; i++) {
+    uint64_t pair = i < 32 ? ((uint64_t)x >> (62 - 2 * i)) & 3 : 0;
+    remainder = (remainder << 2) | pair;
+    uint64_t trial = (root << 2) | 1;
+    root <<= 1;
+    if (remainder >= trial) {
+      remainder -= trial;
+      root |= 1;
+    }
+  }
+  return (fixed_t)root;
+}
+
+/**
+ * Computes the sine and cosine of a fixed-point angle.
+ * Like fast_sincos(), the angle is reduced around the nearest multiple of
+ * pi/2 and Taylor polynomials are evaluated on the rest.
+ * Accurate to a few units in the last place for angles of moderate size.
+ *
+ * @param angle the angle in radians
+ * @param sin_out where to store sin(angle)
+ * @param cos_out where to store cos(angle)
+ */
+static inline void fixed_sincos(fixed_t angle, fixed_t *sin_out,
+                                fixed_t *cos_out) {
+  // pi/2 is PIO2_HI + PIO2_LO / 2^32, to 64 fractional bits
+  const fixed_t PIO2_HI = 6746518852LL;
+  const fixed_t PIO2_LO = 1121027178LL;
+  const fixed_t TWO_OVER_PI = 2734261102LL;
+  // 1 / n! for n = 0..12
+  const fixed_t INV_FACT[] = {FIXED_ONE, FIXED_ONE, 2147483648LL,
+                              715827883LL, 178956971LL, 35791394LL,
+                              5965232LL, 852176LL, 106522LL, 11836LL,
+                              1184LL, 108LL, 9LL};
+
+  fixed_t q = fixed_mul(angle, TWO_OVER_PI);
+  int64_t k = (q + (FIXED_ONE >> 1)) >> FIXED_FRAC_BITS;
+  fixed_t r = angle - k * PIO2_HI -
+              ((k * PIO2_LO + (1LL << 31)) >> 32);
+  fixed_t r2 = fixed_mul(r, r);
+
+  // s = r (1 - r^2/3! + ... - r^10/11!), c = 1 - r^2/2! + ... + r^12/12!
+  fixed_t s = INV_FACT[11];
+  for (int n = 9; n >= 1; n -= 2) {
+    s = INV_FACT[n] - fixed_mul(r2, s);
+  }
+  s = fixed_mul(r, s);
+  fixed_t c = INV_FACT[12];
+  for (int n = 10; n >= 0; n -= 2) {
+    c = INV_FACT[n] - fixed_mul(r2, c);
+  }
+
+  switch (k & 3) {
+  case 0:
+    *sin_out = s;
+    *cos_out = c;
+    break;
+  case 1:
+    *sin_out = c;
+    *cos_out = -s;
+    break;
+  case 2:
+    *sin_out = -s;
+    *cos_out = -c;
+    break;
+  default:
+    *sin_out = -c;
+    *cos_out = s;
+    break;
+  }
+}
+
+static inline fixed_vector_t fixed_vec_from(double x, double y) {
+  return (fixed_vector_t){fixed_from_double(x), fixed_from_double(y)};
+}
+
+static inline fixed_vector_t fixed_vec_add(fixed_vector_t v1,
+                                           fixed_vector_t v2) {
+  return (fixed_vector_t){v1.x + v2.x, v1.y + v2.y};
+}
+
+static inline fixed_vector_t fixed_vec_subtract(fixed_vector_t v1,
+                                                fixed_vector_t v2) {
+  return (fixed_vector_t){v1.x - v2.x, v1.y - v2.y};
+}
+
+static inline fixed_vector_t fixed_vec_multiply(fixed_t scalar,
+                                                fixed_vector_t v) {
+  return (fixed_vector_t){fixed_mul(scalar, v.x), fixed_mul(scalar, v.y)};
+}
+
+static inline fixed_t fixed_vec_dot(fixed_vector_t v1, fixed_vector_t v2) {
+  return fixed_mul(v1.x, v2.x) + fixed_mul(v1.y, v2.y);
+}
+
+#endif // #ifndef __FIXED_H__
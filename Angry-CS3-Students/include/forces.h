@@ -3,17 +3,6 @@
 
 #include "scene.h"
 
-/**
- * A function called when a collision occurs.
- * @param body1 the first body passed to create_collision()
- * @param body2 the second body passed to create_collision()
- * @param axis a unit vector pointing from body1 towards body2
- *   that defines the direction the two bodies are colliding in
- * @param aux the auxiliary value passed to create_collision()
- */
-typedef void (*collision_handler_t)(body_t *body1, body_t *body2, vector_t axis,
-                                    void *aux);
-
 /**
  * Adds a force creator to a scene that applies gravity between two bodies.
  * The force creator will be called each tick
@@ -28,12 +17,32 @@ typedef void (*collision_handler_t)(body_t *body1, body_t *body2, vector_t axis,
  * @param body1 the first body
  * @param body2 the second body
  */
-void create_newtonian_gravity(scene_t *scene, double G, body_t *body1,
+void create_newtonian_gravity(scene_t *scene, real_t G, body_t *body1,
                               body_t *body2);
 
-void create_downward_gravity (scene_t *scene, double g, body_t *body, size_t id);
+/**
+ * Adds a force creator to a scene that pulls a body down with a constant
+ * acceleration. Adding gravity to a body again with the same id replaces
+ * the earlier force instead of adding to it.
+ *
+ * @param scene the scene containing the body
+ * @param g the acceleration due to gravity
+ * @param body the body to pull down
+ * @param id the id of the force creator
+ */
+void create_downward_gravity (scene_t *scene, real_t g, body_t *body, size_t id);
 
-void create_horizontal_friction(scene_t *scene, double friction, body_t *body1, size_t id);
+/**
+ * Adds a force creator to a scene that slows a body's horizontal motion
+ * in proportion to its horizontal velocity. Like create_downward_gravity(),
+ * adding it to a body again with the same id replaces the earlier force.
+ *
+ * @param scene the scene containing the body
+ * @param friction the friction constant
+ * @param body1 the body to slow down
+ * @param id the id of the force creator
+ */
+void create_horizontal_friction(scene_t *scene, real_t friction, body_t *body1, size_t id);
 
 /**
  * Adds a force creator to a scene that acts like a spring between two bodies.
@@ -46,7 +55,7 @@ void create_horizontal_friction(scene_t *scene, double friction, body_t *body1,
  * @param body1 the first body
  * @param body2 the second body
  */
-void create_spring(scene_t *scene, double k, body_t *body1, body_t *body2);
+void create_spring(scene_t *scene, real_t k, body_t *body1, body_t *body2);
 
 /**
  * Adds a force creator to a scene that applies a drag force on a body.
@@ -59,15 +68,18 @@ void create_spring(scene_t *scene, double k, body_t *body1, body_t *body2);
  *   (higher gamma means more drag)
  * @param body the body to slow down
  */
-void create_drag(scene_t *scene, double gamma, body_t *body);
+void create_drag(scene_t *scene, real_t gamma, body_t *body);
 
 /**
- * Adds a force creator to a scene that calls a given collision handler
- * function each time two bodies collide.
+ * Registers a collision handler with a scene that is called each time
+ * two bodies collide.
  * This generalizes create_destructive_collision() from last week,
  * allowing different things to happen on a collision.
  * The handler is passed the bodies, the collision axis, and an auxiliary value.
  * It should only be called once while the bodies are still colliding.
+ * The scene's collision stage only tests the pair while their bounding
+ * boxes overlap, rather than every tick
+ * (see scene_add_pair_collision_handler()).
  *
  * @param scene the scene containing the bodies
  * @param body1 the first body
@@ -81,7 +93,8 @@ void create_collision(scene_t *scene, body_t *body1, body_t *body2,
                       free_func_t freer);
 
 /**
- * Adds a force creator to a scene that destroys two bodies when they collide.
+ * Adds a collision handler to a scene that destroys two bodies when they
+ * collide.
  * The bodies should be destroyed by calling body_remove().
  * This should be represented as an on-collision callback
  * registered with create_collision().
@@ -96,7 +109,7 @@ void create_destructive_collision2(scene_t *scene, body_t *body1,
                                    body_t *body2);
 
 /**
- * Adds a force creator to a scene that applies impulses
+ * Adds a collision handler to a scene that applies impulses
  * to resolve collisions between two bodies in the scene.
  * This should be represented as an on-collision callback
  * registered with create_collision().
@@ -112,7 +125,34 @@ void create_destructive_collision2(scene_t *scene, body_t *body1,
  * @param body1 the first body
  * @param body2 the second body
  */
-void create_physics_collision(scene_t *scene, double elasticity, body_t *body1,
+void create_physics_collision(scene_t *scene, real_t elasticity, body_t *body1,
                               body_t *body2);
 
+/**
+ * Makes a scene's collision stage apply impulses to resolve collisions
+ * between collidable bodies with two tags, as create_physics_collision()
+ * does for one pair of bodies.
+ * See scene_add_collision_handler().
+ *
+ * @param scene the scene
+ * @param elasticity the "coefficient of restitution" of the collisions
+ * @param tag1 the tag of the first kind of body
+ * @param tag2 the tag of the second kind of body
+ */
+void create_tagged_physics_collision(scene_t *scene, real_t elasticity,
+                                     size_t tag1, size_t tag2);
+
+/**
+ * Makes a scene's collision stage remove a collidable body with one tag
+ * when it collides with a collidable body with another,
+ * as create_destructive_collision2() does for one pair of bodies.
+ * See scene_add_collision_handler().
+ *
+ * @param scene the scene
+ * @param tag1 the tag of the bodies to remove
+ * @param tag2 the tag of the bodies that remove them
+ */
+void create_tagged_destructive_collision2(scene_t *scene, size_t tag1,
+                                          size_t tag2);
+
 #endif // #ifndef __FORCES_H__
@@ -1,12 +1,15 @@
 #ifndef __LIST_H__
 #define __LIST_H__
 
+#include <stdbool.h>
 #include <stddef.h>
 
 /**
  * A growable array of pointers.
  * Can store values of any pointer type (e.g. vector_t*, body_t*).
  * The list automatically grows its internal array when more capacity is needed.
+ * Small lists keep their elements inside the list_t itself,
+ * so lists of a few elements cost a single allocation.
  */
 typedef struct list list_t;
 
@@ -16,6 +19,13 @@ typedef struct list list_t;
  */
 typedef void (*free_func_t)(void *);
 
+/**
+ * A function that decides whether a list element should be removed
+ * by list_remove_if().
+ * Takes in the element and an auxiliary value passed to list_remove_if().
+ */
+typedef bool (*list_predicate_t)(void *element, void *aux);
+
 /**
  * Allocates memory for a new list with space for the given number of elements.
  * The list is initially empty.
@@ -66,6 +76,50 @@ void *list_get(list_t *list, size_t index);
  */
 void *list_remove(list_t *list, size_t index);
 
+/**
+ * Removes the element at a given index in a list and returns it,
+ * moving the last element into its place.
+ * Unlike list_remove(), this takes constant time but does not preserve
+ * the order of the remaining elements.
+ * Asserts that the index is valid, given the list's current size.
+ *
+ * @param list a pointer to a list returned from list_init()
+ * @param index an index in the list (the first element is at 0)
+ * @return the element at the given index in the list
+ */
+void *list_swap_remove(list_t *list, size_t index);
+
+/**
+ * Removes every element for which a predicate returns true,
+ * keeping the remaining elements in their original order.
+ * This runs in a single pass, so removing k of n elements takes O(n) time
+ * rather than the O(n * k) of repeated list_remove() calls.
+ * Removed elements are passed to the list's freer, if it is non-NULL.
+ *
+ * @param list a pointer to a list returned from list_init()
+ * @param predicate a function returning whether to remove an element
+ * @param aux an auxiliary value to pass to the predicate
+ * @return the number of elements removed
+ */
+size_t list_remove_if(list_t *list, list_predicate_t predicate, void *aux);
+
+/**
+ * Ensures a list can hold at least the given number of elements
+ * without resizing. Never shrinks the list.
+ * Asserts that the resize succeeded.
+ *
+ * @param list a pointer to a list returned from list_init()
+ * @param capacity the number of elements to make room for
+ */
+void list_reserve(list_t *list, size_t capacity);
+
+/**
+ * Shrinks a list's internal array to fit exactly its current elements.
+ *
+ * @param list a pointer to a list returned from list_init()
+ */
+void list_shrink_to_fit(list_t *list);
+
 /**
  * Appends an element to the end of a list.
  * If the list is filled to capacity, resizes the list to fit more elements
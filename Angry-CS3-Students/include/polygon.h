@@ -3,6 +3,23 @@
 
 #include "list.h"
 #include "vector.h"
+#include "vertex_array.h"
+
+/**
+ * The area, center of mass and moment of inertia of a polygon
+ * of uniform unit density.
+ */
+typedef struct {
+  /** The area of the polygon */
+  real_t area;
+  /** The centroid of the polygon */
+  vector_t centroid;
+  /**
+   * The polar moment of inertia about the centroid at unit density,
+   * i.e. the second moment of area. Multiply by mass / area for a body.
+   */
+  real_t inertia;
+} polygon_mass_properties_t;
 
 /**
  * Computes the area of a polygon.
@@ -13,7 +30,7 @@
  * each pair of consecutive vertices, plus one between the first and last.
  * @return the area of the polygon
  */
-double polygon_area(list_t *polygon);
+real_t polygon_area(list_t *polygon);
 
 /**
  * Computes the center of mass of a polygon.
@@ -26,6 +43,16 @@ double polygon_area(list_t *polygon);
  */
 vector_t polygon_centroid(list_t *polygon);
 
+/**
+ * Computes the area, centroid and moment of inertia of a polygon
+ * in a single pass over its vertices.
+ *
+ * @param polygon the list of vertices that make up the polygon,
+ * listed in a counterclockwise direction
+ * @return the polygon's mass properties
+ */
+polygon_mass_properties_t polygon_mass_properties(list_t *polygon);
+
 /**
  * Translates all vertices in a polygon by a given vector.
  * Note: mutates the original polygon.
@@ -44,6 +71,75 @@ void polygon_translate(list_t *polygon, vector_t translation);
  * A positive angle means counterclockwise.
  * @param point the point to rotate around
  */
-void polygon_rotate(list_t *polygon, double angle, vector_t point);
+void polygon_rotate(list_t *polygon, real_t angle, vector_t point);
+
+/**
+ * Computes the area of a polygon stored as a packed vertex array.
+ * This is the native form of polygon_area(); the list version copies its
+ * vertices into a vertex array and calls this function.
+ *
+ * @param polygon the vertices that make up the polygon,
+ * listed in a counterclockwise direction
+ * @return the area of the polygon
+ */
+real_t polygon_array_area(const vertex_array_t *polygon);
+
+/**
+ * Computes the center of mass of a polygon stored as a packed vertex array.
+ *
+ * @param polygon the vertices that make up the polygon,
+ * listed in a counterclockwise direction
+ * @return the centroid of the polygon
+ */
+vector_t polygon_array_centroid(const vertex_array_t *polygon);
+
+/**
+ * Computes the mass properties of a polygon stored as a packed vertex array.
+ *
+ * @param polygon the vertices that make up the polygon,
+ * listed in a counterclockwise direction
+ * @return the polygon's mass properties
+ */
+polygon_mass_properties_t
+polygon_array_mass_properties(const vertex_array_t *polygon);
+
+/**
+ * Translates all vertices in a vertex array by a given vector.
+ * Note: mutates the original polygon.
+ *
+ * @param polygon the vertices that make up the polygon
+ * @param translation the vector to add to each vertex's position
+ */
+void polygon_array_translate(vertex_array_t *polygon, vector_t translation);
+
+/**
+ * Rotates the vertices in a vertex array by a given angle about a given point.
+ * Note: mutates the original polygon.
+ *
+ * @param polygon the vertices that make up the polygon
+ * @param angle the angle to rotate the polygon, in radians.
+ * A positive angle means counterclockwise.
+ * @param point the point to rotate around
+ */
+void polygon_array_rotate(vertex_array_t *polygon, real_t angle,
+                          vector_t point);
+
+/**
+ * The largest number of points polygon_unit_circle() supports.
+ */
+#define MAX_CIRCLE_PTS 1024
+
+/**
+ * Gets the vertices of a regular n-gon inscribed in the unit circle,
+ * counterclockwise starting from (1, 0).
+ * Each table is computed once, on first use, and shared by every later call,
+ * so circles of any radius can be made by scaling it instead of rotating
+ * a point n times.
+ * Asserts that 3 <= n <= MAX_CIRCLE_PTS.
+ *
+ * @param n the number of points on the circle
+ * @return a table of n vertices, owned by the library; do not free it
+ */
+const vector_t *polygon_unit_circle(size_t n);
 
 #endif // #ifndef __POLYGON_H__
@@ -0,0 +1,62 @@
+#ifndef __POOL_H__
+#define __POOL_H__
+
+#include <stddef.h>
+
+/**
+ * A pool allocator for objects of one fixed size.
+ * Objects are carved out of large slabs and recycled through a free list,
+ * so allocating and releasing them never calls malloc() or free() once the
+ * pool has warmed up, and objects allocated together sit together in memory.
+ *
+ * Every object remembers the pool it came from, so pool_release() has the
+ * signature of a free_func_t and can be passed anywhere free() would be,
+ * e.g. as the freer of a force creator's aux.
+ */
+typedef struct pool pool_t;
+
+/**
+ * Allocates memory for an empty pool.
+ * No slabs are allocated until the first call to pool_alloc().
+ * Asserts that the required memory is allocated.
+ *
+ * @param object_size the size of each object, in bytes
+ * @param slab_objects the number of objects in each slab
+ * @return a pointer to the newly allocated pool
+ */
+pool_t *pool_init(size_t object_size, size_t slab_objects);
+
+/**
+ * Releases a pool and every slab it allocated, all at once.
+ * Any objects still allocated from the pool become invalid.
+ *
+ * @param pool a pointer to a pool returned from pool_init()
+ */
+void pool_free(pool_t *pool);
+
+/**
+ * Allocates an object from a pool.
+ * The object is uninitialized, and suitably aligned for any type.
+ *
+ * @param pool a pointer to a pool returned from pool_init()
+ * @return a pointer to the object
+ */
+void *pool_alloc(pool_t *pool);
+
+/**
+ * Returns an object to the pool it was allocated from.
+ * Does nothing if object is NULL, like free().
+ *
+ * @param object a pointer returned from pool_alloc()
+ */
+void pool_release(void *object);
+
+/**
+ * Gets the number of objects currently allocated from a pool.
+ *
+ * @param pool a pointer to a pool returned from pool_init()
+ * @return the number of objects allocated and not yet released
+ */
+size_t pool_live(pool_t *pool);
+
+#endif // #ifndef __POOL_H__
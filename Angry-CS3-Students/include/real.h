@@ -0,0 +1,121 @@
+#ifndef __REAL_H__
+#define __REAL_H__
+
+#include <math.h>
+
+/**
+ * The floating-point type used by the physics core:
+ * vectors, body state, and the polygon, collision and force math.
+ * Defaults to double. Build with -DPHYSICS_REAL=float for single precision,
+ * which halves the size of every vector.
+ */
+#ifndef PHYSICS_REAL
+#define PHYSICS_REAL double
+#endif
+typedef PHYSICS_REAL real_t;
+
+/**
+ * PHYSICS_FLOAT is 1 when PHYSICS_REAL is float and 0 when it is double,
+ * for code that has to be selected by the preprocessor.
+ */
+#define PHYSICS_REAL_IS_float 1
+#define PHYSICS_REAL_IS_double 0
+#define PHYSICS_REAL_KIND_(type) PHYSICS_REAL_IS_##type
+#define PHYSICS_REAL_KIND(type) PHYSICS_REAL_KIND_(type)
+#define PHYSICS_FLOAT PHYSICS_REAL_KIND(PHYSICS_REAL)
+
+#ifdef PHYSICS_FIXED
+#include "fixed.h"
+#if PHYSICS_FLOAT
+#error "PHYSICS_FIXED converts through double and needs PHYSICS_REAL=double"
+#endif
+#endif
+
+/** The square root at the physics precision */
+static inline real_t real_sqrt(real_t x) {
+#if PHYSICS_FLOAT
+  return sqrtf(x);
+#else
+  return sqrt(x);
+#endif
+}
+
+/**
+ * Computes the sine and cosine of an angle together, without calling libm.
+ * The angle is reduced to [-pi/4, pi/4] around the nearest multiple of pi/2,
+ * where Taylor polynomials of degree 13 and 14 are accurate to about 1e-15.
+ * Meant for angles of moderate size (well under 1e9 radians).
+ *
+ * @param angle the angle in radians
+ * @param sin_out where to store sin(angle)
+ * @param cos_out where to store cos(angle)
+ */
+static inline void fast_sincos(real_t angle, real_t *sin_out,
+                               real_t *cos_out) {
+  // pi/2 split in two so that angle - k * pi/2 loses no precision
+  const double PIO2_HI = 1.57079632673412561417e+00;
+  const double PIO2_LO = 6.07710050650619224932e-11;
+  const double TWO_OVER_PI = 6.36619772367581382433e-01;
+
+  double q = angle * TWO_OVER_PI;
+  long long k = (long long)(q < 0 ? q - 0.5 : q + 0.5);
+  double r = ((double)angle - k * PIO2_HI) - k * PIO2_LO;
+  double r2 = r * r;
+
+  double s = r + r * r2 * (-1.0 / 6 + r2 * (1.0 / 120 + r2 * (-1.0 / 5040 +
+             r2 * (1.0 / 362880 + r2 * (-1.0 / 39916800 +
+             r2 * (1.0 / 6227020800))))));
+  double c = 1 - r2 / 2 + r2 * r2 * (1.0 / 24 + r2 * (-1.0 / 720 +
+             r2 * (1.0 / 40320 + r2 * (-1.0 / 3628800 +
+             r2 * (1.0 / 479001600 + r2 * (-1.0 / 87178291200))))));
+
+  // Rotate (c, s) by the k quarter turns that were taken out
+  switch (k & 3) {
+  case 0:
+    *sin_out = s;
+    *cos_out = c;
+    break;
+  case 1:
+    *sin_out = c;
+    *cos_out = -s;
+    break;
+  case 2:
+    *sin_out = -s;
+    *cos_out = -c;
+    break;
+  default:
+    *sin_out = -c;
+    *cos_out = s;
+    break;
+  }
+}
+
+/**
+ * Computes the sine and cosine of an angle at the physics precision.
+ * Builds with -DPHYSICS_FIXED use fixed_sincos(), so rotations are
+ * reproducible across targets. Builds with -DFAST_TRIG (e.g. 'make release')
+ * use fast_sincos(), and the rest use libm.
+ *
+ * @param angle the angle in radians
+ * @param sin_out where to store sin(angle)
+ * @param cos_out where to store cos(angle)
+ */
+static inline void real_sincos(real_t angle, real_t *sin_out,
+                               real_t *cos_out) {
+#if defined(PHYSICS_FIXED)
+  fixed_t s, c;
+  fixed_sincos(fixed_from_double(angle), &s, &c);
+  *sin_out = fixed_to_double(s);
+  *cos_out = fixed_to_double(c);
+#elif defined(FAST_TRIG)
+  fast_sincos(angle, sin_out, cos_out);
+#elif PHYSICS_FLOAT
+  *sin_out = sinf(angle);
+  *cos_out = cosf(angle);
+#else
+  *sin_out = sin(angle);
+  *cos_out = cos(angle);
+#endif
+}
+
+#endif // #ifndef __REAL_H__
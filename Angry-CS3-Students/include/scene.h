@@ -2,7 +2,9 @@
 #define __SCENE_H__
 
 #include "body.h"
+#include "broadphase.h"
 #include "list.h"
+#include "pool.h"
 
 /**
  * A collection of bodies and force creators.
@@ -18,6 +20,18 @@ typedef struct scene scene_t;
  */
 typedef void (*force_creator_t)(void *aux);
 
+/**
+ * A function called when a collision occurs.
+ * @param body1 the first body passed to create_collision(), or the body with
+ *   the first tag passed to scene_add_collision_handler()
+ * @param body2 the other body
+ * @param axis a unit vector pointing from body1 towards body2
+ *   that defines the direction the two bodies are colliding in
+ * @param aux the auxiliary value passed when the handler was registered
+ */
+typedef void (*collision_handler_t)(body_t *body1, body_t *body2, vector_t axis,
+                                    void *aux);
+
 /**
  * Allocates memory for an empty scene.
  * Makes a reasonable guess of the number of bodies to allocate space for.
@@ -27,6 +41,30 @@ typedef void (*force_creator_t)(void *aux);
  */
 scene_t *scene_init(void);
 
+/**
+ * Where a scene keeps the linear state (position, velocity, forces) of its
+ * bodies.
+ */
+typedef enum {
+  /** In each body, which scene_tick() visits in turn */
+  SCENE_STORAGE_BODIES,
+  /**
+   * In a body store owned by the scene (see body_store_init()),
+   * which scene_tick() integrates with a single batched kernel.
+   * Faster for scenes with many bodies; the bodies' API is unchanged.
+   */
+  SCENE_STORAGE_ARRAYS,
+} scene_storage_t;
+
+/**
+ * Allocates memory for an empty scene that stores its bodies' state
+ * in a given way. scene_init() uses SCENE_STORAGE_BODIES.
+ *
+ * @param storage where to keep the bodies' linear state
+ * @return the new scene
+ */
+scene_t *scene_init_with_storage(scene_storage_t storage);
+
 /**
  * Releases memory allocated for a given scene
  * and all the bodies and force creators it contains.
@@ -53,13 +91,78 @@ size_t scene_bodies(scene_t *scene);
  */
 body_t *scene_get_body(scene_t *scene, size_t index);
 
+/**
+ * Gets the array of bodies in a scene, in the same order as scene_get_body().
+ * The array is owned by the scene and must not be modified;
+ * it is only valid until the next call to scene_add_body() or scene_tick().
+ * Lets hot loops walk the bodies with inlined accesses.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return a pointer to the scene's array of bodies
+ */
+const body_ptr_array_t *scene_get_bodies(scene_t *scene);
+
 /**
  * Adds a body to a scene.
+ * With SCENE_STORAGE_ARRAYS, the body's state moves into the scene's store,
+ * so it must not already be in another store.
  *
  * @param scene a pointer to a scene returned from scene_init()
  * @param body a pointer to the body to add to the scene
+ * @return the body's handle (see body_get_handle()), which unlike its index
+ *   stays the same as other bodies are removed
+ */
+body_handle_t scene_add_body(scene_t *scene, body_t *body);
+
+/**
+ * Gets the number of bodies in a scene with a given tag (see body_set_tag()),
+ * in constant time.
+ * Bodies marked for removal are counted until the next scene_tick().
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param tag the tag to count
+ * @return the number of bodies with the tag
+ */
+size_t scene_count_tag(scene_t *scene, size_t tag);
+
+/**
+ * Gets the first body in a scene with a given tag, in constant time.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param tag the tag to look for
+ * @return the body with the tag that was added first, or NULL if there is none
  */
-void scene_add_body(scene_t *scene, body_t *body);
+body_t *scene_first_tag(scene_t *scene, size_t tag);
+
+/**
+ * Gets the bodies in a scene with a given tag, in the order they were added.
+ * Like scene_get_bodies(), the array is owned by the scene and
+ * is only valid until the next call to scene_add_body() or scene_tick().
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param tag the tag to look for
+ * @return a pointer to the array of bodies with the tag, which may be empty
+ */
+const body_ptr_array_t *scene_get_tagged(scene_t *scene, size_t tag);
+
+/**
+ * Gets a body in a scene from its handle, in constant time.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param handle the handle returned when the body was added
+ * @return the body, or NULL if it has been marked for removal or freed,
+ *   or was never added to this scene
+ */
+body_t *scene_get_body_by_handle(scene_t *scene, body_handle_t handle);
+
+/**
+ * Marks a body in a scene for removal, given its handle.
+ * Does nothing if the body has already been removed or freed.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param handle the handle returned when the body was added
+ */
+void scene_remove_body_by_handle(scene_t *scene, body_handle_t handle);
 
 /**
  * @deprecated Use body_remove() instead
@@ -72,6 +175,14 @@ void scene_add_body(scene_t *scene, body_t *body);
  */
 void scene_remove_body(scene_t *scene, size_t index);
 
+/**
+ * Removes every force creator with a given id from a scene,
+ * freeing their aux values.
+ * Takes time proportional to the number of force creators removed.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param id the id the force creators were added with
+ */
 void scene_remove_force_creator(scene_t *scene, size_t id);
 
 /**
@@ -93,17 +204,217 @@ void scene_add_force_creator(scene_t *scene, force_creator_t forcer, void *aux,
  * @param aux an auxiliary value to pass to forcer when it is called
  * @param bodies the list of bodies affected by the force creator.
  *   The force creator will be removed if any of these bodies are removed.
- *   This list does not own the bodies, so its freer should be NULL.
+ *   The scene keeps the bodies' handles and frees the list, but not the
+ *   bodies in it.
  * @param freer if non-NULL, a function to call in order to free aux
  */
 void scene_add_bodies_force_creator(scene_t *scene, force_creator_t forcer,
                                     void *aux, list_t *bodies,
                                     free_func_t freer, size_t id);
 
+/**
+ * Adds a force creator to a scene like scene_add_bodies_force_creator(),
+ * first removing any force creator with the same id and forcer that
+ * depends on the same bodies in the same order.
+ * Registering e.g. gravity on a body twice then replaces the first force
+ * instead of doubling it, while other forces with the id are kept.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param forcer a force creator function
+ * @param aux an auxiliary value to pass to forcer when it is called
+ * @param bodies the list of bodies affected by the force creator,
+ *   as in scene_add_bodies_force_creator()
+ * @param freer if non-NULL, a function to call in order to free aux
+ * @param id the id of the force creator
+ */
+void scene_upsert_bodies_force_creator(scene_t *scene, force_creator_t forcer,
+                                       void *aux, list_t *bodies,
+                                       free_func_t freer, size_t id);
+
+/**
+ * The largest aux that scene_alloc_aux() can allocate, in bytes.
+ */
+#define SCENE_AUX_MAX_SIZE 128
+
+/**
+ * Allocates memory for a force creator's aux value from pools owned by the
+ * scene, so that force creators added together sit together in memory and
+ * adding them mid-game does not call malloc().
+ * Pass pool_release() as the force creator's freer. Anything still allocated
+ * when the scene is freed is released along with it.
+ * Asserts that size is at most SCENE_AUX_MAX_SIZE.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param size the size of the aux value, in bytes
+ * @return a pointer to uninitialized memory for the aux value
+ */
+void *scene_alloc_aux(scene_t *scene, size_t size);
+
+/**
+ * The default width and height of the cells of a scene's collision grid.
+ */
+#define SCENE_CELL_SIZE 64
+
+/**
+ * Registers a handler with a scene's collision stage, to be called whenever
+ * a collidable body with one tag starts colliding with a collidable body with
+ * another (see body_set_collidable() and body_set_tag()).
+ * It is called once when the bodies start colliding, and not again until
+ * they have separated.
+ *
+ * Each scene_tick() finds the collidable bodies whose bounding boxes share a
+ * cell of a uniform grid, after running the force creators, and only tests
+ * those pairs, so the cost does not depend on how many pairs could collide.
+ * Bodies whose tag has no handler are skipped.
+ *
+ * The handlers for the pairs that start colliding in a tick are called
+ * once every pair has been tested, ordered by the index in the scene of
+ * the handler's body2 and then of its body1. This is the order that
+ * scene_add_pair_collision_handler() calls made by looping over the
+ * scene's bodies give. If tag1 equals tag2, the handler is called for
+ * both orders of the two bodies.
+ *
+ * Adding the same handler for the same tags in the same order replaces
+ * the earlier one, freeing its aux.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param tag1 the tag of the handler's body1
+ * @param tag2 the tag of the handler's body2; may equal tag1
+ * @param handler a function to call whenever two such bodies collide
+ * @param aux an auxiliary value to pass to the handler
+ * @param freer if non-NULL, a function to call in order to free aux
+ */
+void scene_add_collision_handler(scene_t *scene, size_t tag1, size_t tag2,
+                                 collision_handler_t handler, void *aux,
+                                 free_func_t freer);
+
+/**
+ * Registers a handler with a scene's collision stage for one pair of
+ * bodies, to be called whenever they start colliding, whether or not they
+ * are collidable or tagged. It is called once when the bodies start
+ * colliding, or on the first tick if they already are, and not again until
+ * they have separated.
+ *
+ * The pair is only tested while the broadphase finds their bounding boxes
+ * overlapping, so a pair that is far apart costs nothing per tick.
+ * The handler is removed, freeing its aux, when either body is.
+ * A pair may have several handlers, which are called in the order they
+ * were added, among the others as for scene_add_collision_handler().
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param body1 the handler's body1, which must be in the scene
+ * @param body2 the handler's body2, which must be in the scene
+ * @param handler a function to call whenever the bodies collide
+ * @param aux an auxiliary value to pass to the handler
+ * @param freer if non-NULL, a function to call in order to free aux
+ */
+void scene_add_pair_collision_handler(scene_t *scene, body_t *body1,
+                                      body_t *body2,
+                                      collision_handler_t handler, void *aux,
+                                      free_func_t freer);
+
+/**
+ * How a scene's collision stage finds the bodies that may be colliding.
+ */
+typedef enum {
+  /**
+   * Rebuilds a uniform grid every tick (see grid_init()).
+   * Works well however the bodies move.
+   */
+  SCENE_BROADPHASE_GRID,
+  /**
+   * Keeps a sweep-and-prune broadphase from tick to tick
+   * (see sweep_init()), so that only bodies that move cost anything.
+   * Suits scenes where most bodies are at rest.
+   */
+  SCENE_BROADPHASE_SWEEP,
+  /**
+   * Uses the tree that the scene's queries use (see scene_query_box()),
+   * so that a scene that is queried often keeps only one broadphase.
+   */
+  SCENE_BROADPHASE_TREE,
+} scene_broadphase_t;
+
+/**
+ * Sets how a scene's collision stage finds the bodies that may be colliding.
+ * Which bodies are colliding is kept, so handlers are not called again for
+ * bodies that were already colliding.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param broadphase the broadphase to use; SCENE_BROADPHASE_GRID by default
+ */
+void scene_set_broadphase(scene_t *scene, scene_broadphase_t broadphase);
+
+/**
+ * Sets the size of the cells of a scene's collision grid.
+ * Cells should be around the size of a typical collidable body.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param cell_size the width and height of each cell;
+ *   SCENE_CELL_SIZE by default
+ */
+void scene_set_cell_size(scene_t *scene, real_t cell_size);
+
+/**
+ * Finds the bodies in a scene whose bounding boxes overlap a box.
+ * Queries use a tree of the bounding boxes of all the scene's bodies
+ * (see aabb_tree_init()), which is built by the first query, so a query
+ * only visits the bodies near what it looks for.
+ * The tree is brought up to date at the end of each scene_tick(), when
+ * only bodies that have moved far are reinserted. Bodies added since are
+ * found too, but a body moved by hand since is found where it was.
+ * Bodies marked for removal are not found.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param box the box to look in
+ * @param bodies an array that is replaced with the bodies found,
+ *   in no particular order
+ */
+void scene_query_box(scene_t *scene, aabb_t box, body_ptr_array_t *bodies);
+
+/**
+ * Finds the bodies in a scene whose bounding boxes contain a point.
+ * See scene_query_box().
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param point the point
+ * @param bodies an array that is replaced with the bodies found,
+ *   in no particular order
+ */
+void scene_query_point(scene_t *scene, vector_t point,
+                       body_ptr_array_t *bodies);
+
+/**
+ * Finds the bodies in a scene whose bounding boxes come within a distance
+ * of a point. This includes every body whose centroid is that close.
+ * See scene_query_box().
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param center the point
+ * @param radius the distance
+ * @param bodies an array that is replaced with the bodies found,
+ *   in no particular order
+ */
+void scene_query_radius(scene_t *scene, vector_t center, real_t radius,
+                        body_ptr_array_t *bodies);
+
+/**
+ * Finds the bodies in a scene whose bounding boxes a line segment passes
+ * through. See scene_query_box().
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param from the start of the segment
+ * @param to the end of the segment
+ * @param bodies an array that is replaced with the bodies found,
+ *   nearest to the start of the segment first
+ */
+void scene_query_ray(scene_t *scene, vector_t from, vector_t to,
+                     body_ptr_array_t *bodies);
+
 /**
  * Executes a tick of a given scene over a small time interval.
- * This requires executing all the force creators
- * and then ticking each body (see body_tick()).
+ * This requires executing all the force creators, then the collision
+ * handlers, and then ticking each body (see body_tick()).
  * If any bodies are marked for removal, they should be removed from the scene
  * and freed, along with any force creators acting on them.
  *
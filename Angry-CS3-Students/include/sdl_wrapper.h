@@ -6,6 +6,7 @@
 #include "polygon.h"
 #include "scene.h"
 #include "vector.h"
+#include "vertex_array.h"
 #include <stdbool.h>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
@@ -98,6 +99,15 @@ void sdl_clear(void);
  */
 void sdl_draw_polygon(list_t *points, rgb_color_t color);
 
+/**
+ * Draws a polygon from a packed vertex array and a color.
+ * This is the native form of sdl_draw_polygon().
+ *
+ * @param points the vertices of the polygon
+ * @param color the color used to fill in the polygon
+ */
+void sdl_draw_polygon_array(const vertex_array_t *points, rgb_color_t color);
+
 /**
  * Displays the rendered frame on the SDL window.
  * Must be called after drawing the polygons in order to show them.
@@ -0,0 +1,107 @@
+#ifndef __SHAPE_H__
+#define __SHAPE_H__
+
+#include "broadphase.h"
+#include "vector.h"
+#include "vertex_array.h"
+#include <stddef.h>
+
+/**
+ * Immutable local-space geometry that any number of bodies can share,
+ * each placing it in the world with its own centroid and angle.
+ * Alongside the vertices, a shape keeps the data that follows from them,
+ * so it is computed once per shape rather than once per body.
+ * Shapes are reference counted; see shape_retain() and shape_release().
+ *
+ * shape_t is defined here instead of shape.c so that hot loops can read
+ * the vertices and normals directly. Do not modify a shape's fields.
+ */
+typedef struct shape {
+  /** The vertices in local space, in counterclockwise order */
+  vertex_array_t *vertices;
+  /**
+   * The outward unit normal of each edge in local space:
+   * normals[i] belongs to the edge from vertex i to vertex i + 1
+   */
+  vertex_array_t *normals;
+  /**
+   * The normals that are candidate separating axes, in order, leaving out
+   * any normal parallel to an earlier one (e.g. the far side of a
+   * rectangle), since projecting onto both gives the same overlap
+   */
+  vertex_array_t *axes;
+  /** The area of the polygon */
+  real_t area;
+  /** The moment of inertia about the centroid at unit density */
+  real_t inertia;
+  /** The smallest box containing the vertices, in local space */
+  aabb_t bounds;
+  /** The distance from the local origin to the farthest vertex */
+  real_t radius;
+  /** The number of references to the shape */
+  size_t refs;
+} shape_t;
+
+/**
+ * A function that builds the vertices of a shape from up to two parameters,
+ * e.g. a radius, or a width and a height.
+ */
+typedef vertex_array_t *(*shape_maker_t)(real_t param1, real_t param2);
+
+/**
+ * Allocates a shape with the given local-space vertices.
+ * The new shape has one reference, owned by the caller.
+ *
+ * @param vertices the vertices, listed in a counterclockwise direction.
+ *   The shape takes ownership of the array.
+ * @return a pointer to the newly allocated shape
+ */
+shape_t *shape_init(vertex_array_t *vertices);
+
+/**
+ * Adds a reference to a shape.
+ *
+ * @param shape a pointer to a shape
+ * @return the shape, for convenience
+ */
+shape_t *shape_retain(shape_t *shape);
+
+/**
+ * Removes a reference to a shape, freeing it when none remain.
+ *
+ * @param shape a pointer to a shape
+ */
+void shape_release(shape_t *shape);
+
+/**
+ * Gets the shared shape for a kind of shape and its parameters,
+ * building it with make the first time that combination is requested.
+ * Interned shapes are moved so that their centroid is the local origin.
+ * The registry keeps a reference to every shape it builds; callers that
+ * store the shape (e.g. body_init_with_shape()) add their own.
+ *
+ * @param kind the name of the kind of shape, e.g. "circle".
+ *   Shapes with the same kind must be built by the same maker.
+ * @param param1 the first parameter passed to make
+ * @param param2 the second parameter passed to make
+ * @param make a function that builds the shape's vertices
+ * @return the shared shape, owned by the registry
+ */
+shape_t *shape_intern(const char *kind, real_t param1, real_t param2,
+                      shape_maker_t make);
+
+/**
+ * Gets the number of shapes in the registry.
+ *
+ * @return the number of distinct shapes interned since the last
+ *   shape_registry_clear()
+ */
+size_t shape_registry_size(void);
+
+/**
+ * Empties the registry, dropping its reference to every interned shape.
+ * Shapes still used by bodies stay alive until those bodies are freed.
+ */
+void shape_registry_clear(void);
+
+#endif // #ifndef __SHAPE_H__
@@ -45,6 +45,21 @@ bool within(double epsilon, double d1, double d2);
  */
 bool vec_within(double epsilon, vector_t v1, vector_t v2);
 
+/**
+ * The tolerance for values integrated over many ticks, which gather
+ * rounding error on every tick. Like any tolerance passed to within(), it
+ * is scaled up further in -DPHYSICS_REAL=float builds.
+ * -DPHYSICS_FIXED builds round a tick of 1e-6 s to a multiple of 2^-32 s,
+ * about 2e-4 of the tick, so they need the loosest tolerance.
+ */
+#if defined(PHYSICS_FIXED)
+#define TEST_EPS 1e-2
+#elif PHYSICS_FLOAT
+#define TEST_EPS 1e-5
+#else
+#define TEST_EPS 1e-7
+#endif
+
 /**
  * Open the file 'filename', read one word into 'testname', and close the file.
  * If the file cannot be found, exit with error.
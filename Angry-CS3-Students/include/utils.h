@@ -4,6 +4,7 @@
 #include "list.h"
 #include "scene.h"
 #include "vector.h"
+#include "vertex_array.h"
 #include <stdlib.h>
 #include <stdio.h>
 
@@ -43,24 +44,27 @@ extern const size_t N_STUDENTS;
  */
 body_t *get_body(scene_t *scene, size_t body_id);
 
-/* Helper function to get body in the scene based on id */
-size_t get_idx(scene_t *scene, size_t body_id);
-
 /* Helper function to make a circle given the radius and number of points
  */
-list_t *make_circle(double radius);
+vertex_array_t *make_circle(double radius);
 
 // Helper function to construct an equilateral triangle with given side length
-list_t *make_equilateral_triangle(double side_length); 
+vertex_array_t *make_equilateral_triangle(double side_length); 
+
+/* Helper functions to get the shared shape of each kind of body,
+   built on first use (see shape_intern()) */
+shape_t *circle_shape(double radius);
+shape_t *equilateral_triangle_shape(double side_length);
+shape_t *rectangle_shape(int32_t length, int32_t height);
 
 /* Function to make slingshot */
-list_t *make_slingshot();
+vertex_array_t *make_slingshot();
 
 /* Function to make rubberband given scene, and center of rubberband */
-list_t *make_rubberband(scene_t *scene, vector_t *center);
+vertex_array_t *make_rubberband(scene_t *scene, vector_t *center);
 
 /* Helper function to make rectangle */
-list_t *make_rectangle(int32_t length, int32_t height);
+vertex_array_t *make_rectangle(int32_t length, int32_t height);
 
 /* Helper function to set physics and destructive collision simultaneously */
 void make_collisions(scene_t *scene, size_t id);
@@ -0,0 +1,149 @@
+#ifndef __VEC_BATCH_H__
+#define __VEC_BATCH_H__
+
+#include "vector.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Batched vector kernels, which apply one operation to many vectors at once.
+ *
+ * The vectors' components are passed as separate x and y arrays:
+ * vector i is (xs[i * stride], ys[i * stride]).
+ * A stride of 1 is a structure-of-arrays layout.
+ * A stride of 2 with ys == xs + 1 runs the kernels directly over an array of
+ * vector_t, e.g. vec_translate_n(&v[0].x, &v[0].y, 2, n, translation).
+ *
+ * Those two layouts have SIMD implementations on x86 (SSE2, or AVX2 if the
+ * CPU supports it, chosen at runtime) when real_t is double. Other strides,
+ * other platforms and -DPHYSICS_REAL=float builds use the scalar reference
+ * implementation, which every backend must match.
+ */
+
+/**
+ * The implementations the kernels can dispatch to.
+ */
+typedef enum {
+  VEC_BATCH_SCALAR,
+  VEC_BATCH_SSE2,
+  VEC_BATCH_AVX2,
+} vec_batch_backend_t;
+
+/**
+ * Gets the backend the kernels currently dispatch to.
+ * The first call picks the fastest backend the CPU supports.
+ *
+ * @return the current backend
+ */
+vec_batch_backend_t vec_batch_get_backend(void);
+
+/**
+ * Forces the kernels to use a given backend, e.g. to compare backends.
+ *
+ * @param backend the backend to use
+ * @return whether the backend is supported; if not, nothing changes
+ */
+bool vec_batch_set_backend(vec_batch_backend_t backend);
+
+/**
+ * Translates n vectors in place.
+ *
+ * @param xs the x components
+ * @param ys the y components
+ * @param stride the distance between consecutive components, in elements
+ * @param n the number of vectors
+ * @param translation the vector to add to each vector
+ */
+void vec_translate_n(real_t *xs, real_t *ys, size_t stride, size_t n,
+                     vector_t translation);
+
+/**
+ * Rotates n vectors in place around a point.
+ *
+ * @param xs the x components
+ * @param ys the y components
+ * @param stride the distance between consecutive components, in elements
+ * @param n the number of vectors
+ * @param rot the rotation, from rot_init()
+ * @param point the point to rotate around
+ */
+void vec_rotate_n(real_t *xs, real_t *ys, size_t stride, size_t n, rot_t rot,
+                  vector_t point);
+
+/**
+ * Computes the dot product of each of n vectors with a given vector.
+ *
+ * @param xs the x components
+ * @param ys the y components
+ * @param stride the distance between consecutive components, in elements
+ * @param n the number of vectors
+ * @param v the vector to dot with
+ * @param out an array of n real_t to store the dot products in
+ */
+void vec_dot_n(const real_t *xs, const real_t *ys, size_t stride, size_t n,
+               vector_t v, real_t *out);
+
+/**
+ * Finds the extent of n vectors projected onto an axis,
+ * i.e. the minimum and maximum of their dot products with it.
+ * Asserts that n is positive.
+ *
+ * @param xs the x components
+ * @param ys the y components
+ * @param stride the distance between consecutive components, in elements
+ * @param n the number of vectors
+ * @param axis the axis to project onto
+ * @param min where to store the minimum projection
+ * @param max where to store the maximum projection
+ */
+void vec_minmax_project_n(const real_t *xs, const real_t *ys, size_t stride,
+                          size_t n, vector_t axis, real_t *min, real_t *max);
+
+/**
+ * Maps n scene coordinates to window pixel coordinates.
+ * Pixel = window_center + scale * (v - center), with the y axis flipped
+ * since positive y is down on the screen, rounded half away from zero.
+ *
+ * @param xs the x components
+ * @param ys the y components
+ * @param stride the distance between consecutive components, in elements
+ * @param n the number of vectors
+ * @param center the scene coordinate at the center of the window
+ * @param scale the number of pixels per scene unit
+ * @param window_center the center of the window in pixel coordinates
+ * @param px an array of n pixel x coordinates to fill in
+ * @param py an array of n pixel y coordinates to fill in
+ */
+void vec_to_pixels_n(const real_t *xs, const real_t *ys, size_t stride,
+                     size_t n, vector_t center, real_t scale,
+                     vector_t window_center, int16_t *px, int16_t *py);
+
+/**
+ * The linear state of n bodies in structure-of-arrays layout:
+ * body i is at (pos_x[i], pos_y[i]), moving at (vel_x[i], vel_y[i]), etc.
+ * A body with infinite mass has an inverse mass of 0.
+ */
+typedef struct particle_arrays {
+  real_t *pos_x;
+  real_t *pos_y;
+  real_t *vel_x;
+  real_t *vel_y;
+  real_t *force_x;
+  real_t *force_y;
+  real_t *impulse_x;
+  real_t *impulse_y;
+  real_t *inv_mass;
+} particle_arrays_t;
+
+/**
+ * Integrates n bodies over a time step, with the same arithmetic as
+ * body_tick(), and resets their forces and impulses.
+ *
+ * @param particles the bodies' arrays, each of at least n elements
+ * @param n the number of bodies
+ * @param dt the number of seconds elapsed since the last tick
+ */
+void vec_integrate_n(const particle_arrays_t *particles, size_t n, double dt);
+
+#endif // #ifndef __VEC_BATCH_H__
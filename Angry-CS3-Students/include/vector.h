@@ -1,17 +1,22 @@
 #ifndef __VECTOR_H__
 #define __VECTOR_H__
 
+#include "real.h"
+
 /**
  * A real-valued 2-dimensional vector.
  * Positive x is towards the right; positive y is towards the top.
  * vector_t is defined here instead of vector.c because it is passed *by value*.
+ *
+ * The arithmetic below is defined as static inline functions in this header
+ * so that every caller can inline it without relying on link-time optimization.
  */
 typedef struct {
-  double x;
-  double y;
+  real_t x;
+  real_t y;
 } vector_t;
 
-vector_t *vec_init(double x, double y);
+vector_t *vec_init(real_t x, real_t y);
 
 /**
  * The zero vector, i.e. (0, 0).
@@ -28,7 +33,9 @@ extern const vector_t VEC_ZERO;
  * @param v2 the second vector
  * @return v1 + v2
  */
-vector_t vec_add(vector_t v1, vector_t v2);
+static inline vector_t vec_add(vector_t v1, vector_t v2) {
+  return (vector_t){v1.x + v2.x, v1.y + v2.y};
+}
 
 /**
  * Subtracts two vectors.
@@ -38,7 +45,9 @@ vector_t vec_add(vector_t v1, vector_t v2);
  * @param v2 the second vector
  * @return v1 - v2
  */
-vector_t vec_subtract(vector_t v1, vector_t v2);
+static inline vector_t vec_subtract(vector_t v1, vector_t v2) {
+  return (vector_t){v1.x - v2.x, v1.y - v2.y};
+}
 
 
 /**
@@ -48,7 +57,11 @@ vector_t vec_subtract(vector_t v1, vector_t v2);
  * @param v2 the second vector
  * @return sqrt((v2.x-v1.x)**2 + (v2.y-v1.y)**2)
  */
-double vec_distance(vector_t v1, vector_t v2);
+static inline real_t vec_distance(vector_t v1, vector_t v2) {
+  real_t dx = v2.x - v1.x;
+  real_t dy = v2.y - v1.y;
+  return real_sqrt(dx * dx + dy * dy);
+}
 
 /**
  * Computes the additive inverse a vector.
@@ -57,7 +70,9 @@ double vec_distance(vector_t v1, vector_t v2);
  * @param v the vector whose inverse to compute
  * @return -v
  */
-vector_t vec_negate(vector_t v);
+static inline vector_t vec_negate(vector_t v) {
+  return (vector_t){-v.x, -v.y};
+}
 
 /**
  * Multiplies a vector by a scalar.
@@ -67,7 +82,9 @@ vector_t vec_negate(vector_t v);
  * @param v the vector to scale
  * @return scalar * v
  */
-vector_t vec_multiply(double scalar, vector_t v);
+static inline vector_t vec_multiply(real_t scalar, vector_t v) {
+  return (vector_t){scalar * v.x, scalar * v.y};
+}
 
 /**
  * Computes the dot product of two vectors.
@@ -77,7 +94,9 @@ vector_t vec_multiply(double scalar, vector_t v);
  * @param v2 the second vector
  * @return v1 . v2
  */
-double vec_dot(vector_t v1, vector_t v2);
+static inline real_t vec_dot(vector_t v1, vector_t v2) {
+  return v1.x * v2.x + v1.y * v2.y;
+}
 
 /**
  * Computes the cross product of two vectors,
@@ -88,7 +107,43 @@ double vec_dot(vector_t v1, vector_t v2);
  * @param v2 the second vector
  * @return the z-component of v1 x v2
  */
-double vec_cross(vector_t v1, vector_t v2);
+static inline real_t vec_cross(vector_t v1, vector_t v2) {
+  return v1.x * v2.y - v1.y * v2.x;
+}
+
+/**
+ * A rotation, stored as the cosine and sine of its angle.
+ * Computing these once and reusing them avoids two trig calls per vector
+ * when many vectors are rotated by the same angle.
+ */
+typedef struct {
+  real_t cos;
+  real_t sin;
+} rot_t;
+
+/**
+ * Computes the rotation by a given angle.
+ *
+ * @param angle the angle in radians, counterclockwise
+ * @return the rotation
+ */
+static inline rot_t rot_init(real_t angle) {
+  rot_t rot;
+  real_sincos(angle, &rot.sin, &rot.cos);
+  return rot;
+}
+
+/**
+ * Rotates a vector around (0, 0) by a precomputed rotation.
+ *
+ * @param v the vector to rotate
+ * @param rot the rotation, from rot_init()
+ * @return v rotated by rot
+ */
+static inline vector_t vec_rotate_by(vector_t v, rot_t rot) {
+  return (vector_t){v.x * rot.cos - v.y * rot.sin,
+                    v.x * rot.sin + v.y * rot.cos};
+}
 
 /**
  * Rotates a vector by an angle around (0, 0).
@@ -102,6 +157,30 @@ double vec_cross(vector_t v1, vector_t v2);
  * @param angle the angle to rotate the vector
  * @return v rotated by the given angle
  */
-vector_t vec_rotate(vector_t v, double angle);
+static inline vector_t vec_rotate(vector_t v, real_t angle) {
+  return vec_rotate_by(v, rot_init(angle));
+}
+
+#ifdef PHYSICS_FIXED
+/**
+ * Converts a vector to fixed point, for the deterministic physics mode.
+ *
+ * @param v the vector
+ * @return the nearest fixed-point vector
+ */
+static inline fixed_vector_t vec_to_fixed(vector_t v) {
+  return fixed_vec_from(v.x, v.y);
+}
+
+/**
+ * Converts a fixed-point vector back to a vector.
+ *
+ * @param v the fixed-point vector
+ * @return v as a vector_t
+ */
+static inline vector_t vec_from_fixed(fixed_vector_t v) {
+  return (vector_t){fixed_to_double(v.x), fixed_to_double(v.y)};
+}
+#endif
 
 #endif // #ifndef __VECTOR_H__
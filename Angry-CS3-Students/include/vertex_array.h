@@ -0,0 +1,101 @@
+#ifndef __VERTEX_ARRAY_H__
+#define __VERTEX_ARRAY_H__
+
+#include "list.h"
+#include "vector.h"
+#include <stddef.h>
+
+/**
+ * A fixed-size, packed array of vertices.
+ * The vertices are stored inline after the count, so a whole polygon lives in
+ * a single allocation and can be walked without chasing a pointer per vertex.
+ * vertex_array_t is defined here instead of vertex_array.c so that hot loops
+ * can index the vertices directly.
+ */
+typedef struct vertex_array {
+  size_t size;
+  vector_t data[];
+} vertex_array_t;
+
+/**
+ * Allocates a vertex array with room for the given number of vertices.
+ * The vertices are initialized to VEC_ZERO.
+ * Asserts that the required memory was allocated.
+ *
+ * @param size the number of vertices in the array
+ * @return a pointer to the newly allocated vertex array
+ */
+vertex_array_t *vertex_array_init(size_t size);
+
+/**
+ * Allocates a vertex array holding a copy of the given vertices.
+ *
+ * @param points the vertices to copy
+ * @param size the number of vertices in points
+ * @return a pointer to the newly allocated vertex array
+ */
+vertex_array_t *vertex_array_from(const vector_t *points, size_t size);
+
+/**
+ * Allocates a vertex array holding a copy of a list of vector_t pointers.
+ * The list is not modified.
+ *
+ * @param list a list of vector_t* returned from list_init()
+ * @return a pointer to the newly allocated vertex array
+ */
+vertex_array_t *vertex_array_from_list(list_t *list);
+
+/**
+ * Allocates a list of individually allocated vector_t* holding the vertices,
+ * for callers that still expect the list_t representation.
+ * The list's freer is free(), so the result must be list_free()d.
+ *
+ * @param array a pointer to a vertex array
+ * @return the newly allocated list
+ */
+list_t *vertex_array_to_list(const vertex_array_t *array);
+
+/**
+ * Allocates a copy of a vertex array.
+ *
+ * @param array a pointer to a vertex array
+ * @return a pointer to the newly allocated copy
+ */
+vertex_array_t *vertex_array_copy(const vertex_array_t *array);
+
+/**
+ * Releases the memory allocated for a vertex array.
+ *
+ * @param array a pointer to a vertex array returned from vertex_array_init()
+ */
+void vertex_array_free(vertex_array_t *array);
+
+/**
+ * Gets the number of vertices in a vertex array.
+ *
+ * @param array a pointer to a vertex array
+ * @return the number of vertices
+ */
+size_t vertex_array_size(const vertex_array_t *array);
+
+/**
+ * Gets the vertex at a given index.
+ * Asserts that the index is valid.
+ *
+ * @param array a pointer to a vertex array
+ * @param index an index in the array (the first vertex is at 0)
+ * @return the vertex at the given index
+ */
+vector_t vertex_array_get(const vertex_array_t *array, size_t index);
+
+/**
+ * Replaces the vertex at a given index.
+ * Asserts that the index is valid.
+ *
+ * @param array a pointer to a vertex array
+ * @param index an index in the array (the first vertex is at 0)
+ * @param vertex the new value of the vertex
+ */
+void vertex_array_set(vertex_array_t *array, size_t index, vector_t vertex);
+
+#endif // #ifndef __VERTEX_ARRAY_H__
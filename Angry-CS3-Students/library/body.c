@@ -1,148 +1,585 @@
 #include "body.h"
 #include "polygon.h"
+#include "pool.h"
 #include "sdl_wrapper.h"
+#include "vec_batch.h"
 #include <assert.h>
 #include <math.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
-
-const double TRANSLATION_CONSTANT = 0.5;
+#include <string.h>
+
+const real_t TRANSLATION_CONSTANT = 0.5;
+// Bodies per slab of the body pool
+const size_t BODY_SLAB_OBJECTS = 64;
+// A handle is a slot in the handle table in its low bits and the slot's
+// generation in the rest, so there can be 2^20 bodies at once and a slot
+// can be reused 2^12 - 1 times before its old handles alias new ones
+#define HANDLE_INDEX_BITS 20
+const uint32_t HANDLE_INDEX_MASK = (1u << HANDLE_INDEX_BITS) - 1;
+const uint32_t MAX_GENERATION = (1u << (32 - HANDLE_INDEX_BITS)) - 1;
+// Marks the end of the handle table's free list
+const uint32_t NO_FREE_SLOT = UINT32_MAX;
+
+// Rendering and game state, which the physics never reads. Kept out of
+// body_t so that ticking a scene does not pull it into the cache.
+typedef struct body_cold {
+  rgb_color_t color;
+  void *info;
+  free_func_t info_freer;
+  void *image;
+} body_cold_t;
 
 typedef struct body {
-  list_t *shape;
-  vector_t centroid;
+  // Everything body_tick() reads or writes comes first, so that
+  // integrating a body touches as few cache lines as possible
   vector_t velocity;
   vector_t force;
   vector_t impulse;
-  rgb_color_t color;
-  void *info;
-  free_func_t info_freer;
-  double mass;
+  vector_t centroid;
+  real_t inverse_mass;
+  bool world_dirty;
   bool removed;
-  void* image;
+  // Then the geometry, which is only needed for collisions.
+  // The shape is in local space, relative to the centroid at angle 0,
+  // and may be shared with other bodies, so it is never modified.
+  real_t mass;
+  real_t angle;
+  rot_t rotation;
+  shape_t *shape;
+  // The world-space vertices, allocated on first use and rebuilt from the
+  // shape when world_dirty is set
+  vertex_array_t *world_shape;
+  // The shape's bounding box turned with the body and boxed again,
+  // as its center relative to the centroid and its half size.
+  // Only changed by rotating or reshaping, so moving the body is free.
+  vector_t box_offset;
+  vector_t box_half;
+  // The shape's separating axes rotated into world space, allocated on
+  // first use and rebuilt when axes_dirty is set. Unused at angle 0.
+  vertex_array_t *world_axes;
+  bool axes_dirty;
+  body_cold_t *cold;
+  // If non-NULL, the store that holds the body's linear state in its slot.
+  // The fields above are then only a copy, refreshed by body_load().
+  body_store_t *store;
+  size_t slot;
+  body_handle_t handle;
+  size_t tag;
+  bool collidable;
 } body_t;
 
-body_t *body_init(list_t *shape, double mass, rgb_color_t color) {
+typedef struct body_store {
+  particle_arrays_t arrays;
+  // The body in each slot
+  body_t **owners;
+  size_t size;
+  size_t capacity;
+  // The number of stored bodies that are marked for removal
+  size_t removed;
+} body_store_t;
+
+// Bodies are created before they are added to a scene, so they share one
+// pool for the whole program rather than one per scene.
+// body_free_pools() releases it.
+static pool_t *hot_pool = NULL;
+
+pool_t *body_pool(void) {
+  if (hot_pool == NULL) {
+    hot_pool = pool_init(sizeof(body_t), BODY_SLAB_OBJECTS);
+  }
+  return hot_pool;
+}
+
+// An entry in the handle table. Generations start at 1, so no valid handle
+// is BODY_HANDLE_NONE.
+typedef struct handle_slot {
+  // NULL while the slot is free
+  body_t *body;
+  uint32_t generation;
+  // The next free slot, while this one is free
+  uint32_t next_free;
+} handle_slot_t;
+
+DEFINE_ARRAY(handle_slot, handle_slot_t)
+
+typedef struct handle_table {
+  handle_slot_array_t slots;
+  uint32_t first_free;
+} handle_table_t;
+
+// Handles outlive scenes, so like the body pool there is one table
+static handle_table_t table;
+static bool table_initialized = false;
+
+handle_table_t *handle_table(void) {
+  if (!table_initialized) {
+    handle_slot_array_init(&table.slots, BODY_SLAB_OBJECTS);
+    table.first_free = NO_FREE_SLOT;
+    table_initialized = true;
+  }
+  return &table;
+}
+
+body_handle_t handle_acquire(body_t *body) {
+  handle_table_t *table = handle_table();
+  uint32_t index = table->first_free;
+  if (index != NO_FREE_SLOT) {
+    table->first_free = handle_slot_array_at(&table->slots, index)->next_free;
+  } else {
+    index = handle_slot_array_size(&table->slots);
+    assert(index <= HANDLE_INDEX_MASK);
+    handle_slot_t slot = {.body = NULL, .generation = 1};
+    handle_slot_array_push(&table->slots, slot);
+  }
+  handle_slot_t *slot = handle_slot_array_at(&table->slots, index);
+  slot->body = body;
+  return slot->generation << HANDLE_INDEX_BITS | index;
+}
+
+void handle_release(body_handle_t handle) {
+  handle_table_t *table = handle_table();
+  uint32_t index = handle & HANDLE_INDEX_MASK;
+  handle_slot_t *slot = handle_slot_array_at(&table->slots, index);
+  slot->body = NULL;
+  slot->generation =
+      slot->generation == MAX_GENERATION ? 1 : slot->generation + 1;
+  slot->next_free = table->first_free;
+  table->first_free = index;
+}
+
+// The cold records get their own pool so that they do not sit between the
+// bodies in memory
+static pool_t *cold_pool = NULL;
+
+pool_t *body_cold_pool(void) {
+  if (cold_pool == NULL) {
+    cold_pool = pool_init(sizeof(body_cold_t), BODY_SLAB_OBJECTS);
+  }
+  return cold_pool;
+}
+
+void body_free_pools(void) {
+  if (hot_pool != NULL) {
+    assert(pool_live(hot_pool) == 0);
+    pool_free(hot_pool);
+    hot_pool = NULL;
+  }
+  if (cold_pool != NULL) {
+    pool_free(cold_pool);
+    cold_pool = NULL;
+  }
+  if (table_initialized) {
+    handle_slot_array_free(&table.slots);
+    table_initialized = false;
+  }
+}
+
+// Copies a stored body's linear state from its slot into its own fields,
+// marking the world shape dirty if the body has moved
+void body_load(body_t *body) {
+  body_store_t *store = body->store;
+  if (store == NULL) {
+    return;
+  }
+  particle_arrays_t *a = &store->arrays;
+  size_t i = body->slot;
+  vector_t centroid = {a->pos_x[i], a->pos_y[i]};
+  if (centroid.x != body->centroid.x || centroid.y != body->centroid.y) {
+    body->centroid = centroid;
+    body->world_dirty = true;
+  }
+  body->velocity = (vector_t){a->vel_x[i], a->vel_y[i]};
+  body->force = (vector_t){a->force_x[i], a->force_y[i]};
+  body->impulse = (vector_t){a->impulse_x[i], a->impulse_y[i]};
+  body->inverse_mass = a->inv_mass[i];
+}
+
+// Copies a stored body's own fields back into its slot
+void body_save(body_t *body) {
+  body_store_t *store = body->store;
+  if (store == NULL) {
+    return;
+  }
+  particle_arrays_t *a = &store->arrays;
+  size_t i = body->slot;
+  a->pos_x[i] = body->centroid.x;
+  a->pos_y[i] = body->centroid.y;
+  a->vel_x[i] = body->velocity.x;
+  a->vel_y[i] = body->velocity.y;
+  a->force_x[i] = body->force.x;
+  a->force_y[i] = body->force.y;
+  a->impulse_x[i] = body->impulse.x;
+  a->impulse_y[i] = body->impulse.y;
+  a->inv_mass[i] = body->inverse_mass;
+}
+
+// Turns the shape's local bounding box by the body's rotation
+static void update_box(body_t *body) {
+  aabb_t local = body->shape->bounds;
+  vector_t center = vec_multiply(0.5, vec_add(local.min, local.max));
+  vector_t half = vec_multiply(0.5, vec_subtract(local.max, local.min));
+  rot_t rotation = body->rotation;
+  real_t abs_cos = rotation.cos < 0 ? -rotation.cos : rotation.cos;
+  real_t abs_sin = rotation.sin < 0 ? -rotation.sin : rotation.sin;
+  body->box_offset = vec_rotate_by(center, rotation);
+  body->box_half = (vector_t){abs_cos * half.x + abs_sin * half.y,
+                              abs_sin * half.x + abs_cos * half.y};
+}
+
+body_t *body_init(list_t *shape, real_t mass, rgb_color_t color) {
   body_t *new_shape = body_init_with_info(shape, mass, color, NULL, NULL);
   return new_shape;
 }
 
-body_t *body_init_with_info(list_t *shape, double mass, rgb_color_t color,
+body_t *body_init_with_info(list_t *shape, real_t mass, rgb_color_t color,
                             void *info, free_func_t info_freer) {
-  body_t *new_shape = malloc(sizeof(body_t));
-  assert(new_shape != NULL);
+  assert(shape != NULL);
+  vertex_array_t *vertices = vertex_array_from_list(shape);
+  list_free(shape);
+  return body_init_with_vertices(vertices, mass, color, info, info_freer);
+}
+
+body_t *body_init_with_vertices(vertex_array_t *shape, real_t mass,
+                                rgb_color_t color, void *info,
+                                free_func_t info_freer) {
+  assert(shape != NULL);
+  vector_t centroid = polygon_array_centroid(shape);
+  polygon_array_translate(shape, vec_negate(centroid));
+  shape_t *local = shape_init(shape);
+  body_t *body = body_init_with_shape(local, mass, color, info, info_freer);
+  // The body took its own reference
+  shape_release(local);
+  body->centroid = centroid;
+  return body;
+}
+
+body_t *body_init_with_shape(shape_t *shape, real_t mass, rgb_color_t color,
+                             void *info, free_func_t info_freer) {
+  body_t *new_shape = pool_alloc(body_pool());
 
-  new_shape->shape = shape;
-  assert(new_shape->shape != NULL);
+  assert(shape != NULL);
 
   assert(mass > 0); // does not make sense to have negative mass
   new_shape->mass = mass;
+  new_shape->inverse_mass = 1 / mass;
 
   vector_t force = {0.0, 0.0};
   vector_t impulse = {0.0, 0.0};
   vector_t velocity = {0.0, 0.0};
 
-  new_shape->centroid = polygon_centroid(shape);
-  new_shape->color = color;
+  new_shape->shape = shape_retain(shape);
+  new_shape->world_shape = NULL;
+  new_shape->world_dirty = true;
+  new_shape->world_axes = NULL;
+  new_shape->axes_dirty = true;
+  new_shape->centroid = VEC_ZERO;
+  new_shape->angle = 0;
+  new_shape->rotation = rot_init(0);
   new_shape->velocity = velocity;
   new_shape->force = force;
   new_shape->impulse = impulse;
   new_shape->removed = false;
-  new_shape->info = info;
-  new_shape->info_freer = info_freer;
-  new_shape->image = NULL;
+  new_shape->store = NULL;
+  new_shape->slot = 0;
+  new_shape->handle = handle_acquire(new_shape);
+  new_shape->tag = BODY_NO_TAG;
+  new_shape->collidable = false;
+  update_box(new_shape);
+
+  body_cold_t *cold = pool_alloc(body_cold_pool());
+  cold->color = color;
+  cold->info = info;
+  cold->info_freer = info_freer;
+  cold->image = NULL;
+  new_shape->cold = cold;
 
   return new_shape;
 }
 
-void body_set_shape(body_t *body, list_t* shape) {
-  list_free(body->shape);
-  body->shape = shape;
+void body_set_shape(body_t *body, list_t *shape) {
+  body_set_vertices(body, vertex_array_from_list(shape));
+  list_free(shape);
 }
 
-void body_set_mass(body_t *body, double mass) { body->mass = mass; }
-double body_get_mass(body_t *body) { return body->mass; }
+void body_set_vertices(body_t *body, vertex_array_t *shape) {
+  // The new vertices are the current world shape, so keep them as the cache
+  // and undo the body's transform to get the local shape
+  if (body->world_shape != NULL) {
+    vertex_array_free(body->world_shape);
+  }
+  body->world_shape = vertex_array_copy(shape);
+  body->world_dirty = false;
+  body->centroid = body_get_centroid(body);
+  polygon_array_translate(shape, vec_negate(body->centroid));
+  rot_t inverse = {.cos = body->rotation.cos, .sin = -body->rotation.sin};
+  vector_t *v = shape->data;
+  vec_rotate_n(&v->x, &v->y, 2, shape->size, inverse, VEC_ZERO);
+  shape_release(body->shape);
+  body->shape = shape_init(shape);
+  update_box(body);
+  // The new shape may have a different number of axes
+  if (body->world_axes != NULL) {
+    vertex_array_free(body->world_axes);
+    body->world_axes = NULL;
+  }
+  body->axes_dirty = true;
+}
 
-list_t *body_get_shape(body_t *body) {
-  list_t *copy = list_init(list_size(body->shape), free);
-  for (int i = 0; i < list_size(body->shape); i++) {
-    vector_t *element = list_get(body->shape, i);
-    vector_t *copy_elem = malloc(sizeof(vector_t));
+void body_set_mass(body_t *body, real_t mass) {
+  body->mass = mass;
+  body->inverse_mass = 1 / mass;
+  if (body->store != NULL) {
+    body->store->arrays.inv_mass[body->slot] = body->inverse_mass;
+  }
+}
+real_t body_get_mass(body_t *body) { return body->mass; }
+
+real_t body_get_inertia(body_t *body) {
+  return body->mass * body->shape->inertia / body->shape->area;
+}
 
-    copy_elem->x = element->x;
-    copy_elem->y = element->y;
-    list_add(copy, copy_elem);
+const shape_t *body_get_local_shape(body_t *body) { return body->shape; }
+
+const vertex_array_t *body_shape_view(body_t *body) {
+  // A store moves its bodies without telling them
+  body_load(body);
+  if (body->world_dirty) {
+    const vertex_array_t *local = body->shape->vertices;
+    if (body->world_shape == NULL) {
+      body->world_shape = vertex_array_init(local->size);
+    }
+    vertex_array_t *world = body->world_shape;
+    vector_t *v = world->data;
+    memcpy(v, local->data, sizeof(vector_t) * world->size);
+    if (body->angle != 0) {
+      vec_rotate_n(&v->x, &v->y, 2, world->size, body->rotation, VEC_ZERO);
+    }
+    vec_translate_n(&v->x, &v->y, 2, world->size, body->centroid);
+    body->world_dirty = false;
   }
+  return body->world_shape;
+}
 
-  return copy;
+aabb_t body_get_bounds(body_t *body) {
+  vector_t center = vec_add(body_get_centroid(body), body->box_offset);
+  return (aabb_t){vec_subtract(center, body->box_half),
+                  vec_add(center, body->box_half)};
 }
 
-vector_t body_get_centroid(body_t *body) { return body->centroid; }
+real_t body_get_radius(body_t *body) { return body->shape->radius; }
 
-vector_t body_get_velocity(body_t *body) { return body->velocity; }
+const vertex_array_t *body_axes_view(body_t *body) {
+  // Axes are directions, so moving the body does not change them
+  if (body->angle == 0) {
+    return body->shape->axes;
+  }
+  if (body->axes_dirty) {
+    const vertex_array_t *local = body->shape->axes;
+    if (body->world_axes == NULL) {
+      body->world_axes = vertex_array_init(local->size);
+    }
+    vertex_array_t *world = body->world_axes;
+    vector_t *v = world->data;
+    memcpy(v, local->data, sizeof(vector_t) * world->size);
+    vec_rotate_n(&v->x, &v->y, 2, world->size, body->rotation, VEC_ZERO);
+    body->axes_dirty = false;
+  }
+  return body->world_axes;
+}
 
-void* body_get_image(body_t *body) { return body->image; }
+list_t *body_get_shape(body_t *body) {
+  return vertex_array_to_list(body_shape_view(body));
+}
+
+vertex_array_t *body_get_vertices(body_t *body) {
+  return vertex_array_copy(body_shape_view(body));
+}
+
+vector_t body_get_centroid(body_t *body) {
+  body_store_t *store = body->store;
+  if (store != NULL) {
+    return (vector_t){store->arrays.pos_x[body->slot],
+                      store->arrays.pos_y[body->slot]};
+  }
+  return body->centroid;
+}
+
+vector_t body_get_velocity(body_t *body) {
+  body_store_t *store = body->store;
+  if (store != NULL) {
+    return (vector_t){store->arrays.vel_x[body->slot],
+                      store->arrays.vel_y[body->slot]};
+  }
+  return body->velocity;
+}
+
+void* body_get_image(body_t *body) { return body->cold->image; }
 
 void body_free(body_t *body) {
-  list_free(body->shape);
-  if (body->info_freer != NULL) {
-    body->info_freer(body->info);
+  if (body->store != NULL) {
+    body_store_remove(body->store, body);
+  }
+  handle_release(body->handle);
+  shape_release(body->shape);
+  if (body->world_shape != NULL) {
+    vertex_array_free(body->world_shape);
+  }
+  if (body->world_axes != NULL) {
+    vertex_array_free(body->world_axes);
   }
-  if (body->image != NULL) {
-    sdl_destroy_texture(body->image);
+  body_cold_t *cold = body->cold;
+  if (cold->info_freer != NULL) {
+    cold->info_freer(cold->info);
+  }
+  if (cold->image != NULL) {
+    sdl_destroy_texture(cold->image);
   }
 
-  free(body);
+  pool_release(cold);
+  pool_release(body);
 }
 
-rgb_color_t body_get_color(body_t *figure) { return figure->color; }
+rgb_color_t body_get_color(body_t *figure) { return figure->cold->color; }
 
-void *body_get_info(body_t *body) { return body->info; }
+void *body_get_info(body_t *body) { return body->cold->info; }
 
 bool body_is_removed(body_t *body) { return body->removed; }
 
-void body_remove(body_t *body) { body->removed = true; }
+void body_set_tag(body_t *body, size_t tag) {
+  assert(tag < BODY_MAX_TAGS);
+  body->tag = tag;
+}
+
+size_t body_get_tag(body_t *body) { return body->tag; }
+
+void body_set_collidable(body_t *body, bool collidable) {
+  body->collidable = collidable;
+}
+
+bool body_is_collidable(body_t *body) { return body->collidable; }
+
+body_handle_t body_get_handle(body_t *body) { return body->handle; }
+
+size_t body_handle_slot(body_handle_t handle) {
+  return handle & HANDLE_INDEX_MASK;
+}
+
+body_t *body_from_handle(body_handle_t handle) {
+  handle_table_t *table = handle_table();
+  uint32_t index = handle & HANDLE_INDEX_MASK;
+  if (index >= handle_slot_array_size(&table->slots)) {
+    return NULL;
+  }
+  handle_slot_t slot = handle_slot_array_get(&table->slots, index);
+  if (slot.generation != handle >> HANDLE_INDEX_BITS) {
+    return NULL;
+  }
+  return slot.body;
+}
+
+void body_remove(body_t *body) {
+  if (!body->removed && body->store != NULL) {
+    body->store->removed++;
+  }
+  body->removed = true;
+}
 
 void body_set_centroid(body_t *body, vector_t x) {
-  vector_t translate = vec_subtract(x, body->centroid);
-  polygon_translate(body->shape, translate);
   body->centroid = x;
+  body->world_dirty = true;
+  body_store_t *store = body->store;
+  if (store != NULL) {
+    store->arrays.pos_x[body->slot] = x.x;
+    store->arrays.pos_y[body->slot] = x.y;
+  }
 }
 
-void body_set_velocity(body_t *body, vector_t v) { body->velocity = v; }
+void body_set_velocity(body_t *body, vector_t v) {
+  body->velocity = v;
+  body_store_t *store = body->store;
+  if (store != NULL) {
+    store->arrays.vel_x[body->slot] = v.x;
+    store->arrays.vel_y[body->slot] = v.y;
+  }
+}
 
-void body_set_rotation(body_t *body, double angle) {
-  polygon_rotate(body->shape, angle, body->centroid);
+void body_set_rotation(body_t *body, real_t angle) {
+  body->angle = angle;
+  body->rotation = rot_init(angle);
+  body->world_dirty = true;
+  body->axes_dirty = true;
+  update_box(body);
 }
 
 void body_set_color(body_t *body, rgb_color_t *color) {
-  body->color = *color;
+  body->cold->color = *color;
 }
 
 void body_add_image(body_t *body, char* path) {
-  body->image = sdl_get_texture(path);
+  body->cold->image = sdl_get_texture(path);
 }
 
 void body_add_force(body_t *body, vector_t force) {
+  body_store_t *store = body->store;
+  if (store != NULL) {
+    store->arrays.force_x[body->slot] += force.x;
+    store->arrays.force_y[body->slot] += force.y;
+    return;
+  }
   body->force = vec_add(body->force, force);
 }
 
 void body_add_impulse(body_t *body, vector_t impulse) {
+  body_store_t *store = body->store;
+  if (store != NULL) {
+    store->arrays.impulse_x[body->slot] += impulse.x;
+    store->arrays.impulse_y[body->slot] += impulse.y;
+    return;
+  }
   body->impulse = vec_add(body->impulse, impulse);
 }
 
 void body_tick(body_t *body, double dt) {
-  vector_t acceleration = vec_multiply(1 / body->mass, body->force);
-  vector_t mass_impulse = vec_multiply(1 / body->mass, body->impulse);
+  body_load(body);
+#ifdef PHYSICS_FIXED
+  // Same integration as below, in fixed point so that it is bit-exact
+  fixed_t inv_mass = body->mass == INFINITY
+                         ? 0
+                         : fixed_div(FIXED_ONE, fixed_from_double(body->mass));
+  fixed_t fixed_dt = fixed_from_double(dt);
+  fixed_vector_t velocity = vec_to_fixed(body->velocity);
+  fixed_vector_t acceleration =
+      fixed_vec_multiply(inv_mass, vec_to_fixed(body->force));
+  fixed_vector_t mass_impulse =
+      fixed_vec_multiply(inv_mass, vec_to_fixed(body->impulse));
+  fixed_vector_t added_vel =
+      fixed_vec_add(fixed_vec_multiply(fixed_dt, acceleration), mass_impulse);
+  fixed_vector_t fixed_velocity = fixed_vec_add(velocity, added_vel);
+  fixed_vector_t translate = fixed_vec_multiply(
+      fixed_mul(fixed_from_double(TRANSLATION_CONSTANT), fixed_dt),
+      fixed_vec_add(velocity, fixed_velocity));
+  vector_t new_velocity = vec_from_fixed(fixed_velocity);
+  vector_t centroid = vec_from_fixed(
+      fixed_vec_add(vec_to_fixed(body_get_centroid(body)), translate));
+#else
+  vector_t acceleration = vec_multiply(body->inverse_mass, body->force);
+  vector_t mass_impulse = vec_multiply(body->inverse_mass, body->impulse);
   vector_t added_vel = vec_add(vec_multiply(dt, acceleration), mass_impulse);
   vector_t new_velocity = vec_add(body->velocity, added_vel);
   vector_t translate = vec_multiply(TRANSLATION_CONSTANT * dt,
                                     vec_add(body->velocity, new_velocity));
   vector_t centroid = vec_add(body_get_centroid(body), translate);
+#endif
 
-  body_set_centroid(body, centroid);
+  // Resting bodies keep their world vertices
+  if (centroid.x != body->centroid.x || centroid.y != body->centroid.y) {
+    body->centroid = centroid;
+    body->world_dirty = true;
+  }
   body->velocity = new_velocity;
 
   // reset the forces and impulse
@@ -150,4 +587,89 @@ void body_tick(body_t *body, double dt) {
   body->force = force;
   vector_t impulse = {0.0, 0.0};
   body->impulse = impulse;
+  body_save(body);
+}
+
+// Reallocates every array of a store to hold capacity bodies
+void body_store_reserve(body_store_t *store, size_t capacity) {
+  particle_arrays_t *a = &store->arrays;
+  real_t **arrays[] = {&a->pos_x,   &a->pos_y,     &a->vel_x,
+                       &a->vel_y,   &a->force_x,   &a->force_y,
+                       &a->impulse_x, &a->impulse_y, &a->inv_mass};
+  for (size_t k = 0; k < sizeof(arrays) / sizeof(arrays[0]); k++) {
+    *arrays[k] = realloc(*arrays[k], sizeof(real_t) * capacity);
+    assert(*arrays[k] != NULL);
+  }
+  store->owners = realloc(store->owners, sizeof(body_t *) * capacity);
+  assert(store->owners != NULL);
+  store->capacity = capacity;
+}
+
+body_store_t *body_store_init(size_t capacity) {
+  body_store_t *store = calloc(1, sizeof(body_store_t));
+  assert(store != NULL);
+  body_store_reserve(store, capacity > 0 ? capacity : 1);
+  return store;
+}
+
+void body_store_free(body_store_t *store) {
+  while (store->size > 0) {
+    body_store_remove(store, store->owners[store->size - 1]);
+  }
+  particle_arrays_t *a = &store->arrays;
+  real_t *arrays[] = {a->pos_x,   a->pos_y,     a->vel_x,
+                      a->vel_y,   a->force_x,   a->force_y,
+                      a->impulse_x, a->impulse_y, a->inv_mass};
+  for (size_t k = 0; k < sizeof(arrays) / sizeof(arrays[0]); k++) {
+    free(arrays[k]);
+  }
+  free(store->owners);
+  free(store);
+}
+
+size_t body_store_size(body_store_t *store) { return store->size; }
+
+size_t body_store_removed(body_store_t *store) { return store->removed; }
+
+void body_store_add(body_store_t *store, body_t *body) {
+  assert(body->store == NULL);
+  if (store->size == store->capacity) {
+    body_store_reserve(store, store->capacity * 2);
+  }
+  body->store = store;
+  body->slot = store->size++;
+  store->owners[body->slot] = body;
+  body_save(body);
+  if (body->removed) {
+    store->removed++;
+  }
+}
+
+void body_store_remove(body_store_t *store, body_t *body) {
+  assert(body->store == store);
+  body_load(body);
+  if (body->removed) {
+    store->removed--;
+  }
+  // Move the last body into the hole, so the slots stay contiguous
+  size_t slot = body->slot;
+  body_t *last = store->owners[--store->size];
+  if (last != body) {
+    body_load(last);
+    last->slot = slot;
+    store->owners[slot] = last;
+    body_save(last);
+  }
+  body->store = NULL;
+}
+
+void body_store_tick(body_store_t *store, double dt) {
+#ifdef PHYSICS_FIXED
+  // The kernel works in real_t, so keep body_tick()'s fixed-point arithmetic
+  for (size_t i = 0; i < store->size; i++) {
+    body_tick(store->owners[i], dt);
+  }
+#else
+  vec_integrate_n(&store->arrays, store->size, dt);
+#endif
 }
@@ -0,0 +1,957 @@
+#include "broadphase.h"
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// Boxes covering more cells than this are tested against every box
+const size_t MAX_BOX_CELLS = 256;
+// Cell coordinates are clamped to this range so that far-away boxes
+// cannot overflow them
+const double MAX_CELL_COORD = 1 << 30;
+// The fewest hash buckets a grid uses
+const size_t MIN_BUCKETS = 16;
+
+// One cell covered by one box
+typedef struct cell_entry {
+  int32_t x;
+  int32_t y;
+  size_t box;
+} cell_entry_t;
+
+DEFINE_ARRAY(cell_entry, cell_entry_t)
+DEFINE_ARRAY(index, size_t)
+
+typedef struct grid {
+  real_t cell_size;
+  // The cells each box covers, in box order
+  cell_entry_array_t entries;
+  // The same entries grouped by hash bucket
+  cell_entry_array_t sorted;
+  // Where each bucket starts in sorted, and then where the next one starts
+  index_array_t starts;
+  // The boxes too big to enter in the grid
+  index_array_t oversized;
+} grid_t;
+
+aabb_t aabb_of(const vertex_array_t *vertices) {
+  assert(vertices->size > 0);
+  aabb_t box = {vertices->data[0], vertices->data[0]};
+  for (size_t i = 1; i < vertices->size; i++) {
+    vector_t v = vertices->data[i];
+    box.min.x = v.x < box.min.x ? v.x : box.min.x;
+    box.min.y = v.y < box.min.y ? v.y : box.min.y;
+    box.max.x = v.x > box.max.x ? v.x : box.max.x;
+    box.max.y = v.y > box.max.y ? v.y : box.max.y;
+  }
+  return box;
+}
+
+bool aabb_overlap(aabb_t box1, aabb_t box2) {
+  return box1.min.x <= box2.max.x && box2.min.x <= box1.max.x &&
+         box1.min.y <= box2.max.y && box2.min.y <= box1.max.y;
+}
+
+grid_t *grid_init(real_t cell_size) {
+  assert(cell_size > 0);
+  grid_t *grid = malloc(sizeof(grid_t));
+  assert(grid != NULL);
+  grid->cell_size = cell_size;
+  cell_entry_array_init(&grid->entries, 0);
+  cell_entry_array_init(&grid->sorted, 0);
+  index_array_init(&grid->starts, 0);
+  index_array_init(&grid->oversized, 0);
+  return grid;
+}
+
+void grid_free(grid_t *grid) {
+  cell_entry_array_free(&grid->entries);
+  cell_entry_array_free(&grid->sorted);
+  index_array_free(&grid->starts);
+  index_array_free(&grid->oversized);
+  free(grid);
+}
+
+// The cell that a coordinate falls in, along one axis
+int32_t cell_coord(real_t coord, real_t cell_size) {
+  double cell = floor((double)coord / cell_size);
+  if (cell > MAX_CELL_COORD) {
+    cell = MAX_CELL_COORD;
+  } else if (cell < -MAX_CELL_COORD) {
+    cell = -MAX_CELL_COORD;
+  }
+  return (int32_t)cell;
+}
+
+size_t cell_hash(int32_t x, int32_t y, size_t n_buckets) {
+  uint32_t hash = (uint32_t)x * 73856093u ^ (uint32_t)y * 19349663u;
+  // n_buckets is a power of 2
+  return hash & (n_buckets - 1);
+}
+
+int compare_pairs(const void *a, const void *b) {
+  const box_pair_t *pair1 = a;
+  const box_pair_t *pair2 = b;
+  if (pair1->first != pair2->first) {
+    return pair1->first < pair2->first ? -1 : 1;
+  }
+  if (pair1->second != pair2->second) {
+    return pair1->second < pair2->second ? -1 : 1;
+  }
+  return 0;
+}
+
+void push_pair(box_pair_array_t *pairs, size_t box1, size_t box2) {
+  box_pair_t pair = {box1 < box2 ? box1 : box2, box1 < box2 ? box2 : box1};
+  box_pair_array_push(pairs, pair);
+}
+
+void grid_find_pairs(grid_t *grid, const aabb_t *boxes, size_t n_boxes,
+                     box_pair_array_t *pairs) {
+  real_t cell_size = grid->cell_size;
+  cell_entry_array_t *entries = &grid->entries;
+  index_array_t *oversized = &grid->oversized;
+  box_pair_array_truncate(pairs, 0);
+  cell_entry_array_truncate(entries, 0);
+  index_array_truncate(oversized, 0);
+
+  for (size_t i = 0; i < n_boxes; i++) {
+    int32_t x0 = cell_coord(boxes[i].min.x, cell_size);
+    int32_t y0 = cell_coord(boxes[i].min.y, cell_size);
+    int32_t x1 = cell_coord(boxes[i].max.x, cell_size);
+    int32_t y1 = cell_coord(boxes[i].max.y, cell_size);
+    // The clamped coordinates span up to 2^31 cells, which overflows int32_t
+    uint64_t n_cells =
+        ((uint64_t)((int64_t)x1 - x0) + 1) * ((uint64_t)((int64_t)y1 - y0) + 1);
+    if (n_cells > MAX_BOX_CELLS) {
+      index_array_push(oversized, i);
+      continue;
+    }
+    for (int32_t x = x0; x <= x1; x++) {
+      for (int32_t y = y0; y <= y1; y++) {
+        cell_entry_array_push(entries, (cell_entry_t){x, y, i});
+      }
+    }
+  }
+
+  // Group the entries by bucket with a counting sort
+  size_t n_entries = cell_entry_array_size(entries);
+  size_t n_buckets = MIN_BUCKETS;
+  while (n_buckets < n_entries) {
+    n_buckets *= 2;
+  }
+  index_array_t *starts = &grid->starts;
+  index_array_reserve(starts, n_buckets + 1);
+  starts->size = n_buckets + 1;
+  for (size_t b = 0; b <= n_buckets; b++) {
+    starts->data[b] = 0;
+  }
+  for (size_t i = 0; i < n_entries; i++) {
+    cell_entry_t entry = cell_entry_array_get(entries, i);
+    starts->data[cell_hash(entry.x, entry.y, n_buckets) + 1]++;
+  }
+  for (size_t b = 0; b < n_buckets; b++) {
+    starts->data[b + 1] += starts->data[b];
+  }
+  cell_entry_array_t *sorted = &grid->sorted;
+  cell_entry_array_reserve(sorted, n_entries);
+  sorted->size = n_entries;
+  for (size_t i = 0; i < n_entries; i++) {
+    cell_entry_t entry = cell_entry_array_get(entries, i);
+    // Each bucket's start moves up as it is filled...
+    sorted->data[starts->data[cell_hash(entry.x, entry.y, n_buckets)]++] =
+        entry;
+  }
+  // ...to where the next bucket starts, so shift the starts back
+  for (size_t b = n_buckets; b > 0; b--) {
+    starts->data[b] = starts->data[b - 1];
+  }
+  starts->data[0] = 0;
+
+  for (size_t b = 0; b < n_buckets; b++) {
+    for (size_t i = starts->data[b]; i < starts->data[b + 1]; i++) {
+      cell_entry_t entry1 = sorted->data[i];
+      aabb_t box1 = boxes[entry1.box];
+      for (size_t j = i + 1; j < starts->data[b + 1]; j++) {
+        cell_entry_t entry2 = sorted->data[j];
+        aabb_t box2 = boxes[entry2.box];
+        // Other cells can hash to the same bucket
+        if (entry1.x != entry2.x || entry1.y != entry2.y ||
+            !aabb_overlap(box1, box2)) {
+          continue;
+        }
+        // Overlapping boxes share every cell their overlap covers; only
+        // report them from the cell holding the overlap's lower corner
+        real_t corner_x = box1.min.x > box2.min.x ? box1.min.x : box2.min.x;
+        real_t corner_y = box1.min.y > box2.min.y ? box1.min.y : box2.min.y;
+        if (cell_coord(corner_x, cell_size) == entry1.x &&
+            cell_coord(corner_y, cell_size) == entry1.y) {
+          push_pair(pairs, entry1.box, entry2.box);
+        }
+      }
+    }
+  }
+
+  for (size_t i = 0; i < index_array_size(oversized); i++) {
+    size_t big = index_array_get(oversized, i);
+    for (size_t other = 0; other < n_boxes; other++) {
+      // Pairs of oversized boxes are tested from the first of them
+      bool other_oversized = false;
+      for (size_t k = 0; k <= i && !other_oversized; k++) {
+        other_oversized = index_array_get(oversized, k) == other;
+      }
+      if (!other_oversized && aabb_overlap(boxes[big], boxes[other])) {
+        push_pair(pairs, big, other);
+      }
+    }
+  }
+
+  if (box_pair_array_size(pairs) > 1) {
+    qsort(pairs->data, box_pair_array_size(pairs), sizeof(box_pair_t),
+          compare_pairs);
+  }
+}
+
+// The key of a pair in a sweep's pair set, with the smaller proxy in the
+// high bits so that keys sort like pairs
+uint64_t pair_key(size_t proxy1, size_t proxy2) {
+  uint64_t first = proxy1 < proxy2 ? proxy1 : proxy2;
+  uint64_t second = proxy1 < proxy2 ? proxy2 : proxy1;
+  return first << 32 | second;
+}
+
+// Marks an unused slot of a pair set
+const uint64_t NO_PAIR = UINT64_MAX;
+
+// One end of a box along one axis
+typedef struct endpoint {
+  real_t value;
+  size_t proxy;
+  bool is_max;
+} endpoint_t;
+
+DEFINE_ARRAY(endpoint, endpoint_t)
+DEFINE_ARRAY(pair_key, uint64_t)
+DEFINE_ARRAY(flag, bool)
+
+typedef struct sweep {
+  // The box of each proxy, and whether the proxy is in use
+  aabb_array_t boxes;
+  flag_array_t live;
+  // The ends of the live boxes, sorted along x and along y
+  endpoint_array_t axes[2];
+  // The overlapping pairs, as an open-addressed hash set of pair keys
+  // whose capacity is a power of 2
+  pair_key_array_t pairs;
+  size_t n_pairs;
+  // Every pair added to or removed from the set since the last update,
+  // including ones that have since been removed or added back
+  pair_key_array_t added;
+  pair_key_array_t removed;
+  // Proxies that can be reused, and proxies removed since the last update,
+  // which cannot be reused until their pairs have been reported
+  index_array_t free_proxies;
+  index_array_t removed_proxies;
+} sweep_t;
+
+// Where a pair key goes in a pair set if there are no collisions
+size_t pair_home(uint64_t key, size_t capacity) {
+  return (size_t)((key * 0x9E3779B97F4A7C15u) >> 32) & (capacity - 1);
+}
+
+// Finds a pair in a sweep's set, returning its slot or the empty slot
+// where it would go
+size_t pair_find(sweep_t *sweep, uint64_t key) {
+  size_t mask = pair_key_array_size(&sweep->pairs) - 1;
+  size_t slot = pair_home(key, mask + 1);
+  while (sweep->pairs.data[slot] != key && sweep->pairs.data[slot] != NO_PAIR) {
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+bool pair_contains(sweep_t *sweep, uint64_t key) {
+  return sweep->pairs.data[pair_find(sweep, key)] == key;
+}
+
+void pair_set_resize(sweep_t *sweep, size_t capacity) {
+  pair_key_array_t old = sweep->pairs;
+  pair_key_array_init(&sweep->pairs, capacity);
+  sweep->pairs.size = capacity;
+  for (size_t i = 0; i < capacity; i++) {
+    sweep->pairs.data[i] = NO_PAIR;
+  }
+  for (size_t i = 0; i < pair_key_array_size(&old); i++) {
+    if (old.data[i] != NO_PAIR) {
+      sweep->pairs.data[pair_find(sweep, old.data[i])] = old.data[i];
+    }
+  }
+  pair_key_array_free(&old);
+}
+
+// Adds a pair to a sweep's set if it is not there already
+void pair_insert(sweep_t *sweep, uint64_t key) {
+  // Keep the set at most half full so that probes stay short
+  if (2 * (sweep->n_pairs + 1) > pair_key_array_size(&sweep->pairs)) {
+    pair_set_resize(sweep, 2 * pair_key_array_size(&sweep->pairs));
+  }
+  size_t slot = pair_find(sweep, key);
+  if (sweep->pairs.data[slot] == NO_PAIR) {
+    sweep->pairs.data[slot] = key;
+    sweep->n_pairs++;
+    pair_key_array_push(&sweep->added, key);
+  }
+}
+
+// Removes a pair from a sweep's set if it is there
+void pair_erase(sweep_t *sweep, uint64_t key) {
+  size_t mask = pair_key_array_size(&sweep->pairs) - 1;
+  size_t hole = pair_find(sweep, key);
+  if (sweep->pairs.data[hole] == NO_PAIR) {
+    return;
+  }
+  sweep->n_pairs--;
+  pair_key_array_push(&sweep->removed, key);
+  // Shift later keys back into the hole unless that would put them before
+  // their home slot, so that no probe sequence is broken
+  for (size_t slot = (hole + 1) & mask; sweep->pairs.data[slot] != NO_PAIR;
+       slot = (slot + 1) & mask) {
+    size_t home = pair_home(sweep->pairs.data[slot], mask + 1);
+    if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+      sweep->pairs.data[hole] = sweep->pairs.data[slot];
+      hole = slot;
+    }
+  }
+  sweep->pairs.data[hole] = NO_PAIR;
+}
+
+sweep_t *sweep_init(void) {
+  sweep_t *sweep = malloc(sizeof(sweep_t));
+  assert(sweep != NULL);
+  aabb_array_init(&sweep->boxes, 0);
+  flag_array_init(&sweep->live, 0);
+  endpoint_array_init(&sweep->axes[0], 0);
+  endpoint_array_init(&sweep->axes[1], 0);
+  pair_key_array_init(&sweep->pairs, 0);
+  sweep->n_pairs = 0;
+  pair_set_resize(sweep, MIN_BUCKETS);
+  pair_key_array_init(&sweep->added, 0);
+  pair_key_array_init(&sweep->removed, 0);
+  index_array_init(&sweep->free_proxies, 0);
+  index_array_init(&sweep->removed_proxies, 0);
+  return sweep;
+}
+
+void sweep_free(sweep_t *sweep) {
+  aabb_array_free(&sweep->boxes);
+  flag_array_free(&sweep->live);
+  endpoint_array_free(&sweep->axes[0]);
+  endpoint_array_free(&sweep->axes[1]);
+  pair_key_array_free(&sweep->pairs);
+  pair_key_array_free(&sweep->added);
+  pair_key_array_free(&sweep->removed);
+  index_array_free(&sweep->free_proxies);
+  index_array_free(&sweep->removed_proxies);
+  free(sweep);
+}
+
+size_t sweep_add(sweep_t *sweep, aabb_t box) {
+  size_t proxy;
+  if (index_array_size(&sweep->free_proxies) > 0) {
+    proxy = index_array_pop(&sweep->free_proxies);
+    aabb_array_set(&sweep->boxes, proxy, box);
+    flag_array_set(&sweep->live, proxy, true);
+  } else {
+    proxy = aabb_array_size(&sweep->boxes);
+    aabb_array_push(&sweep->boxes, box);
+    flag_array_push(&sweep->live, true);
+  }
+  // The new ends go last, as if the box were far away, and the next update
+  // sorts them into place, finding the box's pairs on the way
+  for (size_t axis = 0; axis < 2; axis++) {
+    endpoint_array_push(&sweep->axes[axis], (endpoint_t){0, proxy, false});
+    endpoint_array_push(&sweep->axes[axis], (endpoint_t){0, proxy, true});
+  }
+  return proxy;
+}
+
+void sweep_move(sweep_t *sweep, size_t proxy, aabb_t box) {
+  assert(flag_array_get(&sweep->live, proxy));
+  aabb_array_set(&sweep->boxes, proxy, box);
+}
+
+void sweep_remove(sweep_t *sweep, size_t proxy) {
+  assert(flag_array_get(&sweep->live, proxy));
+  flag_array_set(&sweep->live, proxy, false);
+  for (size_t axis = 0; axis < 2; axis++) {
+    endpoint_array_t *ends = &sweep->axes[axis];
+    size_t kept = 0;
+    for (size_t i = 0; i < endpoint_array_size(ends); i++) {
+      endpoint_t end = endpoint_array_get(ends, i);
+      if (end.proxy != proxy) {
+        endpoint_array_set(ends, kept++, end);
+      }
+    }
+    endpoint_array_truncate(ends, kept);
+  }
+  for (size_t other = 0; other < flag_array_size(&sweep->live); other++) {
+    if (flag_array_get(&sweep->live, other)) {
+      pair_erase(sweep, pair_key(proxy, other));
+    }
+  }
+  index_array_push(&sweep->removed_proxies, proxy);
+}
+
+// Whether one end sorts before another.
+// At equal values minimums go first, so boxes that touch overlap.
+bool endpoint_before(endpoint_t end1, endpoint_t end2) {
+  return end1.value < end2.value ||
+         (end1.value == end2.value && !end1.is_max && end2.is_max);
+}
+
+// Re-sorts the ends along one axis, updating the pairs as ends pass
+void sweep_axis(sweep_t *sweep, size_t axis) {
+  endpoint_array_t *ends = &sweep->axes[axis];
+  size_t n = endpoint_array_size(ends);
+  endpoint_t *data = ends->data;
+  for (size_t i = 0; i < n; i++) {
+    aabb_t box = aabb_array_get(&sweep->boxes, data[i].proxy);
+    vector_t corner = data[i].is_max ? box.max : box.min;
+    data[i].value = axis == 0 ? corner.x : corner.y;
+  }
+
+  for (size_t i = 1; i < n; i++) {
+    endpoint_t end = data[i];
+    size_t j = i;
+    while (j > 0 && endpoint_before(end, data[j - 1])) {
+      endpoint_t passed = data[j - 1];
+      if (!end.is_max && passed.is_max) {
+        // The boxes start to overlap along this axis, so they overlap
+        // if they do along the other
+        if (aabb_overlap(aabb_array_get(&sweep->boxes, end.proxy),
+                         aabb_array_get(&sweep->boxes, passed.proxy))) {
+          pair_insert(sweep, pair_key(end.proxy, passed.proxy));
+        }
+      } else if (end.is_max && !passed.is_max) {
+        // The boxes stop overlapping along this axis
+        pair_erase(sweep, pair_key(end.proxy, passed.proxy));
+      }
+      data[j] = passed;
+      j--;
+    }
+    data[j] = end;
+  }
+}
+
+int compare_keys(const void *a, const void *b) {
+  uint64_t key1 = *(const uint64_t *)a;
+  uint64_t key2 = *(const uint64_t *)b;
+  return key1 < key2 ? -1 : key1 > key2;
+}
+
+void sort_keys(pair_key_array_t *keys) {
+  if (pair_key_array_size(keys) > 1) {
+    qsort(keys->data, pair_key_array_size(keys), sizeof(uint64_t),
+          compare_keys);
+  }
+}
+
+void push_key(box_pair_array_t *pairs, uint64_t key) {
+  box_pair_t pair = {(size_t)(key >> 32), (size_t)(key & UINT32_MAX)};
+  box_pair_array_push(pairs, pair);
+}
+
+void sweep_update(sweep_t *sweep, box_pair_array_t *added,
+                  box_pair_array_t *removed) {
+  sweep_axis(sweep, 0);
+  sweep_axis(sweep, 1);
+
+  // A pair's additions and removals alternate, so comparing how many of
+  // each there were tells whether it was added, removed, or neither
+  pair_key_array_t *adds = &sweep->added;
+  pair_key_array_t *removes = &sweep->removed;
+  sort_keys(adds);
+  sort_keys(removes);
+  box_pair_array_truncate(added, 0);
+  box_pair_array_truncate(removed, 0);
+  size_t i = 0;
+  size_t j = 0;
+  while (i < pair_key_array_size(adds) || j < pair_key_array_size(removes)) {
+    uint64_t key = i == pair_key_array_size(adds)      ? removes->data[j]
+                   : j == pair_key_array_size(removes) ? adds->data[i]
+                   : adds->data[i] < removes->data[j]  ? adds->data[i]
+                                                       : removes->data[j];
+    size_t n_adds = 0;
+    size_t n_removes = 0;
+    for (; i < pair_key_array_size(adds) && adds->data[i] == key; i++) {
+      n_adds++;
+    }
+    for (; j < pair_key_array_size(removes) && removes->data[j] == key; j++) {
+      n_removes++;
+    }
+    if (n_adds > n_removes) {
+      push_key(added, key);
+    } else if (n_removes > n_adds) {
+      push_key(removed, key);
+    }
+  }
+  pair_key_array_truncate(adds, 0);
+  pair_key_array_truncate(removes, 0);
+
+  while (index_array_size(&sweep->removed_proxies) > 0) {
+    index_array_push(&sweep->free_proxies,
+                     index_array_pop(&sweep->removed_proxies));
+  }
+}
+
+size_t sweep_pairs(sweep_t *sweep) { return sweep->n_pairs; }
+
+// Marks a missing node
+const size_t NO_NODE = SIZE_MAX;
+
+typedef struct tree_node {
+  // For a leaf, its fat box; otherwise the union of its children's boxes
+  aabb_t box;
+  // For a leaf, the box as given
+  aabb_t tight;
+  void *data;
+  // For a node on the free list, the next free node
+  size_t parent;
+  size_t child1;
+  size_t child2;
+  // 0 for leaves, -1 for free nodes
+  int height;
+} tree_node_t;
+
+DEFINE_ARRAY(tree_node, tree_node_t)
+
+// A box that a segment enters, for sorting them
+typedef struct ray_hit {
+  real_t fraction;
+  size_t proxy;
+} ray_hit_t;
+
+DEFINE_ARRAY(ray_hit, ray_hit_t)
+
+typedef struct aabb_tree {
+  tree_node_array_t nodes;
+  size_t root;
+  size_t free_list;
+  real_t margin;
+  // The nodes still to visit during a query
+  index_array_t stack;
+  // Scratch kept between calls so queries do not allocate
+  ray_hit_array_t hits;
+  proxy_array_t found;
+} aabb_tree_t;
+
+aabb_t aabb_union(aabb_t box1, aabb_t box2) {
+  return (aabb_t){
+      {box1.min.x < box2.min.x ? box1.min.x : box2.min.x,
+       box1.min.y < box2.min.y ? box1.min.y : box2.min.y},
+      {box1.max.x > box2.max.x ? box1.max.x : box2.max.x,
+       box1.max.y > box2.max.y ? box1.max.y : box2.max.y}};
+}
+
+bool aabb_contains(aabb_t outer, aabb_t inner) {
+  return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y &&
+         inner.max.x <= outer.max.x && inner.max.y <= outer.max.y;
+}
+
+real_t aabb_perimeter(aabb_t box) {
+  return 2 * ((box.max.x - box.min.x) + (box.max.y - box.min.y));
+}
+
+aabb_tree_t *aabb_tree_init(real_t margin) {
+  assert(margin >= 0);
+  aabb_tree_t *tree = malloc(sizeof(aabb_tree_t));
+  assert(tree != NULL);
+  tree_node_array_init(&tree->nodes, 0);
+  tree->root = NO_NODE;
+  tree->free_list = NO_NODE;
+  tree->margin = margin;
+  index_array_init(&tree->stack, 0);
+  ray_hit_array_init(&tree->hits, 0);
+  proxy_array_init(&tree->found, 0);
+  return tree;
+}
+
+void aabb_tree_free(aabb_tree_t *tree) {
+  tree_node_array_free(&tree->nodes);
+  index_array_free(&tree->stack);
+  ray_hit_array_free(&tree->hits);
+  proxy_array_free(&tree->found);
+  free(tree);
+}
+
+// Takes a node from the free list, or adds one.
+// This can move the nodes, so pointers to them must be fetched again.
+size_t tree_alloc(aabb_tree_t *tree) {
+  size_t node = tree->free_list;
+  if (node != NO_NODE) {
+    tree->free_list = tree->nodes.data[node].parent;
+  } else {
+    node = tree_node_array_size(&tree->nodes);
+    tree_node_array_push(&tree->nodes, (tree_node_t){0});
+  }
+  tree_node_t *n = &tree->nodes.data[node];
+  n->parent = NO_NODE;
+  n->child1 = NO_NODE;
+  n->child2 = NO_NODE;
+  n->data = NULL;
+  n->height = 0;
+  return node;
+}
+
+void tree_release(aabb_tree_t *tree, size_t node) {
+  tree->nodes.data[node].parent = tree->free_list;
+  tree->nodes.data[node].height = -1;
+  tree->free_list = node;
+}
+
+bool is_leaf(tree_node_t *node) { return node->child1 == NO_NODE; }
+
+int max_height(int height1, int height2) {
+  return height1 > height2 ? height1 : height2;
+}
+
+// Replaces one child of a node's parent with another node,
+// or makes the other node the root
+void replace_child(aabb_tree_t *tree, size_t parent, size_t old_child,
+                   size_t new_child) {
+  if (parent == NO_NODE) {
+    tree->root = new_child;
+  } else if (tree->nodes.data[parent].child1 == old_child) {
+    tree->nodes.data[parent].child1 = new_child;
+  } else {
+    tree->nodes.data[parent].child2 = new_child;
+  }
+}
+
+// If one child of node a is more than one level taller than the other,
+// rotates the taller child up into a's place.
+// Returns the node now in a's place.
+size_t tree_balance(aabb_tree_t *tree, size_t a) {
+  tree_node_t *nodes = tree->nodes.data;
+  tree_node_t *node_a = &nodes[a];
+  if (is_leaf(node_a) || node_a->height < 2) {
+    return a;
+  }
+  size_t b = node_a->child1;
+  size_t c = node_a->child2;
+  int balance = nodes[c].height - nodes[b].height;
+  if (balance >= -1 && balance <= 1) {
+    return a;
+  }
+
+  // Rotate the taller child (up) into a's place. The taller of its children
+  // stays with it; the other one replaces it under a.
+  bool c_taller = balance > 1;
+  size_t up = c_taller ? c : b;
+  size_t stays = c_taller ? b : c;
+  tree_node_t *node_up = &nodes[up];
+  size_t f = node_up->child1;
+  size_t g = node_up->child2;
+  size_t taller = nodes[f].height > nodes[g].height ? f : g;
+  size_t shorter = taller == f ? g : f;
+
+  node_up->child1 = a;
+  node_up->parent = node_a->parent;
+  node_a->parent = up;
+  replace_child(tree, node_up->parent, a, up);
+
+  node_up->child2 = taller;
+  if (c_taller) {
+    node_a->child2 = shorter;
+  } else {
+    node_a->child1 = shorter;
+  }
+  nodes[shorter].parent = a;
+
+  node_a->box = aabb_union(nodes[stays].box, nodes[shorter].box);
+  node_a->height = 1 + max_height(nodes[stays].height, nodes[shorter].height);
+  node_up->box = aabb_union(node_a->box, nodes[taller].box);
+  node_up->height = 1 + max_height(node_a->height, nodes[taller].height);
+  return up;
+}
+
+// Refits the boxes and heights from a node up to the root,
+// rebalancing on the way
+void tree_refit(aabb_tree_t *tree, size_t node) {
+  while (node != NO_NODE) {
+    node = tree_balance(tree, node);
+    tree_node_t *nodes = tree->nodes.data;
+    tree_node_t *n = &nodes[node];
+    n->height = 1 + max_height(nodes[n->child1].height, nodes[n->child2].height);
+    n->box = aabb_union(nodes[n->child1].box, nodes[n->child2].box);
+    node = n->parent;
+  }
+}
+
+// The increase in a subtree's cost from adding a box to it
+real_t insertion_cost(tree_node_t *node, aabb_t box) {
+  real_t combined = aabb_perimeter(aabb_union(node->box, box));
+  return is_leaf(node) ? combined : combined - aabb_perimeter(node->box);
+}
+
+void tree_insert_leaf(aabb_tree_t *tree, size_t leaf) {
+  if (tree->root == NO_NODE) {
+    tree->root = leaf;
+    tree->nodes.data[leaf].parent = NO_NODE;
+    return;
+  }
+
+  // Walk down to the sibling that adds the least perimeter to the tree
+  tree_node_t *nodes = tree->nodes.data;
+  aabb_t box = nodes[leaf].box;
+  size_t sibling = tree->root;
+  while (!is_leaf(&nodes[sibling])) {
+    tree_node_t *node = &nodes[sibling];
+    real_t perimeter = aabb_perimeter(node->box);
+    real_t combined = aabb_perimeter(aabb_union(node->box, box));
+    // Pairing with this node makes a parent whose box is the union
+    real_t cost = 2 * combined;
+    // Going further down still grows this node's box
+    real_t inherited = 2 * (combined - perimeter);
+    real_t cost1 = insertion_cost(&nodes[node->child1], box) + inherited;
+    real_t cost2 = insertion_cost(&nodes[node->child2], box) + inherited;
+    if (cost < cost1 && cost < cost2) {
+      break;
+    }
+    sibling = cost1 < cost2 ? node->child1 : node->child2;
+  }
+
+  size_t parent = tree_alloc(tree);
+  nodes = tree->nodes.data;
+  size_t old_parent = nodes[sibling].parent;
+  nodes[parent].parent = old_parent;
+  nodes[parent].box = aabb_union(box, nodes[sibling].box);
+  nodes[parent].height = nodes[sibling].height + 1;
+  nodes[parent].child1 = sibling;
+  nodes[parent].child2 = leaf;
+  replace_child(tree, old_parent, sibling, parent);
+  nodes[sibling].parent = parent;
+  nodes[leaf].parent = parent;
+  tree_refit(tree, old_parent);
+}
+
+void tree_remove_leaf(aabb_tree_t *tree, size_t leaf) {
+  if (leaf == tree->root) {
+    tree->root = NO_NODE;
+    return;
+  }
+  tree_node_t *nodes = tree->nodes.data;
+  size_t parent = nodes[leaf].parent;
+  size_t grandparent = nodes[parent].parent;
+  size_t sibling = nodes[parent].child1 == leaf ? nodes[parent].child2
+                                                : nodes[parent].child1;
+  replace_child(tree, grandparent, parent, sibling);
+  nodes[sibling].parent = grandparent;
+  tree_release(tree, parent);
+  tree_refit(tree, grandparent);
+}
+
+aabb_t fatten(aabb_t box, real_t margin) {
+  return (aabb_t){{box.min.x - margin, box.min.y - margin},
+                  {box.max.x + margin, box.max.y + margin}};
+}
+
+size_t aabb_tree_insert(aabb_tree_t *tree, aabb_t box, void *data) {
+  size_t leaf = tree_alloc(tree);
+  tree_node_t *node = &tree->nodes.data[leaf];
+  node->box = fatten(box, tree->margin);
+  node->tight = box;
+  node->data = data;
+  tree_insert_leaf(tree, leaf);
+  return leaf;
+}
+
+// Asserts that a proxy is a leaf in the tree
+void check_leaf(aabb_tree_t *tree, size_t proxy) {
+  assert(proxy < tree_node_array_size(&tree->nodes));
+  assert(tree->nodes.data[proxy].height == 0);
+}
+
+void aabb_tree_remove(aabb_tree_t *tree, size_t proxy) {
+  check_leaf(tree, proxy);
+  tree_remove_leaf(tree, proxy);
+  tree_release(tree, proxy);
+}
+
+bool aabb_tree_move(aabb_tree_t *tree, size_t proxy, aabb_t box) {
+  check_leaf(tree, proxy);
+  tree_node_t *node = &tree->nodes.data[proxy];
+  node->tight = box;
+  if (aabb_contains(node->box, box)) {
+    return false;
+  }
+  tree_remove_leaf(tree, proxy);
+  tree->nodes.data[proxy].box = fatten(box, tree->margin);
+  tree_insert_leaf(tree, proxy);
+  return true;
+}
+
+void *aabb_tree_data(aabb_tree_t *tree, size_t proxy) {
+  check_leaf(tree, proxy);
+  return tree->nodes.data[proxy].data;
+}
+
+size_t aabb_tree_height(aabb_tree_t *tree) {
+  return tree->root == NO_NODE ? 0 : tree->nodes.data[tree->root].height + 1;
+}
+
+// Whether a segment passes through a box, and if so the fraction of the way
+// along it where it enters (0 if it starts inside)
+bool segment_hits(aabb_t box, vector_t from, vector_t delta,
+                  real_t *fraction) {
+  real_t enter = 0;
+  real_t leave = 1;
+  real_t starts[] = {from.x, from.y};
+  real_t deltas[] = {delta.x, delta.y};
+  real_t mins[] = {box.min.x, box.min.y};
+  real_t maxes[] = {box.max.x, box.max.y};
+  for (size_t axis = 0; axis < 2; axis++) {
+    if (deltas[axis] == 0) {
+      if (starts[axis] < mins[axis] || starts[axis] > maxes[axis]) {
+        return false;
+      }
+      continue;
+    }
+    real_t t1 = (mins[axis] - starts[axis]) / deltas[axis];
+    real_t t2 = (maxes[axis] - starts[axis]) / deltas[axis];
+    if (t1 > t2) {
+      real_t swap = t1;
+      t1 = t2;
+      t2 = swap;
+    }
+    enter = t1 > enter ? t1 : enter;
+    leave = t2 < leave ? t2 : leave;
+    if (enter > leave) {
+      return false;
+    }
+  }
+  *fraction = enter;
+  return true;
+}
+
+// The squared distance from a point to the nearest point of a box
+real_t box_distance2(aabb_t box, vector_t point) {
+  real_t dx = point.x < box.min.x   ? box.min.x - point.x
+              : point.x > box.max.x ? point.x - box.max.x
+                                    : 0;
+  real_t dy = point.y < box.min.y   ? box.min.y - point.y
+              : point.y > box.max.y ? point.y - box.max.y
+                                    : 0;
+  return dx * dx + dy * dy;
+}
+
+void aabb_tree_query_box(aabb_tree_t *tree, aabb_t box,
+                         proxy_array_t *proxies) {
+  proxy_array_truncate(proxies, 0);
+  if (tree->root == NO_NODE) {
+    return;
+  }
+  index_array_t *stack = &tree->stack;
+  index_array_truncate(stack, 0);
+  index_array_push(stack, tree->root);
+  while (index_array_size(stack) > 0) {
+    tree_node_t *node = &tree->nodes.data[index_array_pop(stack)];
+    if (!aabb_overlap(node->box, box)) {
+      continue;
+    }
+    if (!is_leaf(node)) {
+      index_array_push(stack, node->child1);
+      index_array_push(stack, node->child2);
+    } else if (aabb_overlap(node->tight, box)) {
+      proxy_array_push(proxies, node - tree->nodes.data);
+    }
+  }
+}
+
+void aabb_tree_query_point(aabb_tree_t *tree, vector_t point,
+                           proxy_array_t *proxies) {
+  aabb_tree_query_box(tree, (aabb_t){point, point}, proxies);
+}
+
+void aabb_tree_query_radius(aabb_tree_t *tree, vector_t center, real_t radius,
+                            proxy_array_t *proxies) {
+  aabb_t box = {{center.x - radius, center.y - radius},
+                {center.x + radius, center.y + radius}};
+  aabb_tree_query_box(tree, box, proxies);
+  // Drop the boxes near the corners of the square that miss the circle
+  size_t kept = 0;
+  for (size_t i = 0; i < proxy_array_size(proxies); i++) {
+    size_t proxy = proxy_array_get(proxies, i);
+    if (box_distance2(tree->nodes.data[proxy].tight, center) <=
+        radius * radius) {
+      proxy_array_set(proxies, kept++, proxy);
+    }
+  }
+  proxy_array_truncate(proxies, kept);
+}
+
+int compare_hits(const void *a, const void *b) {
+  const ray_hit_t *hit1 = a;
+  const ray_hit_t *hit2 = b;
+  if (hit1->fraction != hit2->fraction) {
+    return hit1->fraction < hit2->fraction ? -1 : 1;
+  }
+  return hit1->proxy < hit2->proxy ? -1 : hit1->proxy > hit2->proxy;
+}
+
+void aabb_tree_query_ray(aabb_tree_t *tree, vector_t from, vector_t to,
+                         proxy_array_t *proxies) {
+  proxy_array_truncate(proxies, 0);
+  if (tree->root == NO_NODE) {
+    return;
+  }
+  vector_t delta = vec_subtract(to, from);
+  ray_hit_array_t *hits = &tree->hits;
+  ray_hit_array_truncate(hits, 0);
+  index_array_t *stack = &tree->stack;
+  index_array_truncate(stack, 0);
+  index_array_push(stack, tree->root);
+  while (index_array_size(stack) > 0) {
+    tree_node_t *node = &tree->nodes.data[index_array_pop(stack)];
+    real_t fraction;
+    if (!segment_hits(node->box, from, delta, &fraction)) {
+      continue;
+    }
+    if (!is_leaf(node)) {
+      index_array_push(stack, node->child1);
+      index_array_push(stack, node->child2);
+    } else if (segment_hits(node->tight, from, delta, &fraction)) {
+      ray_hit_t hit = {fraction, node - tree->nodes.data};
+      ray_hit_array_push(hits, hit);
+    }
+  }
+  if (ray_hit_array_size(hits) > 1) {
+    qsort(hits->data, ray_hit_array_size(hits), sizeof(ray_hit_t),
+          compare_hits);
+  }
+  for (size_t i = 0; i < ray_hit_array_size(hits); i++) {
+    proxy_array_push(proxies, ray_hit_array_get(hits, i).proxy);
+  }
+}
+
+void aabb_tree_find_pairs(aabb_tree_t *tree, box_pair_array_t *pairs) {
+  box_pair_array_truncate(pairs, 0);
+  proxy_array_t *found = &tree->found;
+  for (size_t leaf = 0; leaf < tree_node_array_size(&tree->nodes); leaf++) {
+    if (tree->nodes.data[leaf].height != 0) {
+      continue;
+    }
+    aabb_tree_query_box(tree, tree->nodes.data[leaf].tight, found);
+    // Each pair is found from both of its boxes; keep it once
+    for (size_t i = 0; i < proxy_array_size(found); i++) {
+      size_t other = proxy_array_get(found, i);
+      if (other > leaf) {
+        box_pair_array_push(pairs, (box_pair_t){leaf, other});
+      }
+    }
+  }
+  if (box_pair_array_size(pairs) > 1) {
+    qsort(pairs->data, box_pair_array_size(pairs), sizeof(box_pair_t),
+          compare_pairs);
+  }
+}
@@ -1,5 +1,6 @@
 #include "collision.h"
 #include "list.h"
+#include "vec_batch.h"
 #include "vector.h"
 #include <assert.h>
 #include <math.h>
@@ -13,68 +14,112 @@
 
 const size_t BIG_NUMBER = 100000;
 
-// Helper to take the minimum and maximum values
-double min_max(vector_t unit, list_t *shape, int min) {
-  bool var = true;
-  double min_max = -1;
+// Helper to project a shape onto an axis, giving its minimum and maximum
+void min_max(vector_t unit, const vertex_array_t *shape, real_t *min,
+             real_t *max) {
+  const vector_t *v = shape->data;
+  vec_minmax_project_n(&v->x, &v->y, 2, shape->size, unit, min, max);
+}
 
-  for (size_t i = 0; i < list_size(shape); i++) {
-    double magnitude = vec_dot(*(vector_t *)list_get(shape, i), unit);
+// Helper function to calculate the unit normal of the edge starting at index i
+vector_t unit_normal(const vertex_array_t *shape, size_t i) {
+  vector_t point1 = shape->data[i];
+  vector_t point2 = shape->data[(i + 1) % shape->size];
 
-    if (var == true || min * magnitude < min * min_max) {
-      min_max = magnitude;
-      var = false;
-    }
-  }
+  vector_t edge = vec_subtract(point1, point2);
 
-  return min_max;
-}
+  real_t mag = 1 / real_sqrt(vec_dot(edge, edge));
 
-// Helper function to calculate unit vector
-void unit_vectors(list_t *units, list_t *shape) {
-  for (size_t i = 0; i < list_size(shape); i++) {
-    vector_t point1 = *(vector_t *)list_get(shape, i);
-    vector_t point2 = *(vector_t *)list_get(shape, (i + 1) % list_size(shape));
+  vector_t unit_edge = vec_multiply(mag, edge);
+  vector_t unit = {.x = -unit_edge.y, .y = unit_edge.x};
+  return unit;
+}
 
-    vector_t edge = vec_subtract(point1, point2);
+real_t overlap(real_t min1, real_t max1, real_t min2, real_t max2) {
+  real_t start = MAX(min1, min2);
+  real_t end = MIN(max1, max2);
+  real_t distance = end - start;
+  return distance;
+}
 
-    double mag = 1.0 / sqrt(vec_dot(edge, edge));
+#ifdef PHYSICS_FIXED
+// Fixed-point unit_normal(), converting the edge's ends as it goes
+fixed_vector_t fixed_unit_normal(const vertex_array_t *shape, size_t i) {
+  fixed_vector_t point1 = vec_to_fixed(shape->data[i]);
+  fixed_vector_t point2 = vec_to_fixed(shape->data[(i + 1) % shape->size]);
+  fixed_vector_t edge = fixed_vec_subtract(point1, point2);
+  fixed_t length = fixed_sqrt(fixed_vec_dot(edge, edge));
+  fixed_vector_t unit = {.x = -fixed_div(edge.y, length),
+                         .y = fixed_div(edge.x, length)};
+  return unit;
+}
 
-    vector_t unit_edge = vec_multiply(mag, edge);
-    vector_t *unit = malloc(sizeof(vector_t));
-    unit->x = -unit_edge.y;
-    unit->y = unit_edge.x;
-    list_add(units, unit);
+// Fixed-point min_max(), converting each vertex as it goes rather than
+// copying the shape
+void fixed_min_max(fixed_vector_t unit, const vertex_array_t *shape,
+                   fixed_t *min, fixed_t *max) {
+  *min = FIXED_MAX;
+  *max = -FIXED_MAX;
+  for (size_t i = 0; i < shape->size; i++) {
+    fixed_t projection = fixed_vec_dot(unit, vec_to_fixed(shape->data[i]));
+    *min = MIN(*min, projection);
+    *max = MAX(*max, projection);
   }
 }
 
-double overlap(double min1, double max1, double min2, double max2) {
-  double start = MAX(min1, min2);
-  double end = MIN(max1, max2);
-  double distance = end - start;
-  return distance;
-}
+// The same separating axis test as below, in fixed point
+// so that the result is bit-exact
+collision_info_t find_collision_array(const vertex_array_t *shape1,
+                                      const vertex_array_t *shape2) {
+  collision_info_t collision_info = {.collided = false};
 
-collision_info_t find_collision(list_t *shape1, list_t *shape2) {
-  collision_info_t collision_info;
+  fixed_t curr_dist = FIXED_MAX;
+
+  size_t n_units = shape1->size + shape2->size;
+  for (size_t i = 0; i < n_units; i++) {
+    fixed_vector_t unit = i < shape1->size
+                              ? fixed_unit_normal(shape1, i)
+                              : fixed_unit_normal(shape2, i - shape1->size);
+
+    fixed_t min1, max1, min2, max2;
+    fixed_min_max(unit, shape1, &min1, &max1);
+    fixed_min_max(unit, shape2, &min2, &max2);
+
+    fixed_t min_dist = MIN(max1, max2) - MAX(min1, min2);
 
-  list_t *units = list_init(
-      sizeof(vector_t) * (list_size(shape1) + list_size(shape2)), free);
-  unit_vectors(units, shape1);
-  unit_vectors(units, shape2);
+    if (min_dist < curr_dist) {
+      curr_dist = min_dist;
+
+      if (max1 < min2 || max2 < min1) {
+        collision_info.collided = false;
+      } else {
+        collision_info.collided = true;
+        collision_info.axis = vec_from_fixed(unit);
+      }
+    }
+  }
+
+  return collision_info;
+}
+#else
+collision_info_t find_collision_array(const vertex_array_t *shape1,
+                                      const vertex_array_t *shape2) {
+  collision_info_t collision_info = {.collided = false};
 
   vector_t min_unit;
-  double curr_dist = BIG_NUMBER;
+  real_t curr_dist = BIG_NUMBER;
 
-  for (size_t i = 0; i < list_size(units); i++) {
-    vector_t unit = *(vector_t *)list_get(units, i);
+  // The candidate axes are the edge normals of shape1 followed by shape2's
+  size_t n_units = shape1->size + shape2->size;
+  for (size_t i = 0; i < n_units; i++) {
+    vector_t unit = i < shape1->size ? unit_normal(shape1, i)
+                                     : unit_normal(shape2, i - shape1->size);
 
-    double min1 = min_max(unit, shape1, 1);
-    double max1 = min_max(unit, shape1, -1);
-    double min2 = min_max(unit, shape2, 1);
-    double max2 = min_max(unit, shape2, -1);
+    real_t min1, max1, min2, max2;
+    min_max(unit, shape1, &min1, &max1);
+    min_max(unit, shape2, &min2, &max2);
 
-    double min_dist = overlap(min1, max1, min2, max2);
+    real_t min_dist = overlap(min1, max1, min2, max2);
 
     if (min_dist < curr_dist) {
       min_unit = unit;
@@ -89,6 +134,75 @@ collision_info_t find_collision(list_t *shape1, list_t *shape2) {
     }
   }
 
-  list_free(units);
   return collision_info;
 }
+
+// find_collision_array() with the candidate axes given, rather than
+// computed from the shapes' edges. The axes must be the shapes' unit edge
+// normals, though parallel ones may be left out.
+collision_info_t find_collision_on_axes(const vertex_array_t *shape1,
+                                        const vertex_array_t *axes1,
+                                        const vertex_array_t *shape2,
+                                        const vertex_array_t *axes2) {
+  collision_info_t collision_info = {.collided = false};
+  real_t curr_dist = BIG_NUMBER;
+
+  size_t n_units = axes1->size + axes2->size;
+  for (size_t i = 0; i < n_units; i++) {
+    vector_t unit =
+        i < axes1->size ? axes1->data[i] : axes2->data[i - axes1->size];
+
+    real_t min1, max1, min2, max2;
+    min_max(unit, shape1, &min1, &max1);
+    min_max(unit, shape2, &min2, &max2);
+
+    real_t min_dist = overlap(min1, max1, min2, max2);
+
+    if (min_dist < curr_dist) {
+      curr_dist = min_dist;
+
+      if (max1 < min2 || max2 < min1) {
+        collision_info.collided = false;
+      } else {
+        collision_info.collided = true;
+        collision_info.axis = unit;
+      }
+    }
+  }
+
+  return collision_info;
+}
+#endif
+
+collision_info_t find_collision(list_t *shape1, list_t *shape2) {
+  vertex_array_t *array1 = vertex_array_from_list(shape1);
+  vertex_array_t *array2 = vertex_array_from_list(shape2);
+  collision_info_t collision_info = find_collision_array(array1, array2);
+  vertex_array_free(array1);
+  vertex_array_free(array2);
+  return collision_info;
+}
+
+collision_info_t find_collision_bodies(body_t *body1, body_t *body2) {
+  collision_info_t collision_info = {.collided = false};
+  // The bounding circles need neither body's world-space vertices
+  vector_t between =
+      vec_subtract(body_get_centroid(body2), body_get_centroid(body1));
+  real_t reach = body_get_radius(body1) + body_get_radius(body2);
+  if (vec_dot(between, between) > reach * reach) {
+    return collision_info;
+  }
+  if (!aabb_overlap(body_get_bounds(body1), body_get_bounds(body2))) {
+    return collision_info;
+  }
+#ifdef PHYSICS_FIXED
+  // Axes rotated in floating point would not match the fixed-point edge
+  // normals bit for bit, so the edges are used as find_collision_array()
+  // uses them
+  return find_collision_array(body_shape_view(body1), body_shape_view(body2));
+#else
+  // The shapes' precomputed axes save finding and normalizing every edge
+  return find_collision_on_axes(body_shape_view(body1), body_axes_view(body1),
+                                body_shape_view(body2), body_axes_view(body2));
+#endif
+}
@@ -2,6 +2,12 @@
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+// Number of elements stored inside the list_t itself before spilling to the
+// heap. Most force creators only hold one or two bodies, so their lists never
+// need a second allocation, and the whole list fits in one cache line.
+#define INLINE_CAPACITY 4
 
 const size_t FACTOR = 2;
 const size_t DEFAULT = 20;
@@ -11,13 +17,24 @@ typedef struct list {
   size_t max_size;
   void **gen_array;
   free_func_t freer;
+  void *inline_array[INLINE_CAPACITY];
 } list_t;
 
+// Whether the elements currently live in the list's inline buffer
+bool list_is_inline(list_t *list) {
+  return list->gen_array == list->inline_array;
+}
+
 list_t *list_init(size_t initial_size, free_func_t freer) {
   list_t *retlist = malloc(sizeof(list_t));
   assert(retlist != NULL);
-  retlist->gen_array = malloc(sizeof(void *) * initial_size);
-  assert(retlist->gen_array != NULL);
+  if (initial_size <= INLINE_CAPACITY) {
+    retlist->gen_array = retlist->inline_array;
+    initial_size = INLINE_CAPACITY;
+  } else {
+    retlist->gen_array = malloc(sizeof(void *) * initial_size);
+    assert(retlist->gen_array != NULL);
+  }
 
   retlist->size = 0;
   retlist->max_size = initial_size;
@@ -26,7 +43,9 @@ list_t *list_init(size_t initial_size, free_func_t freer) {
 }
 
 void list_free2(list_t *list) {
-  free(list->gen_array);
+  if (!list_is_inline(list)) {
+    free(list->gen_array);
+  }
   free(list);
 }
 
@@ -36,8 +55,7 @@ void list_free(list_t *list) {
       (list->freer)(list->gen_array[i]);
     }
   }
-  free(list->gen_array);
-  free(list);
+  list_free2(list);
 }
 
 size_t list_size(list_t *list) { return list->size; }
@@ -60,16 +78,74 @@ void *list_remove(list_t *list, size_t index) {
   return removed;
 }
 
+void *list_swap_remove(list_t *list, size_t index) {
+  assert(index < list->size);
+  void *removed = list->gen_array[index];
+  list->size--;
+  list->gen_array[index] = list->gen_array[list->size];
+  return removed;
+}
+
+size_t list_remove_if(list_t *list, list_predicate_t predicate, void *aux) {
+  // Slide each kept element down over the gaps left by removed ones
+  size_t kept = 0;
+  for (size_t i = 0; i < list->size; i++) {
+    void *element = list->gen_array[i];
+    if (predicate(element, aux)) {
+      if (list->freer != NULL) {
+        list->freer(element);
+      }
+    } else {
+      list->gen_array[kept] = element;
+      kept++;
+    }
+  }
+
+  size_t removed = list->size - kept;
+  list->size = kept;
+  return removed;
+}
+
+// Resizes the internal array, moving the elements between the inline buffer
+// and the heap as needed. Heap arrays are resized in place when the allocator
+// allows it.
+void list_resize(list_t *list, size_t max_size) {
+  assert(max_size >= list->size);
+  if (max_size <= INLINE_CAPACITY) {
+    if (!list_is_inline(list)) {
+      memcpy(list->inline_array, list->gen_array, sizeof(void *) * list->size);
+      free(list->gen_array);
+      list->gen_array = list->inline_array;
+    }
+    list->max_size = INLINE_CAPACITY;
+  } else if (list_is_inline(list)) {
+    void **gen_arr = malloc(sizeof(void *) * max_size);
+    assert(gen_arr != NULL);
+    memcpy(gen_arr, list->inline_array, sizeof(void *) * list->size);
+    list->gen_array = gen_arr;
+    list->max_size = max_size;
+  } else {
+    void **gen_arr = realloc(list->gen_array, sizeof(void *) * max_size);
+    assert(gen_arr != NULL);
+    list->gen_array = gen_arr;
+    list->max_size = max_size;
+  }
+}
+
 void list_grow(list_t *list) {
-  list_t *old = list;
-  void **gen_arr = malloc(sizeof(void *) * list->max_size * FACTOR);
-  for (int i = 0; i < list->size; i++) {
-    gen_arr[i] = list_get(list, i);
+  list_resize(list, list->max_size * FACTOR);
+}
+
+void list_reserve(list_t *list, size_t capacity) {
+  if (capacity > list->max_size) {
+    list_resize(list, capacity);
   }
+}
 
-  free(old->gen_array);
-  list->gen_array = gen_arr;
-  list->max_size = list->max_size * FACTOR;
+void list_shrink_to_fit(list_t *list) {
+  if (list->size < list->max_size) {
+    list_resize(list, list->size);
+  }
 }
 
 void list_add(list_t *list, void *value) {
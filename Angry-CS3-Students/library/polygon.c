@@ -1,5 +1,7 @@
 #include "polygon.h"
 #include "list.h"
+#include "vec_batch.h"
+#include <assert.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -8,20 +10,17 @@
  * Area of polygon using shoelace formula:
  * 1/2 sum of x1*y2 + x2*y3 + ... + xn-1*yn + xn*y1 -
  *             x2*y1 - x3*y2 - ... - xn*yn-1 - x1*yn
+ * The vertices are taken relative to the first one, which gives the same
+ * area but avoids cancellation for polygons far from the origin,
+ * and the sum is accumulated in double even when real_t is float.
  */
-double polygon_area(list_t *polygon) {
+real_t polygon_array_area(const vertex_array_t *polygon) {
   double sum = 0.0;
-  size_t size = list_size(polygon);
-  for (size_t i = 0; i < size - 1; i++) {
-    vector_t *curr = list_get(polygon, i);
-    vector_t *next = list_get(polygon, i + 1);
-    sum += curr->x * next->y;
-    sum -= curr->y * next->x;
+  size_t size = polygon->size;
+  const vector_t *v = polygon->data;
+  for (size_t i = 1; i + 1 < size; i++) {
+    sum += vec_cross(vec_subtract(v[i], v[0]), vec_subtract(v[i + 1], v[0]));
   }
-  vector_t *first = list_get(polygon, 0);
-  vector_t *last = list_get(polygon, size - 1);
-  sum += last->x * first->y;
-  sum -= last->y * first->x;
   return sum / 2;
 }
 
@@ -29,43 +28,109 @@ double polygon_area(list_t *polygon) {
  * Centroid of polygon using this formula:
  * Cx = 1/(6 * area of polygon) * sum of (xi + xi+1)(xi*yi+1 - xi+1*yi)
  * Cy = 1/(6 * area of polygon) * sum of (yi + yi+1)(xi*yi+1 - xi+1*yi)
+ * and second moment of area about the first vertex
+ * J = 1/12 * sum of (xi*yi+1 - xi+1*yi)(vi.vi + vi.vi+1 + vi+1.vi+1),
+ * which the parallel axis theorem moves to the centroid.
+ * Like the area, this is computed relative to the first vertex,
+ * fanning the polygon into the triangles (v0, vi, vi+1).
  */
-vector_t polygon_centroid(list_t *polygon) {
-  vector_t centroid = {0.0, 0.0};
+polygon_mass_properties_t
+polygon_array_mass_properties(const vertex_array_t *polygon) {
   double sumX = 0.0;
   double sumY = 0.0;
-  size_t size = list_size(polygon);
-  for (size_t i = 0; i < size; i++) {
-    vector_t *curr = list_get(polygon, i);
-    vector_t *next = list_get(polygon, (i + 1) % size);
-    sumX += (curr->x + next->x) * (curr->x * next->y - curr->y * next->x);
-    sumY += (curr->y + next->y) * (curr->x * next->y - curr->y * next->x);
+  double sum_cross = 0.0;
+  double sum_inertia = 0.0;
+  size_t size = polygon->size;
+  const vector_t *v = polygon->data;
+  for (size_t i = 1; i + 1 < size; i++) {
+    vector_t curr = vec_subtract(v[i], v[0]);
+    vector_t next = vec_subtract(v[i + 1], v[0]);
+    real_t cross = vec_cross(curr, next);
+    sumX += (curr.x + next.x) * cross;
+    sumY += (curr.y + next.y) * cross;
+    sum_cross += cross;
+    sum_inertia += cross * (vec_dot(curr, curr) + vec_dot(curr, next) +
+                            vec_dot(next, next));
   }
-  sumX = 1 / (6 * polygon_area(polygon)) * sumX;
-  sumY = 1 / (6 * polygon_area(polygon)) * sumY;
-  centroid.x = sumX;
-  centroid.y = sumY;
+  double area = sum_cross / 2;
+  // 6 * area = 3 * sum_cross
+  double cx = sumX / (3 * sum_cross);
+  double cy = sumY / (3 * sum_cross);
+  polygon_mass_properties_t properties = {
+      .area = area,
+      .centroid = vec_add((vector_t){cx, cy}, v[0]),
+      .inertia = sum_inertia / 12 - area * (cx * cx + cy * cy),
+  };
+  return properties;
+}
+
+vector_t polygon_array_centroid(const vertex_array_t *polygon) {
+  return polygon_array_mass_properties(polygon).centroid;
+}
+
+void polygon_array_translate(vertex_array_t *polygon, vector_t translation) {
+  vector_t *v = polygon->data;
+  vec_translate_n(&v->x, &v->y, 2, polygon->size, translation);
+}
+
+void polygon_array_rotate(vertex_array_t *polygon, real_t angle,
+                          vector_t point) {
+  vector_t *v = polygon->data;
+  vec_rotate_n(&v->x, &v->y, 2, polygon->size, rot_init(angle), point);
+}
+
+// The list_t versions below are thin adapters over the vertex array functions
+
+real_t polygon_area(list_t *polygon) {
+  vertex_array_t *array = vertex_array_from_list(polygon);
+  real_t area = polygon_array_area(array);
+  vertex_array_free(array);
+  return area;
+}
+
+vector_t polygon_centroid(list_t *polygon) {
+  vertex_array_t *array = vertex_array_from_list(polygon);
+  vector_t centroid = polygon_array_centroid(array);
+  vertex_array_free(array);
   return centroid;
 }
 
+polygon_mass_properties_t polygon_mass_properties(list_t *polygon) {
+  vertex_array_t *array = vertex_array_from_list(polygon);
+  polygon_mass_properties_t properties = polygon_array_mass_properties(array);
+  vertex_array_free(array);
+  return properties;
+}
+
 void polygon_translate(list_t *polygon, vector_t translation) {
   size_t size = list_size(polygon);
   for (size_t i = 0; i < size; i++) {
     vector_t *curr = list_get(polygon, i);
-    curr->x = curr->x + translation.x;
-    curr->y = curr->y + translation.y;
+    *curr = vec_add(*curr, translation);
   }
 }
 
-void polygon_rotate(list_t *polygon, double angle, vector_t point) {
+void polygon_rotate(list_t *polygon, real_t angle, vector_t point) {
+  rot_t rot = rot_init(angle);
   size_t size = list_size(polygon);
   for (size_t i = 0; i < size; i++) {
     vector_t *curr = list_get(polygon, i);
-    curr->x = curr->x - point.x;
-    curr->y = curr->y - point.y;
-    double newx = curr->x * cos(angle) - curr->y * sin(angle);
-    double newy = curr->x * sin(angle) + curr->y * cos(angle);
-    curr->x = newx + point.x;
-    curr->y = newy + point.y;
+    *curr = vec_add(vec_rotate_by(vec_subtract(*curr, point), rot), point);
+  }
+}
+
+const vector_t *polygon_unit_circle(size_t n) {
+  static vector_t *circles[MAX_CIRCLE_PTS + 1];
+  assert(n >= 3 && n <= MAX_CIRCLE_PTS);
+  if (circles[n] == NULL) {
+    vector_t *circle = malloc(sizeof(vector_t) * n);
+    assert(circle != NULL);
+    for (size_t i = 0; i < n; i++) {
+      // Each angle is computed directly, so errors don't build up around
+      // the circle the way repeated rotation does
+      fast_sincos(2 * M_PI * i / n, &circle[i].y, &circle[i].x);
+    }
+    circles[n] = circle;
   }
+  return circles[n];
 }
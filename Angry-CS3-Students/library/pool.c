@@ -0,0 +1,107 @@
+#include "pool.h"
+#include <assert.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+/**
+ * Each object is preceded by a header holding its pool, padded to the
+ * alignment of max_align_t rather than its size, so that the objects are
+ * maximally aligned at the smallest cost.
+ * While the object is on the free list, its own memory holds the next
+ * free object.
+ */
+typedef struct header {
+  struct pool *pool;
+} header_t;
+
+#define OBJECT_ALIGN _Alignof(max_align_t)
+#define ROUND_UP(size) (((size) + OBJECT_ALIGN - 1) / OBJECT_ALIGN * OBJECT_ALIGN)
+// The space before each object, which ends with its header
+#define HEADER_SPACE ROUND_UP(sizeof(header_t))
+
+typedef struct free_object {
+  struct free_object *next;
+} free_object_t;
+
+// Slabs are chained together so that pool_free() can release them
+typedef union slab {
+  union slab *next;
+  max_align_t align;
+} slab_t;
+
+typedef struct pool {
+  // The size of a header plus an object, rounded up to keep alignment
+  size_t stride;
+  size_t slab_objects;
+  slab_t *slabs;
+  free_object_t *free_list;
+  size_t live;
+} pool_t;
+
+pool_t *pool_init(size_t object_size, size_t slab_objects) {
+  assert(slab_objects > 0);
+  pool_t *pool = malloc(sizeof(pool_t));
+  assert(pool != NULL);
+
+  if (object_size < sizeof(free_object_t)) {
+    object_size = sizeof(free_object_t);
+  }
+  pool->stride = HEADER_SPACE + ROUND_UP(object_size);
+  pool->slab_objects = slab_objects;
+  pool->slabs = NULL;
+  pool->free_list = NULL;
+  pool->live = 0;
+  return pool;
+}
+
+void pool_free(pool_t *pool) {
+  slab_t *slab = pool->slabs;
+  while (slab != NULL) {
+    slab_t *next = slab->next;
+    free(slab);
+    slab = next;
+  }
+  free(pool);
+}
+
+// Allocates a new slab and puts all of its objects on the free list
+void pool_grow(pool_t *pool) {
+  slab_t *slab = malloc(sizeof(slab_t) + pool->stride * pool->slab_objects);
+  assert(slab != NULL);
+  slab->next = pool->slabs;
+  pool->slabs = slab;
+
+  char *start = (char *)(slab + 1);
+  // Push in reverse so that objects are handed out in address order
+  for (size_t i = pool->slab_objects; i-- > 0;) {
+    char *memory = start + i * pool->stride + HEADER_SPACE;
+    ((header_t *)memory - 1)->pool = pool;
+    free_object_t *object = (free_object_t *)memory;
+    object->next = pool->free_list;
+    pool->free_list = object;
+  }
+}
+
+void *pool_alloc(pool_t *pool) {
+  if (pool->free_list == NULL) {
+    pool_grow(pool);
+  }
+  free_object_t *object = pool->free_list;
+  pool->free_list = object->next;
+  pool->live++;
+  return object;
+}
+
+void pool_release(void *object) {
+  if (object == NULL) {
+    return;
+  }
+  pool_t *pool = ((header_t *)object - 1)->pool;
+  assert(pool->live > 0);
+  free_object_t *free_object = object;
+  free_object->next = pool->free_list;
+  pool->free_list = free_object;
+  pool->live--;
+}
+
+size_t pool_live(pool_t *pool) { return pool->live; }
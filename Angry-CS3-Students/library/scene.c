@@ -1,61 +1,475 @@
 #include "scene.h"
+#include "broadphase.h"
+#include "collision.h"
 #include <assert.h>
 #include <math.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 // Set some arbitrary number of bodies so that we can initialize our list
 const size_t orig_bodies = 100;
 
+// The aux pools hold objects of 16, 32, 64 and 128 bytes
+#define N_AUX_POOLS 4
+const size_t MIN_AUX_SIZE = 16;
+// Objects per slab in the scene's pools
+const size_t POOL_SLAB_OBJECTS = 64;
+
+// Force creators that depend on at most this many bodies keep their
+// dependencies in the aux_t itself
+#define AUX_INLINE_BODIES 2
+
+// A body that a force creator depends on
+typedef struct dependency {
+  body_handle_t body;
+  // Where the force creator is in the body's list of creators
+  size_t position;
+} dependency_t;
+
 typedef struct aux {
   force_creator_t force;
   void *aux;
   free_func_t freer;
-  list_t *bodies;
+  // Points to inline_bodies unless there are more than AUX_INLINE_BODIES
+  dependency_t *bodies;
+  size_t n_bodies;
+  dependency_t inline_bodies[AUX_INLINE_BODIES];
   size_t id;
+  // Where the force creator is in the list of creators with its id
+  size_t id_position;
+  // Set once the force creator is removed; it is then skipped until the
+  // next scene_tick() takes it out of the scene's array
+  bool dead;
 } aux_t;
 
+DEFINE_ARRAY(aux_ptr, aux_t *)
+
+// The force creators with one id.
+// Games use a handful of ids, so buckets are found by a linear search.
+typedef struct id_bucket {
+  size_t id;
+  aux_ptr_array_t creators;
+} id_bucket_t;
+
+DEFINE_ARRAY(id_bucket, id_bucket_t)
+
+// An entry in a body's list of the force creators that depend on it:
+// the creator and which of its bodies this one is
+typedef struct creator_ref {
+  aux_t *creator;
+  size_t which;
+} creator_ref_t;
+
+DEFINE_ARRAY(creator_ref, creator_ref_t)
+DEFINE_ARRAY(creator_list, creator_ref_array_t)
+DEFINE_ARRAY(body_list, body_ptr_array_t)
+DEFINE_ARRAY(handle, body_handle_t)
+
+// A collision handler for bodies with a pair of tags
+typedef struct collision_rule {
+  size_t tag1;
+  size_t tag2;
+  collision_handler_t handler;
+  void *aux;
+  free_func_t freer;
+} collision_rule_t;
+
+DEFINE_ARRAY(collision_rule, collision_rule_t)
+// A collision handler for one pair of bodies
+typedef struct pair_rule {
+  // contact_key() of the bodies
+  uint64_t key;
+  body_t *body1;
+  body_t *body2;
+  collision_handler_t handler;
+  void *aux;
+  free_func_t freer;
+  // Whether the pair has not been found colliding since the rule was added,
+  // so that a pair already touching still counts as starting to collide
+  bool fresh;
+} pair_rule_t;
+
+DEFINE_ARRAY(pair_rule, pair_rule_t)
+// Marks a rule_call_t for a pair rule, which carries its own handler
+const size_t PAIR_RULE = SIZE_MAX;
+
+// A rule to run for two bodies that have started colliding, held until
+// every pair has been tested so that the calls can be put in scene order
+typedef struct rule_call {
+  // The index of the tag rule, or PAIR_RULE
+  size_t rule;
+  // A pair rule's handler and aux, copied since rules may be added first
+  collision_handler_t handler;
+  void *aux;
+  body_t *body1;
+  body_t *body2;
+  // The bodies' indices in the scene, and the call's place in the queue
+  size_t order1;
+  size_t order2;
+  size_t queued;
+} rule_call_t;
+
+DEFINE_ARRAY(rule_call, rule_call_t)
+// A pair of bodies in contact, as their two handles with the smaller one
+// in the high bits
+DEFINE_ARRAY(contact, uint64_t)
+
+// Marks a body that is not in the scene's sweep or tree
+const size_t NO_PROXY = SIZE_MAX;
+// How far the tree's boxes extend past the bodies', so that bodies moving
+// a few pixels a tick are only reinserted every few ticks
+const real_t TREE_MARGIN = 8;
+
 typedef struct scene {
-  list_t *data;
-  list_t *force_creators;
+  body_ptr_array_t bodies;
+  // The handle of each body in this scene, indexed by body_handle_slot(),
+  // or BODY_HANDLE_NONE. Handles are global, so this tells which are ours.
+  handle_array_t members;
+  // Holds the bodies' linear state with SCENE_STORAGE_ARRAYS, else NULL
+  body_store_t *store;
+  aux_ptr_array_t force_creators;
+  // The force creators that depend on each body, indexed by
+  // body_handle_slot(), so that reaping a body only visits its own creators
+  creator_list_array_t creators_of;
+  // The force creators with each id, in no particular order
+  id_bucket_array_t by_id;
+  // The number of dead force creators still in force_creators
+  size_t n_dead;
+  // The bodies with each tag, in scene order, indexed by tag
+  body_list_array_t tagged;
+  collision_rule_array_t rules;
+  // Whether each tag appears in any rule
+  bool has_rules[BODY_MAX_TAGS];
+  // The handlers for single pairs of bodies, sorted by key, and how many
+  // involve each body, indexed by body_handle_slot()
+  pair_rule_array_t pair_rules;
+  proxy_array_t n_pair_rules;
+  scene_broadphase_t broadphase;
+  grid_t *grid;
+  // With SCENE_BROADPHASE_SWEEP, the sweep, else NULL
+  sweep_t *sweep;
+  // The sweep's proxy for each body, indexed by body_handle_slot()
+  proxy_array_t proxy_of;
+  // The body with each proxy
+  body_ptr_array_t proxy_bodies;
+  // A tree of every body in the scene, or NULL until it is first needed
+  aabb_tree_t *tree;
+  // The tree's proxy for each body, indexed by body_handle_slot()
+  proxy_array_t leaf_of;
+  // Scratch space for the proxies a query finds
+  proxy_array_t found;
+  // The pairs of proxies whose boxes overlap, sorted, as contact keys
+  contact_array_t candidates;
+  // The pairs of bodies that were colliding after the last tick, sorted
+  contact_array_t contacts;
+  // Scratch space for the collision stage, kept to avoid reallocating it:
+  // the bodies tested and their boxes, the candidate pairs, and the
+  // contacts being found
+  body_ptr_array_t colliders;
+  aabb_array_t boxes;
+  box_pair_array_t pairs;
+  box_pair_array_t removed_pairs;
+  contact_array_t next_contacts;
+  // The rules due this tick, and each body's index in bodies, indexed by
+  // body_handle_slot(), to order them by
+  rule_call_array_t calls;
+  proxy_array_t order_of;
+  // Holds the aux_t of every force creator
+  pool_t *creator_pool;
+  // Hold the force creators' own aux values (see scene_alloc_aux())
+  pool_t *aux_pools[N_AUX_POOLS];
 } scene_t;
 
-void aux_freer(aux_t *aux) {
-  if (aux->bodies != NULL) {
-    list_free2(aux->bodies);
+// Frees what a force creator owns, but not the aux_t itself
+void aux_free_contents(aux_t *aux) {
+  if (aux->bodies != aux->inline_bodies) {
+    free(aux->bodies);
   }
   if (aux->freer != NULL) {
     aux->freer(aux->aux);
   }
-  free(aux);
+}
+
+// Gets the force creators with an id, or NULL if there are none and
+// create is false
+aux_ptr_array_t *creators_with_id(scene_t *scene, size_t id, bool create) {
+  id_bucket_array_t *buckets = &scene->by_id;
+  for (size_t i = 0; i < id_bucket_array_size(buckets); i++) {
+    id_bucket_t *bucket = id_bucket_array_at(buckets, i);
+    if (bucket->id == id) {
+      return &bucket->creators;
+    }
+  }
+  if (!create) {
+    return NULL;
+  }
+  id_bucket_t bucket = {.id = id};
+  aux_ptr_array_init(&bucket.creators, 0);
+  id_bucket_array_push(buckets, bucket);
+  return &id_bucket_array_at(buckets, id_bucket_array_size(buckets) - 1)
+              ->creators;
+}
+
+// Gets the list of force creators that depend on a body
+creator_ref_array_t *creators_of(scene_t *scene, body_handle_t body) {
+  creator_list_array_t *lists = &scene->creators_of;
+  size_t slot = body_handle_slot(body);
+  while (creator_list_array_size(lists) <= slot) {
+    creator_ref_array_t empty;
+    creator_ref_array_init(&empty, 0);
+    creator_list_array_push(lists, empty);
+  }
+  return creator_list_array_at(lists, slot);
+}
+
+// Adds a force creator to the list for its id and the lists of all the
+// bodies it depends on
+void link_creator(scene_t *scene, aux_t *creator) {
+  aux_ptr_array_t *same_id = creators_with_id(scene, creator->id, true);
+  creator->id_position = aux_ptr_array_size(same_id);
+  aux_ptr_array_push(same_id, creator);
+  for (size_t k = 0; k < creator->n_bodies; k++) {
+    creator_ref_array_t *list = creators_of(scene, creator->bodies[k].body);
+    creator->bodies[k].position = creator_ref_array_size(list);
+    creator_ref_array_push(list, (creator_ref_t){creator, k});
+  }
+}
+
+// Takes a force creator out of those lists, in time proportional to the
+// number of bodies it depends on
+void unlink_creator(scene_t *scene, aux_t *creator) {
+  aux_ptr_array_t *same_id = creators_with_id(scene, creator->id, false);
+  aux_ptr_array_swap_remove(same_id, creator->id_position);
+  if (creator->id_position < aux_ptr_array_size(same_id)) {
+    aux_ptr_array_get(same_id, creator->id_position)->id_position =
+        creator->id_position;
+  }
+  for (size_t k = 0; k < creator->n_bodies; k++) {
+    creator_ref_array_t *list = creators_of(scene, creator->bodies[k].body);
+    size_t position = creator->bodies[k].position;
+    creator_ref_array_swap_remove(list, position);
+    if (position < creator_ref_array_size(list)) {
+      creator_ref_t moved = creator_ref_array_get(list, position);
+      moved.creator->bodies[moved.which].position = position;
+    }
+  }
 }
 
 scene_t *scene_init(void) {
+  return scene_init_with_storage(SCENE_STORAGE_BODIES);
+}
+
+scene_t *scene_init_with_storage(scene_storage_t storage) {
   scene_t *new_scene = malloc(sizeof(scene_t));
   assert(new_scene != NULL);
 
-  new_scene->data = list_init(orig_bodies, (free_func_t)body_free);
-  new_scene->force_creators = list_init(orig_bodies, (free_func_t)aux_freer);
+  body_ptr_array_init(&new_scene->bodies, orig_bodies);
+  handle_array_init(&new_scene->members, orig_bodies);
+  new_scene->store = storage == SCENE_STORAGE_ARRAYS
+                         ? body_store_init(orig_bodies)
+                         : NULL;
+  aux_ptr_array_init(&new_scene->force_creators, orig_bodies);
+  creator_list_array_init(&new_scene->creators_of, orig_bodies);
+  id_bucket_array_init(&new_scene->by_id, 0);
+  new_scene->n_dead = 0;
+  collision_rule_array_init(&new_scene->rules, 0);
+  pair_rule_array_init(&new_scene->pair_rules, 0);
+  proxy_array_init(&new_scene->n_pair_rules, 0);
+  for (size_t tag = 0; tag < BODY_MAX_TAGS; tag++) {
+    new_scene->has_rules[tag] = false;
+  }
+  new_scene->grid = grid_init(SCENE_CELL_SIZE);
+  contact_array_init(&new_scene->contacts, 0);
+  body_ptr_array_init(&new_scene->colliders, 0);
+  aabb_array_init(&new_scene->boxes, 0);
+  box_pair_array_init(&new_scene->pairs, 0);
+  box_pair_array_init(&new_scene->removed_pairs, 0);
+  new_scene->broadphase = SCENE_BROADPHASE_GRID;
+  new_scene->sweep = NULL;
+  new_scene->tree = NULL;
+  proxy_array_init(&new_scene->leaf_of, 0);
+  proxy_array_init(&new_scene->found, 0);
+  proxy_array_init(&new_scene->proxy_of, 0);
+  body_ptr_array_init(&new_scene->proxy_bodies, 0);
+  contact_array_init(&new_scene->candidates, 0);
+  contact_array_init(&new_scene->next_contacts, 0);
+  rule_call_array_init(&new_scene->calls, 0);
+  proxy_array_init(&new_scene->order_of, 0);
+  body_list_array_init(&new_scene->tagged, 0);
+  new_scene->creator_pool = pool_init(sizeof(aux_t), POOL_SLAB_OBJECTS);
+  for (size_t i = 0; i < N_AUX_POOLS; i++) {
+    new_scene->aux_pools[i] =
+        pool_init(MIN_AUX_SIZE << i, POOL_SLAB_OBJECTS);
+  }
 
   return new_scene;
 }
 
 void scene_free(scene_t *scene) {
-  list_free(scene->data);
-  list_free(scene->force_creators);
+  for (size_t i = 0; i < body_ptr_array_size(&scene->bodies); i++) {
+    body_free(body_ptr_array_get(&scene->bodies, i));
+  }
+  // Dead force creators have already freed their contents
+  for (size_t i = 0; i < aux_ptr_array_size(&scene->force_creators); i++) {
+    aux_t *force_creator = aux_ptr_array_get(&scene->force_creators, i);
+    if (!force_creator->dead) {
+      aux_free_contents(force_creator);
+    }
+  }
+  body_ptr_array_free(&scene->bodies);
+  handle_array_free(&scene->members);
+  if (scene->store != NULL) {
+    body_store_free(scene->store);
+  }
+  aux_ptr_array_free(&scene->force_creators);
+  for (size_t i = 0; i < creator_list_array_size(&scene->creators_of); i++) {
+    creator_ref_array_free(creator_list_array_at(&scene->creators_of, i));
+  }
+  creator_list_array_free(&scene->creators_of);
+  for (size_t i = 0; i < id_bucket_array_size(&scene->by_id); i++) {
+    aux_ptr_array_free(&id_bucket_array_at(&scene->by_id, i)->creators);
+  }
+  id_bucket_array_free(&scene->by_id);
+  for (size_t i = 0; i < collision_rule_array_size(&scene->rules); i++) {
+    collision_rule_t rule = collision_rule_array_get(&scene->rules, i);
+    if (rule.freer != NULL) {
+      rule.freer(rule.aux);
+    }
+  }
+  collision_rule_array_free(&scene->rules);
+  for (size_t i = 0; i < pair_rule_array_size(&scene->pair_rules); i++) {
+    pair_rule_t rule = pair_rule_array_get(&scene->pair_rules, i);
+    if (rule.freer != NULL) {
+      rule.freer(rule.aux);
+    }
+  }
+  pair_rule_array_free(&scene->pair_rules);
+  proxy_array_free(&scene->n_pair_rules);
+  grid_free(scene->grid);
+  contact_array_free(&scene->contacts);
+  body_ptr_array_free(&scene->colliders);
+  aabb_array_free(&scene->boxes);
+  box_pair_array_free(&scene->pairs);
+  box_pair_array_free(&scene->removed_pairs);
+  if (scene->sweep != NULL) {
+    sweep_free(scene->sweep);
+  }
+  proxy_array_free(&scene->proxy_of);
+  if (scene->tree != NULL) {
+    aabb_tree_free(scene->tree);
+  }
+  proxy_array_free(&scene->leaf_of);
+  proxy_array_free(&scene->found);
+  body_ptr_array_free(&scene->proxy_bodies);
+  contact_array_free(&scene->candidates);
+  contact_array_free(&scene->next_contacts);
+  rule_call_array_free(&scene->calls);
+  proxy_array_free(&scene->order_of);
+  for (size_t i = 0; i < body_list_array_size(&scene->tagged); i++) {
+    body_ptr_array_free(body_list_array_at(&scene->tagged, i));
+  }
+  body_list_array_free(&scene->tagged);
+  pool_free(scene->creator_pool);
+  for (size_t i = 0; i < N_AUX_POOLS; i++) {
+    pool_free(scene->aux_pools[i]);
+  }
   free(scene);
 }
 
-size_t scene_bodies(scene_t *scene) { return list_size(scene->data); }
+size_t scene_bodies(scene_t *scene) { return body_ptr_array_size(&scene->bodies); }
 
 body_t *scene_get_body(scene_t *scene, size_t index) {
-  return list_get(scene->data, index);
+  // Checked even when the array's own bounds checks are compiled out
+  assert(index < body_ptr_array_size(&scene->bodies));
+  return body_ptr_array_get(&scene->bodies, index);
+}
+
+const body_ptr_array_t *scene_get_bodies(scene_t *scene) {
+  return &scene->bodies;
+}
+
+// Gets the slot for a body in an array indexed by body_handle_slot(),
+// growing the array with NO_PROXY as needed
+size_t *proxy_slot(proxy_array_t *proxies, body_t *body) {
+  size_t slot = body_handle_slot(body_get_handle(body));
+  while (proxy_array_size(proxies) <= slot) {
+    proxy_array_push(proxies, NO_PROXY);
+  }
+  return proxy_array_at(proxies, slot);
+}
+
+// Puts a body in the tree
+void add_leaf(scene_t *scene, body_t *body) {
+  *proxy_slot(&scene->leaf_of, body) =
+      aabb_tree_insert(scene->tree, body_get_bounds(body), body);
+}
+
+body_handle_t scene_add_body(scene_t *scene, body_t *body) {
+  body_ptr_array_push(&scene->bodies, body);
+  body_handle_t handle = body_get_handle(body);
+  size_t slot = body_handle_slot(handle);
+  while (handle_array_size(&scene->members) <= slot) {
+    handle_array_push(&scene->members, BODY_HANDLE_NONE);
+  }
+  handle_array_set(&scene->members, slot, handle);
+  if (scene->tree != NULL) {
+    add_leaf(scene, body);
+  }
+  if (scene->store != NULL) {
+    body_store_add(scene->store, body);
+  }
+  size_t tag = body_get_tag(body);
+  if (tag != BODY_NO_TAG) {
+    body_list_array_t *tagged = &scene->tagged;
+    while (body_list_array_size(tagged) <= tag) {
+      body_ptr_array_t empty;
+      body_ptr_array_init(&empty, 0);
+      body_list_array_push(tagged, empty);
+    }
+    body_ptr_array_push(body_list_array_at(tagged, tag), body);
+  }
+  return body_get_handle(body);
+}
+
+const body_ptr_array_t *scene_get_tagged(scene_t *scene, size_t tag) {
+  static const body_ptr_array_t NONE = {0};
+  if (tag >= body_list_array_size(&scene->tagged)) {
+    return &NONE;
+  }
+  return body_list_array_at(&scene->tagged, tag);
+}
+
+size_t scene_count_tag(scene_t *scene, size_t tag) {
+  return body_ptr_array_size(scene_get_tagged(scene, tag));
+}
+
+body_t *scene_first_tag(scene_t *scene, size_t tag) {
+  const body_ptr_array_t *bodies = scene_get_tagged(scene, tag);
+  return body_ptr_array_size(bodies) > 0 ? body_ptr_array_get(bodies, 0)
+                                         : NULL;
+}
+
+body_t *scene_get_body_by_handle(scene_t *scene, body_handle_t handle) {
+  size_t slot = body_handle_slot(handle);
+  if (slot >= handle_array_size(&scene->members) ||
+      handle_array_get(&scene->members, slot) != handle) {
+    return NULL;
+  }
+  body_t *body = body_from_handle(handle);
+  if (body == NULL || body_is_removed(body)) {
+    return NULL;
+  }
+  return body;
 }
 
-void scene_add_body(scene_t *scene, body_t *body) {
-  list_add(scene->data, body);
+void scene_remove_body_by_handle(scene_t *scene, body_handle_t handle) {
+  body_t *body = scene_get_body_by_handle(scene, handle);
+  if (body != NULL) {
+    body_remove(body);
+  }
 }
 
 void scene_remove_body(scene_t *scene, size_t index) {
@@ -66,14 +480,36 @@ void scene_remove_body(scene_t *scene, size_t index) {
 void scene_add_bodies_force_creator(scene_t *scene, force_creator_t forcer,
                                     void *aux, list_t *bodies,
                                     free_func_t freer, size_t id) {
-  aux_t *newForce = malloc(sizeof(aux_t));
+  aux_t *newForce = pool_alloc(scene->creator_pool);
   newForce->force = forcer;
   newForce->aux = aux;
   newForce->freer = freer;
-  newForce->bodies = bodies;
   newForce->id = id;
+  newForce->dead = false;
+  newForce->n_bodies = bodies != NULL ? list_size(bodies) : 0;
+  newForce->bodies = newForce->inline_bodies;
+  if (newForce->n_bodies > AUX_INLINE_BODIES) {
+    newForce->bodies = malloc(sizeof(dependency_t) * newForce->n_bodies);
+    assert(newForce->bodies != NULL);
+  }
+  for (size_t i = 0; i < newForce->n_bodies; i++) {
+    newForce->bodies[i].body = body_get_handle(list_get(bodies, i));
+  }
+  if (bodies != NULL) {
+    list_free2(bodies);
+  }
+  link_creator(scene, newForce);
+
+  aux_ptr_array_push(&scene->force_creators, newForce);
+}
 
-  list_add(scene->force_creators, newForce);
+void *scene_alloc_aux(scene_t *scene, size_t size) {
+  assert(size <= SCENE_AUX_MAX_SIZE);
+  size_t i = 0;
+  while ((MIN_AUX_SIZE << i) < size) {
+    i++;
+  }
+  return pool_alloc(scene->aux_pools[i]);
 }
 
 void scene_add_force_creator(scene_t *scene, force_creator_t forcer, void *aux,
@@ -81,45 +517,676 @@ void scene_add_force_creator(scene_t *scene, force_creator_t forcer, void *aux,
   scene_add_bodies_force_creator(scene, forcer, aux, NULL, freer, id);
 }
 
+// Removes a force creator from the scene's lists and frees its contents.
+// Its aux_t stays in force_creators, marked dead, until the next
+// scene_tick() compacts the array, so that removing it does not have to
+// shift every later force creator.
+void kill_creator(scene_t *scene, aux_t *creator) {
+  unlink_creator(scene, creator);
+  aux_free_contents(creator);
+  creator->dead = true;
+  scene->n_dead++;
+}
+
 void scene_remove_force_creator(scene_t *scene, size_t id) {
-  for (size_t i = 0; i < list_size(scene->force_creators); i++){
-    aux_t *force_creator = list_get(scene->force_creators, i);
+  aux_ptr_array_t *same_id = creators_with_id(scene, id, false);
+  // Each kill takes the creator out of same_id
+  while (same_id != NULL && aux_ptr_array_size(same_id) > 0) {
+    kill_creator(scene, aux_ptr_array_get(same_id, 0));
+  }
+}
+
+// Whether a force creator is forcer and depends on exactly the bodies in a
+// list
+bool is_creator_on(aux_t *creator, force_creator_t forcer, list_t *bodies) {
+  if (creator->force != forcer) {
+    return false;
+  }
+  size_t n_bodies = bodies != NULL ? list_size(bodies) : 0;
+  if (creator->n_bodies != n_bodies) {
+    return false;
+  }
+  for (size_t k = 0; k < n_bodies; k++) {
+    if (creator->bodies[k].body != body_get_handle(list_get(bodies, k))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void scene_upsert_bodies_force_creator(scene_t *scene, force_creator_t forcer,
+                                       void *aux, list_t *bodies,
+                                       free_func_t freer, size_t id) {
+  aux_ptr_array_t *same_id = creators_with_id(scene, id, false);
+  size_t i = 0;
+  while (same_id != NULL && i < aux_ptr_array_size(same_id)) {
+    aux_t *creator = aux_ptr_array_get(same_id, i);
+    if (is_creator_on(creator, forcer, bodies)) {
+      // Another creator is swapped into position i
+      kill_creator(scene, creator);
+    } else {
+      i++;
+    }
+  }
+  scene_add_bodies_force_creator(scene, forcer, aux, bodies, freer, id);
+}
+
+// Drops the removed bodies from a list of bodies, keeping the others in order
+void remove_removed(body_ptr_array_t *bodies) {
+  size_t kept = 0;
+  for (size_t i = 0; i < body_ptr_array_size(bodies); i++) {
+    body_t *body = body_ptr_array_get(bodies, i);
+    if (!body_is_removed(body)) {
+      body_ptr_array_set(bodies, kept++, body);
+    }
+  }
+  body_ptr_array_truncate(bodies, kept);
+}
+
+// Kills the force creators that depend on a removed body
+void kill_creators_of(scene_t *scene, body_t *body) {
+  body_handle_t handle = body_get_handle(body);
+  creator_ref_array_t *list = creators_of(scene, handle);
+  size_t i = 0;
+  while (i < creator_ref_array_size(list)) {
+    creator_ref_t ref = creator_ref_array_get(list, i);
+    // Skip creators left behind by a freed body that had this slot before
+    if (ref.creator->bodies[ref.which].body != handle) {
+      i++;
+    } else {
+      // Another entry is swapped into position i
+      kill_creator(scene, ref.creator);
+    }
+  }
+}
+
+void scene_add_collision_handler(scene_t *scene, size_t tag1, size_t tag2,
+                                 collision_handler_t handler, void *aux,
+                                 free_func_t freer) {
+  assert(tag1 < BODY_MAX_TAGS && tag2 < BODY_MAX_TAGS);
+  collision_rule_t rule = {tag1, tag2, handler, aux, freer};
+  for (size_t i = 0; i < collision_rule_array_size(&scene->rules); i++) {
+    collision_rule_t *old = collision_rule_array_at(&scene->rules, i);
+    if (old->tag1 == tag1 && old->tag2 == tag2 && old->handler == handler) {
+      if (old->freer != NULL) {
+        old->freer(old->aux);
+      }
+      *old = rule;
+      return;
+    }
+  }
+  collision_rule_array_push(&scene->rules, rule);
+  scene->has_rules[tag1] = true;
+  scene->has_rules[tag2] = true;
+}
+
+void scene_set_broadphase(scene_t *scene, scene_broadphase_t broadphase) {
+  if (scene->sweep != NULL) {
+    sweep_free(scene->sweep);
+    scene->sweep = NULL;
+  }
+  proxy_array_truncate(&scene->proxy_of, 0);
+  body_ptr_array_truncate(&scene->proxy_bodies, 0);
+  contact_array_truncate(&scene->candidates, 0);
+  scene->broadphase = broadphase;
+  if (broadphase == SCENE_BROADPHASE_SWEEP) {
+    scene->sweep = sweep_init();
+  }
+}
+
+void scene_set_cell_size(scene_t *scene, real_t cell_size) {
+  grid_free(scene->grid);
+  scene->grid = grid_init(cell_size);
+}
+
+uint64_t contact_key(body_t *body1, body_t *body2) {
+  uint64_t handle1 = body_get_handle(body1);
+  uint64_t handle2 = body_get_handle(body2);
+  return handle1 < handle2 ? handle1 << 32 | handle2 : handle2 << 32 | handle1;
+}
+
+int compare_contacts(const void *a, const void *b) {
+  uint64_t contact1 = *(const uint64_t *)a;
+  uint64_t contact2 = *(const uint64_t *)b;
+  return contact1 < contact2 ? -1 : contact1 > contact2;
+}
+
+// The number of pair rules that involve a body
+size_t *pair_rule_count(scene_t *scene, body_t *body) {
+  size_t slot = body_handle_slot(body_get_handle(body));
+  while (proxy_array_size(&scene->n_pair_rules) <= slot) {
+    proxy_array_push(&scene->n_pair_rules, 0);
+  }
+  return proxy_array_at(&scene->n_pair_rules, slot);
+}
+
+void scene_add_pair_collision_handler(scene_t *scene, body_t *body1,
+                                      body_t *body2,
+                                      collision_handler_t handler, void *aux,
+                                      free_func_t freer) {
+  pair_rule_t rule = {contact_key(body1, body2), body1, body2, handler, aux,
+                      freer, true};
+  // Kept sorted, with the rules for one pair in the order they were added
+  pair_rule_array_t *rules = &scene->pair_rules;
+  pair_rule_array_push(rules, rule);
+  size_t i = pair_rule_array_size(rules) - 1;
+  for (; i > 0 && rules->data[i - 1].key > rule.key; i--) {
+    rules->data[i] = rules->data[i - 1];
+  }
+  rules->data[i] = rule;
+  (*pair_rule_count(scene, body1))++;
+  (*pair_rule_count(scene, body2))++;
+}
+
+// The first of the pair rules for two bodies, or NULL if they have none
+pair_rule_t *find_pair_rules(scene_t *scene, body_t *body1, body_t *body2) {
+  if (*pair_rule_count(scene, body1) == 0 ||
+      *pair_rule_count(scene, body2) == 0) {
+    return NULL;
+  }
+  uint64_t key = contact_key(body1, body2);
+  pair_rule_array_t *rules = &scene->pair_rules;
+  size_t low = 0;
+  size_t high = pair_rule_array_size(rules);
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    if (rules->data[mid].key < key) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low < pair_rule_array_size(rules) && rules->data[low].key == key
+             ? &rules->data[low]
+             : NULL;
+}
+
+// Drops the pair rules of bodies that are about to be freed
+void remove_pair_rules(scene_t *scene) {
+  pair_rule_array_t *rules = &scene->pair_rules;
+  size_t kept = 0;
+  for (size_t i = 0; i < pair_rule_array_size(rules); i++) {
+    pair_rule_t rule = pair_rule_array_get(rules, i);
+    if (body_is_removed(rule.body1) || body_is_removed(rule.body2)) {
+      if (rule.freer != NULL) {
+        rule.freer(rule.aux);
+      }
+      (*pair_rule_count(scene, rule.body1))--;
+      (*pair_rule_count(scene, rule.body2))--;
+    } else {
+      pair_rule_array_set(rules, kept++, rule);
+    }
+  }
+  pair_rule_array_truncate(rules, kept);
+}
+
+// Whether any rule applies to a pair of tags
+bool has_rule(scene_t *scene, size_t tag1, size_t tag2) {
+  for (size_t i = 0; i < collision_rule_array_size(&scene->rules); i++) {
+    collision_rule_t rule = collision_rule_array_get(&scene->rules, i);
+    if ((rule.tag1 == tag1 && rule.tag2 == tag2) ||
+        (rule.tag1 == tag2 && rule.tag2 == tag1)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Queues the rules for two bodies that have started colliding.
+// A rule applies to each order of the bodies that matches its tags, so
+// a rule between a tag and itself applies twice, as a force creator
+// registered for each order would.
+void queue_rules(scene_t *scene, body_t *body1, body_t *body2) {
+  size_t tag1 = body_get_tag(body1);
+  size_t tag2 = body_get_tag(body2);
+  for (size_t i = 0; i < collision_rule_array_size(&scene->rules); i++) {
+    collision_rule_t rule = collision_rule_array_get(&scene->rules, i);
+    if (rule.tag1 == tag1 && rule.tag2 == tag2) {
+      rule_call_t call = {.rule = i, .body1 = body1, .body2 = body2};
+      rule_call_array_push(&scene->calls, call);
+    }
+    if (rule.tag1 == tag2 && rule.tag2 == tag1) {
+      rule_call_t call = {.rule = i, .body1 = body2, .body2 = body1};
+      rule_call_array_push(&scene->calls, call);
+    }
+  }
+}
+
+// Queues the pair rules starting at the given one that are due: those
+// for bodies that were not colliding after the last tick, and new ones
+void queue_pair_rules(scene_t *scene, pair_rule_t *rule, bool was_colliding) {
+  pair_rule_t *end = scene->pair_rules.data + scene->pair_rules.size;
+  for (uint64_t key = rule->key; rule < end && rule->key == key; rule++) {
+    if (!was_colliding || rule->fresh) {
+      rule_call_t call = {PAIR_RULE, rule->handler, rule->aux, rule->body1,
+                          rule->body2};
+      rule_call_array_push(&scene->calls, call);
+    }
+    rule->fresh = false;
+  }
+}
+
+int compare_calls(const void *a, const void *b) {
+  const rule_call_t *call1 = a;
+  const rule_call_t *call2 = b;
+  if (call1->order2 != call2->order2) {
+    return call1->order2 < call2->order2 ? -1 : 1;
+  }
+  if (call1->order1 != call2->order1) {
+    return call1->order1 < call2->order1 ? -1 : 1;
+  }
+  return call1->queued < call2->queued ? -1 : call1->queued > call2->queued;
+}
+
+// Calls the queued handlers ordered by the scene index of each call's body2,
+// then body1, which is the order that per-pair force creators made by
+// looping over the scene run in. Each pair is tested again in the call's
+// order so the handler gets the same axis as such a force creator.
+void run_rules(scene_t *scene) {
+  rule_call_array_t *calls = &scene->calls;
+  if (rule_call_array_size(calls) == 0) {
+    return;
+  }
+  for (size_t i = 0; i < body_ptr_array_size(&scene->bodies); i++) {
+    *proxy_slot(&scene->order_of, body_ptr_array_get(&scene->bodies, i)) = i;
+  }
+  for (size_t i = 0; i < rule_call_array_size(calls); i++) {
+    rule_call_t *call = rule_call_array_at(calls, i);
+    call->order1 = *proxy_slot(&scene->order_of, call->body1);
+    call->order2 = *proxy_slot(&scene->order_of, call->body2);
+    call->queued = i;
+  }
+  if (rule_call_array_size(calls) > 1) {
+    qsort(calls->data, rule_call_array_size(calls), sizeof(rule_call_t),
+          compare_calls);
+  }
+  // Handlers may add rules, so the array is indexed afresh each time
+  for (size_t i = 0; i < rule_call_array_size(calls); i++) {
+    rule_call_t call = rule_call_array_get(calls, i);
+    if (call.rule != PAIR_RULE) {
+      collision_rule_t rule =
+          collision_rule_array_get(&scene->rules, call.rule);
+      call.handler = rule.handler;
+      call.aux = rule.aux;
+    }
+    collision_info_t collision = find_collision_bodies(call.body1, call.body2);
+    call.handler(call.body1, call.body2, collision.axis, call.aux);
+  }
+  rule_call_array_truncate(calls, 0);
+}
+
+// Whether a body should be in the broadphase: it has opted in and a tag
+// rule has its tag, or a pair rule has it
+bool can_collide(scene_t *scene, body_t *body) {
+  size_t tag = body_get_tag(body);
+  if (body_is_removed(body)) {
+    return false;
+  }
+  return (body_is_collidable(body) && tag != BODY_NO_TAG &&
+          scene->has_rules[tag]) ||
+         *pair_rule_count(scene, body) > 0;
+}
+
+// Tests a pair of bodies that may be colliding, recording the contact
+// and queueing the handlers if they have just started colliding
+void collide_pair(scene_t *scene, body_t *body1, body_t *body2) {
+  if (body_is_removed(body1) || body_is_removed(body2)) {
+    return;
+  }
+  bool by_tags = body_is_collidable(body1) && body_is_collidable(body2) &&
+                 has_rule(scene, body_get_tag(body1), body_get_tag(body2));
+  pair_rule_t *by_pair = find_pair_rules(scene, body1, body2);
+  if (!by_tags && by_pair == NULL) {
+    return;
+  }
+  collision_info_t collision = find_collision_bodies(body1, body2);
+  if (!collision.collided) {
+    return;
+  }
+  uint64_t key = contact_key(body1, body2);
+  contact_array_push(&scene->next_contacts, key);
+  bool was_colliding =
+      contact_array_size(&scene->contacts) > 0 &&
+      bsearch(&key, scene->contacts.data, contact_array_size(&scene->contacts),
+              sizeof(uint64_t), compare_contacts) != NULL;
+  if (by_tags && !was_colliding) {
+    queue_rules(scene, body1, body2);
+  }
+  if (by_pair != NULL) {
+    queue_pair_rules(scene, by_pair, was_colliding);
+  }
+}
+
+void collide_grid(scene_t *scene) {
+  body_ptr_array_t *colliders = &scene->colliders;
+  aabb_array_t *boxes = &scene->boxes;
+  body_ptr_array_truncate(colliders, 0);
+  aabb_array_truncate(boxes, 0);
+  for (size_t i = 0; i < body_ptr_array_size(&scene->bodies); i++) {
+    body_t *body = body_ptr_array_get(&scene->bodies, i);
+    if (can_collide(scene, body)) {
+      body_ptr_array_push(colliders, body);
+      aabb_array_push(boxes, body_get_bounds(body));
+    }
+  }
+
+  box_pair_array_t *pairs = &scene->pairs;
+  grid_find_pairs(scene->grid, boxes->data, aabb_array_size(boxes), pairs);
+  for (size_t i = 0; i < box_pair_array_size(pairs); i++) {
+    box_pair_t pair = box_pair_array_get(pairs, i);
+    collide_pair(scene, body_ptr_array_get(colliders, pair.first),
+                 body_ptr_array_get(colliders, pair.second));
+  }
+}
+
+// Takes a body out of the sweep, if it is in it
+void drop_proxy(scene_t *scene, body_t *body) {
+  size_t slot = body_handle_slot(body_get_handle(body));
+  if (slot < proxy_array_size(&scene->proxy_of) &&
+      proxy_array_get(&scene->proxy_of, slot) != NO_PROXY) {
+    size_t proxy = proxy_array_get(&scene->proxy_of, slot);
+    sweep_remove(scene->sweep, proxy);
+    body_ptr_array_set(&scene->proxy_bodies, proxy, NULL);
+    proxy_array_set(&scene->proxy_of, slot, NO_PROXY);
+  }
+}
+
+uint64_t box_pair_key(box_pair_t pair) {
+  return (uint64_t)pair.first << 32 | pair.second;
+}
+
+// Applies a sweep's changes to the sorted list of overlapping pairs
+// by merging the three sorted lists
+void merge_candidates(scene_t *scene, box_pair_array_t *added,
+                      box_pair_array_t *removed) {
+  contact_array_t *old = &scene->candidates;
+  contact_array_t *merged = &scene->next_contacts;
+  contact_array_truncate(merged, 0);
+  size_t i = 0;
+  size_t j = 0;
+  for (size_t k = 0; k < contact_array_size(old); k++) {
+    uint64_t key = contact_array_get(old, k);
+    for (; i < box_pair_array_size(added) &&
+           box_pair_key(box_pair_array_get(added, i)) < key;
+         i++) {
+      contact_array_push(merged, box_pair_key(box_pair_array_get(added, i)));
+    }
+    for (; j < box_pair_array_size(removed) &&
+           box_pair_key(box_pair_array_get(removed, j)) < key;
+         j++) {
+    }
+    if (j < box_pair_array_size(removed) &&
+        box_pair_key(box_pair_array_get(removed, j)) == key) {
+      j++;
+    } else {
+      contact_array_push(merged, key);
+    }
+  }
+  for (; i < box_pair_array_size(added); i++) {
+    contact_array_push(merged, box_pair_key(box_pair_array_get(added, i)));
+  }
+  contact_array_t last = scene->candidates;
+  scene->candidates = scene->next_contacts;
+  scene->next_contacts = last;
+}
 
-    if (force_creator->id == id) {
-      aux_freer(list_remove(scene->force_creators, i));
+void collide_sweep(scene_t *scene) {
+  for (size_t i = 0; i < body_ptr_array_size(&scene->bodies); i++) {
+    body_t *body = body_ptr_array_get(&scene->bodies, i);
+    if (!can_collide(scene, body)) {
+      drop_proxy(scene, body);
+      continue;
     }
+    aabb_t box = body_get_bounds(body);
+    size_t slot = body_handle_slot(body_get_handle(body));
+    while (proxy_array_size(&scene->proxy_of) <= slot) {
+      proxy_array_push(&scene->proxy_of, NO_PROXY);
+    }
+    size_t proxy = proxy_array_get(&scene->proxy_of, slot);
+    if (proxy != NO_PROXY) {
+      sweep_move(scene->sweep, proxy, box);
+      continue;
+    }
+    proxy = sweep_add(scene->sweep, box);
+    proxy_array_set(&scene->proxy_of, slot, proxy);
+    while (body_ptr_array_size(&scene->proxy_bodies) <= proxy) {
+      body_ptr_array_push(&scene->proxy_bodies, NULL);
+    }
+    body_ptr_array_set(&scene->proxy_bodies, proxy, body);
+  }
+
+  box_pair_array_t *added = &scene->pairs;
+  box_pair_array_t *removed = &scene->removed_pairs;
+  sweep_update(scene->sweep, added, removed);
+  merge_candidates(scene, added, removed);
+
+  contact_array_truncate(&scene->next_contacts, 0);
+  for (size_t i = 0; i < contact_array_size(&scene->candidates); i++) {
+    uint64_t key = contact_array_get(&scene->candidates, i);
+    collide_pair(scene,
+                 body_ptr_array_get(&scene->proxy_bodies, key >> 32),
+                 body_ptr_array_get(&scene->proxy_bodies, key & UINT32_MAX));
+  }
+}
+
+// Takes a body out of the tree, if it is in it
+void drop_leaf(scene_t *scene, body_t *body) {
+  size_t *leaf = proxy_slot(&scene->leaf_of, body);
+  if (*leaf != NO_PROXY) {
+    aabb_tree_remove(scene->tree, *leaf);
+    *leaf = NO_PROXY;
+  }
+}
+
+// Brings the tree up to date with the scene's bodies, building it if needed.
+// This visits every body, so it is done once per tick rather than per query.
+// Bodies that stay inside their fat boxes cost only their box.
+void sync_tree(scene_t *scene) {
+  if (scene->tree == NULL) {
+    scene->tree = aabb_tree_init(TREE_MARGIN);
+  }
+  for (size_t i = 0; i < body_ptr_array_size(&scene->bodies); i++) {
+    body_t *body = body_ptr_array_get(&scene->bodies, i);
+    size_t leaf = *proxy_slot(&scene->leaf_of, body);
+    if (body_is_removed(body)) {
+      drop_leaf(scene, body);
+    } else if (leaf == NO_PROXY) {
+      add_leaf(scene, body);
+    } else {
+      aabb_tree_move(scene->tree, leaf, body_get_bounds(body));
+    }
+  }
+}
+
+// Builds the tree if no query has yet
+aabb_tree_t *query_tree(scene_t *scene) {
+  if (scene->tree == NULL) {
+    sync_tree(scene);
+  }
+  return scene->tree;
+}
+
+void collide_tree(scene_t *scene) {
+  sync_tree(scene);
+  box_pair_array_t *pairs = &scene->pairs;
+  aabb_tree_find_pairs(scene->tree, pairs);
+  // Handlers may add bodies, which can move the tree's nodes,
+  // so the pairs are turned into bodies first, two at a time
+  body_ptr_array_t *colliders = &scene->colliders;
+  body_ptr_array_truncate(colliders, 0);
+  for (size_t i = 0; i < box_pair_array_size(pairs); i++) {
+    box_pair_t pair = box_pair_array_get(pairs, i);
+    body_t *body1 = aabb_tree_data(scene->tree, pair.first);
+    body_t *body2 = aabb_tree_data(scene->tree, pair.second);
+    if (can_collide(scene, body1) && can_collide(scene, body2)) {
+      body_ptr_array_push(colliders, body1);
+      body_ptr_array_push(colliders, body2);
+    }
+  }
+  for (size_t i = 0; i < body_ptr_array_size(colliders); i += 2) {
+    collide_pair(scene, body_ptr_array_get(colliders, i),
+                 body_ptr_array_get(colliders, i + 1));
+  }
+}
+
+// Finds the collidable bodies that are colliding and calls the handlers
+// for the ones that were not colliding after the last tick
+void collide_bodies(scene_t *scene) {
+  contact_array_truncate(&scene->next_contacts, 0);
+  if (scene->broadphase == SCENE_BROADPHASE_SWEEP) {
+    collide_sweep(scene);
+  } else if (scene->broadphase == SCENE_BROADPHASE_TREE) {
+    collide_tree(scene);
+  } else {
+    collide_grid(scene);
+  }
+  run_rules(scene);
+
+  contact_array_t *contacts = &scene->next_contacts;
+  if (contact_array_size(contacts) > 1) {
+    qsort(contacts->data, contact_array_size(contacts), sizeof(uint64_t),
+          compare_contacts);
   }
+  contact_array_t last = scene->contacts;
+  scene->contacts = scene->next_contacts;
+  scene->next_contacts = last;
 }
 
 void scene_tick(scene_t *scene, double dt) {
+  aux_ptr_array_t *force_creators = &scene->force_creators;
+  body_ptr_array_t *bodies = &scene->bodies;
+
   // execute all the force creators
-  for (size_t i = 0; i < list_size(scene->force_creators); i++) {
-    aux_t *force_creator = list_get(scene->force_creators, i);
-    force_creator_t force = force_creator->force;
-    void *force_aux = force_creator->aux;
-    force(force_aux);
+  for (size_t i = 0; i < aux_ptr_array_size(force_creators); i++) {
+    aux_t *force_creator = aux_ptr_array_get(force_creators, i);
+    if (!force_creator->dead) {
+      force_creator->force(force_creator->aux);
+    }
+  }
+  if (collision_rule_array_size(&scene->rules) > 0 ||
+      pair_rule_array_size(&scene->pair_rules) > 0) {
+    collide_bodies(scene);
   }
 
-  // Tick each body using body_tick. If any of the bodies are marked for
-  // removal, then they should be removed from the scene and freed
-  for (size_t i = list_size(scene->data); i > 0; i--) {
-    body_t *body = list_get(scene->data, i - 1);
-    if (body_is_removed(body)) {
-      for (size_t j = list_size(scene->force_creators); j > 0; j--) {
-        aux_t *aux = list_get(scene->force_creators, j - 1);
-        list_t *bodies = aux->bodies;
-        if (bodies != NULL) {
-          for (size_t k = 0; k < list_size(bodies); k++) {
-            if (list_get(bodies, k) == body) {
-              aux_freer(list_remove(scene->force_creators, j - 1));
-              break;
-            }
-          }
+  // Tick each body using body_tick, counting the ones marked for removal
+  size_t n_removed = 0;
+  if (scene->store != NULL) {
+    // Bodies about to be removed are ticked too, which nothing can observe
+    if (dt != 0) {
+      body_store_tick(scene->store, dt);
+    }
+    n_removed = body_store_removed(scene->store);
+  } else {
+    for (size_t i = 0; i < body_ptr_array_size(bodies); i++) {
+      body_t *body = body_ptr_array_get(bodies, i);
+      if (body_is_removed(body)) {
+        n_removed++;
+      } else if (dt != 0) {
+        body_tick(body, dt);
+      }
+    }
+  }
+
+  // Reap removed bodies and the force creators acting on them, compacting
+  // each array in one stable pass.
+  // Each removed body's own list says which creators die with it;
+  // together with any creators removed by id, those are taken out of
+  // force_creators before the bodies are freed.
+  if (n_removed > 0) {
+    bool tag_has_removed[BODY_MAX_TAGS] = {false};
+    for (size_t i = 0; i < body_ptr_array_size(bodies); i++) {
+      body_t *body = body_ptr_array_get(bodies, i);
+      if (body_is_removed(body)) {
+        kill_creators_of(scene, body);
+        if (scene->sweep != NULL) {
+          drop_proxy(scene, body);
+        }
+        if (scene->tree != NULL) {
+          drop_leaf(scene, body);
         }
+        if (body_get_tag(body) != BODY_NO_TAG) {
+          tag_has_removed[body_get_tag(body)] = true;
+        }
+      }
+    }
+    if (pair_rule_array_size(&scene->pair_rules) > 0) {
+      remove_pair_rules(scene);
+    }
+    for (size_t tag = 0; tag < body_list_array_size(&scene->tagged); tag++) {
+      if (tag_has_removed[tag]) {
+        remove_removed(body_list_array_at(&scene->tagged, tag));
+      }
+    }
+  }
+
+  if (scene->n_dead > 0) {
+    size_t kept = 0;
+    for (size_t i = 0; i < aux_ptr_array_size(force_creators); i++) {
+      aux_t *force_creator = aux_ptr_array_get(force_creators, i);
+      if (force_creator->dead) {
+        pool_release(force_creator);
+      } else {
+        aux_ptr_array_set(force_creators, kept++, force_creator);
+      }
+    }
+    aux_ptr_array_truncate(force_creators, kept);
+    scene->n_dead = 0;
+  }
+
+  if (n_removed > 0) {
+    size_t kept = 0;
+    for (size_t i = 0; i < body_ptr_array_size(bodies); i++) {
+      body_t *body = body_ptr_array_get(bodies, i);
+      if (body_is_removed(body)) {
+        handle_array_set(&scene->members,
+                         body_handle_slot(body_get_handle(body)),
+                         BODY_HANDLE_NONE);
+        body_free(body);
+      } else {
+        body_ptr_array_set(bodies, kept++, body);
       }
-      body_free(list_remove(scene->data, i - 1));
-    } else if (dt != 0) {
-      body_tick(body, dt);
+    }
+    body_ptr_array_truncate(bodies, kept);
+  }
+
+  // Bring the queries' tree to where the bodies now are
+  if (scene->tree != NULL) {
+    sync_tree(scene);
+  }
+}
+
+// Gets the bodies with the proxies a query found, leaving out those removed
+// since the last tick
+void found_bodies(scene_t *scene, body_ptr_array_t *bodies) {
+  body_ptr_array_truncate(bodies, 0);
+  for (size_t i = 0; i < proxy_array_size(&scene->found); i++) {
+    size_t proxy = proxy_array_get(&scene->found, i);
+    body_t *body = aabb_tree_data(scene->tree, proxy);
+    if (!body_is_removed(body)) {
+      body_ptr_array_push(bodies, body);
     }
   }
 }
+
+void scene_query_point(scene_t *scene, vector_t point,
+                       body_ptr_array_t *bodies) {
+  aabb_tree_query_point(query_tree(scene), point, &scene->found);
+  found_bodies(scene, bodies);
+}
+
+void scene_query_box(scene_t *scene, aabb_t box, body_ptr_array_t *bodies) {
+  aabb_tree_query_box(query_tree(scene), box, &scene->found);
+  found_bodies(scene, bodies);
+}
+
+void scene_query_radius(scene_t *scene, vector_t center, real_t radius,
+                        body_ptr_array_t *bodies) {
+  aabb_tree_query_radius(query_tree(scene), center, radius, &scene->found);
+  found_bodies(scene, bodies);
+}
+
+void scene_query_ray(scene_t *scene, vector_t from, vector_t to,
+                     body_ptr_array_t *bodies) {
+  aabb_tree_query_ray(query_tree(scene), from, to, &scene->found);
+  found_bodies(scene, bodies);
+}
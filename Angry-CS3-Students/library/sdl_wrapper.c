@@ -1,5 +1,6 @@
 #include "sdl_wrapper.h"
 #include "scene.h"
+#include "vec_batch.h"
 #include <SDL2/SDL.h>
 #include <SDL2/SDL2_gfxPrimitives.h>
 
@@ -268,9 +269,9 @@ void sdl_clear(void) {
   SDL_RenderClear(renderer);
 }
 
-void sdl_draw_polygon(list_t *points, rgb_color_t color) {
+void sdl_draw_polygon_array(const vertex_array_t *points, rgb_color_t color) {
   // Check parameters
-  size_t n = list_size(points);
+  size_t n = points->size;
   assert(n >= 3);
   assert(0 <= color.r && color.r <= 1);
   assert(0 <= color.g && color.g <= 1);
@@ -283,12 +284,9 @@ void sdl_draw_polygon(list_t *points, rgb_color_t color) {
           *y_points = malloc(sizeof(*y_points) * n);
   assert(x_points != NULL);
   assert(y_points != NULL);
-  for (size_t i = 0; i < n; i++) {
-    vector_t *vertex = list_get(points, i);
-    vector_t pixel = get_window_position(*vertex, window_center);
-    x_points[i] = pixel.x;
-    y_points[i] = pixel.y;
-  }
+  const vector_t *v = points->data;
+  vec_to_pixels_n(&v->x, &v->y, 2, n, center, get_scene_scale(window_center),
+                  window_center, x_points, y_points);
 
   // Draw polygon with the given color
   filledPolygonRGBA(renderer, x_points, y_points, n, color.r * 255,
@@ -297,6 +295,12 @@ void sdl_draw_polygon(list_t *points, rgb_color_t color) {
   free(y_points);
 }
 
+void sdl_draw_polygon(list_t *points, rgb_color_t color) {
+  vertex_array_t *array = vertex_array_from_list(points);
+  sdl_draw_polygon_array(array, color);
+  vertex_array_free(array);
+}
+
 void sdl_show(void) {
   // Draw boundary lines
   vector_t window_center = get_window_center();
@@ -317,12 +321,10 @@ void sdl_show(void) {
 }
 
 void sdl_render_scene(scene_t *scene) {
-  size_t body_count = scene_bodies(scene);
-  for (size_t i = 0; i < body_count; i++) {
-    body_t *body = scene_get_body(scene, i);
-    list_t *shape = body_get_shape(body);
-    sdl_draw_polygon(shape, body_get_color(body));
-    list_free(shape);
+  const body_ptr_array_t *bodies = scene_get_bodies(scene);
+  for (size_t i = 0; i < body_ptr_array_size(bodies); i++) {
+    body_t *body = body_ptr_array_get(bodies, i);
+    sdl_draw_polygon_array(body_shape_view(body), body_get_color(body));
   }
 }
 
@@ -0,0 +1,128 @@
+#include "shape.h"
+#include "array.h"
+#include "polygon.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Normals whose cross product is smaller than this are taken as parallel
+const real_t PARALLEL_TOLERANCE = 1e-6;
+
+// Registry entries are told apart by their kind and parameters
+typedef struct entry {
+  const char *kind;
+  real_t param1;
+  real_t param2;
+  shape_t *shape;
+} entry_t;
+
+DEFINE_ARRAY(entry, entry_t)
+
+// The registry is only ever reached through registry()
+entry_array_t *registry(void) {
+  static entry_array_t entries;
+  static bool initialized = false;
+  if (!initialized) {
+    entry_array_init(&entries, 16);
+    initialized = true;
+  }
+  return &entries;
+}
+
+shape_t *shape_init(vertex_array_t *vertices) {
+  assert(vertices != NULL);
+  shape_t *shape = malloc(sizeof(shape_t));
+  assert(shape != NULL);
+
+  polygon_mass_properties_t properties =
+      polygon_array_mass_properties(vertices);
+  size_t size = vertices->size;
+  vertex_array_t *normals = vertex_array_init(size);
+  real_t max_dist2 = 0;
+  for (size_t i = 0; i < size; i++) {
+    vector_t edge = vec_subtract(vertices->data[(i + 1) % size],
+                                 vertices->data[i]);
+    real_t length = real_sqrt(vec_dot(edge, edge));
+    normals->data[i] = (vector_t){edge.y / length, -edge.x / length};
+    real_t dist2 = vec_dot(vertices->data[i], vertices->data[i]);
+    if (dist2 > max_dist2) {
+      max_dist2 = dist2;
+    }
+  }
+
+  // Shapes have few edges, so each normal is compared with every axis kept
+  vector_t *kept = malloc(sizeof(vector_t) * size);
+  assert(kept != NULL);
+  size_t n_axes = 0;
+  for (size_t i = 0; i < size; i++) {
+    vector_t normal = normals->data[i];
+    bool parallel = false;
+    for (size_t k = 0; k < n_axes && !parallel; k++) {
+      real_t cross = vec_cross(normal, kept[k]);
+      parallel = cross < PARALLEL_TOLERANCE && cross > -PARALLEL_TOLERANCE;
+    }
+    if (!parallel) {
+      kept[n_axes++] = normal;
+    }
+  }
+  vertex_array_t *axes = vertex_array_from(kept, n_axes);
+  free(kept);
+
+  shape->vertices = vertices;
+  shape->normals = normals;
+  shape->axes = axes;
+  shape->bounds = aabb_of(vertices);
+  shape->area = properties.area;
+  shape->inertia = properties.inertia;
+  shape->radius = real_sqrt(max_dist2);
+  shape->refs = 1;
+  return shape;
+}
+
+shape_t *shape_retain(shape_t *shape) {
+  shape->refs++;
+  return shape;
+}
+
+void shape_release(shape_t *shape) {
+  assert(shape->refs > 0);
+  if (--shape->refs == 0) {
+    vertex_array_free(shape->vertices);
+    vertex_array_free(shape->normals);
+    vertex_array_free(shape->axes);
+    free(shape);
+  }
+}
+
+shape_t *shape_intern(const char *kind, real_t param1, real_t param2,
+                      shape_maker_t make) {
+  entry_array_t *entries = registry();
+  for (size_t i = 0; i < entry_array_size(entries); i++) {
+    entry_t *entry = entry_array_at(entries, i);
+    if (entry->param1 == param1 && entry->param2 == param2 &&
+        strcmp(entry->kind, kind) == 0) {
+      return entry->shape;
+    }
+  }
+
+  vertex_array_t *vertices = make(param1, param2);
+  polygon_array_translate(vertices,
+                          vec_negate(polygon_array_centroid(vertices)));
+  entry_t entry = {.kind = kind,
+                   .param1 = param1,
+                   .param2 = param2,
+                   .shape = shape_init(vertices)};
+  entry_array_push(entries, entry);
+  return entry.shape;
+}
+
+size_t shape_registry_size(void) { return entry_array_size(registry()); }
+
+void shape_registry_clear(void) {
+  entry_array_t *entries = registry();
+  for (size_t i = 0; i < entry_array_size(entries); i++) {
+    shape_release(entry_array_get(entries, i).shape);
+  }
+  entry_array_truncate(entries, 0);
+}
@@ -17,8 +17,23 @@ jmp_buf env;
 #include <unistd.h>
 #endif
 
+// Single precision keeps about 7 significant digits instead of 16, so in a
+// -DPHYSICS_REAL=float build tolerances are a thousand times looser and
+// relative to the magnitude of the values compared (with a floor of 1)
+#if PHYSICS_FLOAT
+const double PRECISION_SCALE = 1e3;
+
+double magnitude(double d1, double d2) {
+  return fmax(1, fmax(fabs(d1), fabs(d2)));
+}
+#else
+const double PRECISION_SCALE = 1;
+
+double magnitude(double d1, double d2) { return 1; }
+#endif
+
 bool within(double epsilon, double d1, double d2) {
-  return fabs(d1 - d2) < epsilon;
+  return fabs(d1 - d2) < epsilon * PRECISION_SCALE * magnitude(d1, d2);
 }
 
 bool isclose(double d1, double d2) { return within(1e-7, d1, d2); }
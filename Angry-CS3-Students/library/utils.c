@@ -11,67 +11,57 @@
 
 // Helper function to get body in the scene based on id
 body_t *get_body(scene_t *scene, size_t body_id) {
-    // initialize to something random to surpress warnings, will be replaced by 
-    // actual body later
-    body_t *ret_body = scene_get_body(scene, 0); 
-    for (size_t i = 0; i < scene_bodies(scene); i++) {
-        size_t* info = body_get_info(scene_get_body(scene, i));
-
-        if (*info == body_id) {
-            ret_body = scene_get_body(scene, i);
-            break;
-        }
-    }
-    return ret_body;
-}
-
-// Helper function to get body in the scene based on id
-size_t get_idx(scene_t *scene, size_t body_id) {
-    // initialize to something random to surpress warnings, will be replaced by 
-    // actual idx later
-    size_t ret_idx = 0; 
-    for (size_t i = 0; i < scene_bodies(scene); i++) {
-        size_t* info = body_get_info(scene_get_body(scene, i));
-
-        if (*info == body_id) {
-            ret_idx = i;
-            break;
-        }
-    }
-    return ret_idx;
+    body_t *body = scene_first_tag(scene, body_id);
+    // Callers expect a body even if there is none with the id
+    return body != NULL ? body : scene_get_body(scene, 0);
 }
 
 // Helper function to construct circle with given radius centered at (0, 0)
-list_t *make_circle(double radius) {
-  list_t *circle = list_init(N_CIRCLE_PTS, free);
-  double arc_angle = 2 * M_PI / N_CIRCLE_PTS;
-  vector_t point = {.x = radius, .y = 0.0};
+vertex_array_t *make_circle(double radius) {
+  const vector_t *unit = polygon_unit_circle(N_CIRCLE_PTS);
+  vertex_array_t *circle = vertex_array_init(N_CIRCLE_PTS);
   for (size_t i = 0; i < N_CIRCLE_PTS; i++)
   {
-    vector_t *v = malloc(sizeof(*v));
-    *v = point;
-    list_add(circle, v);
-    point = vec_rotate(point, arc_angle);
+    circle->data[i] = vec_multiply(radius, unit[i]);
   }
   return circle;
 }
 
 // Helper function to construct an equilateral triangle with given side length
-list_t *make_equilateral_triangle(double side_length) {
-  list_t *triangle = list_init(3, free);
+vertex_array_t *make_equilateral_triangle(double side_length) {
   vector_t points[3] = {
     {.x = 0, .y = 0},
     {.x = side_length, .y = 0},
     {.x = side_length / 2, .y = sqrt(3) * side_length / 2}
   };
+  return vertex_array_from(points, 3);
+}
 
-  for (size_t i = 0; i < 3; i++)
-  {
-    vector_t *v = malloc(sizeof(*v));
-    *v = points[i];
-    list_add(triangle, v);
-  }
-  return triangle;
+// Adapters from the helpers above to shape_maker_t
+vertex_array_t *circle_maker(real_t radius, real_t unused) {
+  return make_circle(radius);
+}
+
+vertex_array_t *equilateral_triangle_maker(real_t side_length, real_t unused) {
+  return make_equilateral_triangle(side_length);
+}
+
+vertex_array_t *rectangle_maker(real_t length, real_t height) {
+  return make_rectangle(length, height);
+}
+
+shape_t *circle_shape(double radius) {
+  // The number of points is a game constant, so the radius is the only key
+  return shape_intern("circle", radius, 0, circle_maker);
+}
+
+shape_t *equilateral_triangle_shape(double side_length) {
+  return shape_intern("equilateral_triangle", side_length, 0,
+                      equilateral_triangle_maker);
+}
+
+shape_t *rectangle_shape(int32_t length, int32_t height) {
+  return shape_intern("rectangle", length, height, rectangle_maker);
 }
 
 // makes the sprite path
@@ -85,127 +75,39 @@ char* make_path(char* name) {
 }
 
 
-list_t *make_slingshot() {
-  list_t *slingshot_list = list_init(13, free);
-  
-  vector_t *v = malloc(sizeof(*v));
-  *v = (vector_t){143, 0};
-  list_add(slingshot_list, v);
-  
-  v = malloc(sizeof(*v));
-  *v = (vector_t){157, 0};
-  list_add(slingshot_list, v);
-
-  v = malloc(sizeof(*v));
-  *v = (vector_t){157, 50};
-  list_add(slingshot_list, v);
-
-  v = malloc(sizeof(*v));
-  *v = (vector_t){182, 100};
-  list_add(slingshot_list, v);
-
-  v = malloc(sizeof(*v));
-  *v = (vector_t){182, 150};
-  list_add(slingshot_list, v);
-
-  v = malloc(sizeof(*v));
-  *v = (vector_t){173, 150};
-  list_add(slingshot_list, v);
-
-  v = malloc(sizeof(*v));
-  *v = (vector_t){173, 100};
-  list_add(slingshot_list, v);
-
-  v = malloc(sizeof(*v));
-  *v = (vector_t){146, 52};
-  list_add(slingshot_list, v);
-
-  v = malloc(sizeof(*v));
-  *v = (vector_t){127, 93};
-  list_add(slingshot_list, v);
-
-  v = malloc(sizeof(*v));
-  *v = (vector_t){127, 138};
-  list_add(slingshot_list, v);
-
-  v = malloc(sizeof(*v));
-  *v = (vector_t){120, 138};
-  list_add(slingshot_list, v);
-
-  v = malloc(sizeof(*v));
-  *v = (vector_t){120, 93};
-  list_add(slingshot_list, v);
-
-  v = malloc(sizeof(*v));
-  *v = (vector_t){143, 47};
-  list_add(slingshot_list, v);
-
-  return slingshot_list;
+vertex_array_t *make_slingshot() {
+  vector_t points[13] = {
+    {143, 0}, {157, 0}, {157, 50}, {182, 100}, {182, 150}, {173, 150},
+    {173, 100}, {146, 52}, {127, 93}, {127, 138}, {120, 138}, {120, 93},
+    {143, 47}
+  };
+  return vertex_array_from(points, 13);
 }
 
-list_t *make_rubberband(scene_t *scene, vector_t *center){
-  list_t *rubber_list = list_init(6, free);
-  
-  vector_t *v = malloc(sizeof(*v));
-  *v = (vector_t){127, 117};
-  list_add(rubber_list, v);
-  
-  v = malloc(sizeof(*v));
-  *v = (vector_t){127, 130};
-  list_add(rubber_list, v);
-
-  v = malloc(sizeof(*v));
-  *v = (vector_t){center->x, center->y};
-  list_add(rubber_list, v);
-
-  v = malloc(sizeof(*v));
-  *v = (vector_t){173, 125};
-  list_add(rubber_list, v);
-
-  v = malloc(sizeof(*v));
-  *v = (vector_t){173, 140};
-  list_add(rubber_list, v);
-
-  v = malloc(sizeof(*v));
-  *v = (vector_t){center->x, center->y};
-  list_add(rubber_list, v);
-
-  return rubber_list;
+vertex_array_t *make_rubberband(scene_t *scene, vector_t *center){
+  vector_t points[6] = {
+    {127, 117}, {127, 130}, {center->x, center->y},
+    {173, 125}, {173, 140}, {center->x, center->y}
+  };
+  return vertex_array_from(points, 6);
 }
 
-list_t *make_rectangle(int32_t length, int32_t height) {
-  list_t *rectangle = list_init(4, free);
-  vector_t *v = malloc(sizeof(*v));
-  *v = (vector_t){-length, -height};
-  list_add(rectangle, v);
-  v = malloc(sizeof(*v));
-  *v = (vector_t){+length, -height};
-  list_add(rectangle, v);
-  v = malloc(sizeof(*v));
-  *v = (vector_t){+length, +height};
-  list_add(rectangle, v);
-  v = malloc(sizeof(*v));
-  *v = (vector_t){-length, +height};
-  list_add(rectangle, v);
-  return rectangle;
+vertex_array_t *make_rectangle(int32_t length, int32_t height) {
+  vector_t points[4] = {
+    {-length, -height}, {+length, -height}, {+length, +height}, {-length, +height}
+  };
+  return vertex_array_from(points, 4);
 }
 
-// Helper function to set physics and destructive collision simultaneously
+// Helper function to set physics and destructive collision simultaneously.
+// The handlers apply to every collidable body with the tags, so calling this
+// again for the same id changes nothing.
 void make_collisions(scene_t *scene, size_t id) {
-    for (size_t i = 0; i < scene_bodies(scene); i++) {
-        body_t *main_obj = scene_get_body(scene, i);
-        size_t* info = body_get_info(main_obj);
-        if (*info == id || *info == WALL_ID) {
-            for (size_t j = 0; j < scene_bodies(scene); j++) {
-                body_t *obj = scene_get_body(scene, j);
-                size_t* info_obj = body_get_info(scene_get_body(scene, j));
-                if (*info_obj==PLAT_ID || *info_obj==WALL_ID) {
-                    create_physics_collision(scene, 1, obj, main_obj);
-                } else if (*info_obj == PIG_ID) {
-                    create_destructive_collision2(scene, obj, main_obj);
-                } 
-            }
-        }
+    size_t hitters[] = {id, WALL_ID};
+    for (size_t i = 0; i < 2; i++) {
+        create_tagged_physics_collision(scene, 1, PLAT_ID, hitters[i]);
+        create_tagged_physics_collision(scene, 1, WALL_ID, hitters[i]);
+        create_tagged_destructive_collision2(scene, PIG_ID, hitters[i]);
     }
 }
 
@@ -215,7 +117,9 @@ void make_pigs(scene_t *scene, list_t *plat_centers) {
         size_t* id = malloc(sizeof(size_t));
         *id = PIG_ID;
 
-        body_t *pig = body_init_with_info(make_circle(PIG_RADIUS), PIG_MASS, PIG_COLOR, id, free);
+        body_t *pig = body_init_with_shape(circle_shape(PIG_RADIUS), PIG_MASS, PIG_COLOR, id, free);
+        body_set_tag(pig, *id);
+        body_set_collidable(pig, true);
 
         vector_t *plat_center = (vector_t*) list_get(plat_centers, i);
         center = malloc(sizeof(vector_t));
@@ -236,7 +140,9 @@ void make_bird(scene_t *scene, rgb_color_t color, vector_t center, size_t studen
   size_t* id = malloc(sizeof(size_t));
   *id = BIRD_ID;
 
-  body_t *bird = body_init_with_info(make_circle(BIRD_RADIUS), BIRD_MASS, color, id, free);
+  body_t *bird = body_init_with_shape(circle_shape(BIRD_RADIUS), BIRD_MASS, color, id, free);
+  body_set_tag(bird, *id);
+  body_set_collidable(bird, true);
   body_set_centroid(bird, center);
   body_add_image(bird, make_path((char*) STUDENT_NAMES[student_idx]));
   scene_add_body(scene, bird);
@@ -246,7 +152,9 @@ void make_speedy(scene_t *scene, rgb_color_t color, vector_t center, size_t stud
   size_t* id = malloc(sizeof(size_t));
   *id = BIRD_ID;
 
-  body_t *bird = body_init_with_info(make_equilateral_triangle(BIRD_SPEEDY_SIDE), BIRD_MASS, color, id, free);
+  body_t *bird = body_init_with_shape(equilateral_triangle_shape(BIRD_SPEEDY_SIDE), BIRD_MASS, color, id, free);
+  body_set_tag(bird, *id);
+  body_set_collidable(bird, true);
   body_set_centroid(bird, center);
   body_add_image(bird, make_path((char*) STUDENT_NAMES[student_idx]));
   scene_add_body(scene, bird);
@@ -270,8 +178,9 @@ void make_platforms(scene_t *scene, list_t *centers, size_t obj_id, rgb_color_t
       mass=100;
     }
     
-    list_t *shape = make_rectangle(length, height);
-    body_t *platform = body_init_with_info(shape, mass, color, id, free);
+    body_t *platform = body_init_with_shape(rectangle_shape(length, height), mass, color, id, free);
+    body_set_tag(platform, *id);
+    body_set_collidable(platform, true);
 
     vector_t *center = (vector_t*) list_get(centers, i);
     body_set_centroid(platform, *center);
@@ -0,0 +1,588 @@
+#include "vec_batch.h"
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+// The SIMD kernels are written for double precision
+#if (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))) &&       \
+    !PHYSICS_FLOAT
+#define VEC_BATCH_X86
+#include <immintrin.h>
+#define AVX2 __attribute__((target("avx2")))
+#endif
+
+// Whether the components are those of an array of vector_t
+#define INTERLEAVED(xs, ys, stride) ((stride) == 2 && (ys) == (xs) + 1)
+
+typedef struct kernels {
+  void (*translate)(real_t *xs, real_t *ys, size_t stride, size_t n,
+                    vector_t translation);
+  void (*rotate)(real_t *xs, real_t *ys, size_t stride, size_t n, real_t cos,
+                 real_t sin, vector_t point);
+  void (*dot)(const real_t *xs, const real_t *ys, size_t stride, size_t n,
+              vector_t v, real_t *out);
+  void (*minmax)(const real_t *xs, const real_t *ys, size_t stride, size_t n,
+                 vector_t axis, real_t *min, real_t *max);
+  void (*to_pixels)(const real_t *xs, const real_t *ys, size_t stride,
+                    size_t n, vector_t center, real_t scale,
+                    vector_t window_center, int16_t *px, int16_t *py);
+  // Integrates bodies start to n - 1
+  void (*integrate)(const particle_arrays_t *p, size_t start, size_t n,
+                    real_t dt);
+} kernels_t;
+
+/*
+ * Scalar reference implementation.
+ * The SIMD kernels below process as many vectors as they can and finish the
+ * remainder with these, so the arithmetic is written in the same order.
+ */
+
+static void scalar_translate(real_t *xs, real_t *ys, size_t stride, size_t n,
+                             vector_t translation) {
+  for (size_t i = 0; i < n; i++) {
+    xs[i * stride] += translation.x;
+    ys[i * stride] += translation.y;
+  }
+}
+
+static void scalar_rotate(real_t *xs, real_t *ys, size_t stride, size_t n,
+                          real_t c, real_t s, vector_t point) {
+  for (size_t i = 0; i < n; i++) {
+    real_t x = xs[i * stride] - point.x;
+    real_t y = ys[i * stride] - point.y;
+    xs[i * stride] = (x * c - y * s) + point.x;
+    ys[i * stride] = (x * s + y * c) + point.y;
+  }
+}
+
+static void scalar_dot(const real_t *xs, const real_t *ys, size_t stride,
+                       size_t n, vector_t v, real_t *out) {
+  for (size_t i = 0; i < n; i++) {
+    out[i] = xs[i * stride] * v.x + ys[i * stride] * v.y;
+  }
+}
+
+// Folds n more projections into *min and *max
+static void scalar_minmax(const real_t *xs, const real_t *ys, size_t stride,
+                          size_t n, vector_t axis, real_t *min, real_t *max) {
+  for (size_t i = 0; i < n; i++) {
+    real_t d = xs[i * stride] * axis.x + ys[i * stride] * axis.y;
+    *min = d < *min ? d : *min;
+    *max = d > *max ? d : *max;
+  }
+}
+
+static void scalar_to_pixels(const real_t *xs, const real_t *ys, size_t stride,
+                             size_t n, vector_t center, real_t scale,
+                             vector_t window_center, int16_t *px,
+                             int16_t *py) {
+  for (size_t i = 0; i < n; i++) {
+    px[i] = round(window_center.x + scale * (xs[i * stride] - center.x));
+    py[i] = round(window_center.y - scale * (ys[i * stride] - center.y));
+  }
+}
+
+// Follows body_tick(): the body moves at the average of its velocities
+// before and after the forces and impulses are applied
+static void scalar_integrate(const particle_arrays_t *p, size_t start,
+                             size_t n, real_t dt) {
+  real_t half_dt = 0.5 * dt;
+  for (size_t i = start; i < n; i++) {
+    real_t inv_mass = p->inv_mass[i];
+    real_t added_x = dt * (inv_mass * p->force_x[i]) +
+                     inv_mass * p->impulse_x[i];
+    real_t added_y = dt * (inv_mass * p->force_y[i]) +
+                     inv_mass * p->impulse_y[i];
+    real_t vx = p->vel_x[i], vy = p->vel_y[i];
+    real_t new_vx = vx + added_x, new_vy = vy + added_y;
+    p->pos_x[i] += half_dt * (vx + new_vx);
+    p->pos_y[i] += half_dt * (vy + new_vy);
+    p->vel_x[i] = new_vx;
+    p->vel_y[i] = new_vy;
+    p->force_x[i] = 0;
+    p->force_y[i] = 0;
+    p->impulse_x[i] = 0;
+    p->impulse_y[i] = 0;
+  }
+}
+
+static const kernels_t SCALAR_KERNELS = {scalar_translate, scalar_rotate,
+                                         scalar_dot, scalar_minmax,
+                                         scalar_to_pixels, scalar_integrate};
+
+#ifdef VEC_BATCH_X86
+
+/*
+ * SSE2 kernels, 2 doubles per register.
+ * SSE2 is part of x86-64, so these need no runtime check.
+ */
+
+// Rounds half away from zero like round(), for values that fit in an int32
+static inline __m128d sse2_round(__m128d t) {
+  __m128d r = _mm_cvtepi32_pd(_mm_cvttpd_epi32(t));
+  __m128d f = _mm_sub_pd(t, r);
+  __m128d one = _mm_set1_pd(1.0);
+  __m128d up = _mm_and_pd(_mm_cmpge_pd(f, _mm_set1_pd(0.5)), one);
+  __m128d down = _mm_and_pd(_mm_cmple_pd(f, _mm_set1_pd(-0.5)), one);
+  return _mm_sub_pd(_mm_add_pd(r, up), down);
+}
+
+static inline double sse2_hmin(__m128d v) {
+  return _mm_cvtsd_f64(_mm_min_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+static inline double sse2_hmax(__m128d v) {
+  return _mm_cvtsd_f64(_mm_max_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+static void sse2_translate(double *xs, double *ys, size_t stride, size_t n,
+                           vector_t translation) {
+  size_t i = 0;
+  if (stride == 1) {
+    __m128d tx = _mm_set1_pd(translation.x), ty = _mm_set1_pd(translation.y);
+    for (; i + 2 <= n; i += 2) {
+      _mm_storeu_pd(xs + i, _mm_add_pd(_mm_loadu_pd(xs + i), tx));
+      _mm_storeu_pd(ys + i, _mm_add_pd(_mm_loadu_pd(ys + i), ty));
+    }
+  } else if (INTERLEAVED(xs, ys, stride)) {
+    __m128d t = _mm_setr_pd(translation.x, translation.y);
+    for (; i < n; i++) {
+      _mm_storeu_pd(xs + 2 * i, _mm_add_pd(_mm_loadu_pd(xs + 2 * i), t));
+    }
+  }
+  scalar_translate(xs + i * stride, ys + i * stride, stride, n - i,
+                   translation);
+}
+
+static void sse2_rotate(double *xs, double *ys, size_t stride, size_t n,
+                        double c, double s, vector_t point) {
+  size_t i = 0;
+  if (stride == 1) {
+    __m128d vc = _mm_set1_pd(c), vs = _mm_set1_pd(s);
+    __m128d px = _mm_set1_pd(point.x), py = _mm_set1_pd(point.y);
+    for (; i + 2 <= n; i += 2) {
+      __m128d x = _mm_sub_pd(_mm_loadu_pd(xs + i), px);
+      __m128d y = _mm_sub_pd(_mm_loadu_pd(ys + i), py);
+      __m128d nx = _mm_sub_pd(_mm_mul_pd(x, vc), _mm_mul_pd(y, vs));
+      __m128d ny = _mm_add_pd(_mm_mul_pd(x, vs), _mm_mul_pd(y, vc));
+      _mm_storeu_pd(xs + i, _mm_add_pd(nx, px));
+      _mm_storeu_pd(ys + i, _mm_add_pd(ny, py));
+    }
+  } else if (INTERLEAVED(xs, ys, stride)) {
+    // [x, y] -> [x c + y (-s), y c + x s]
+    __m128d p = _mm_setr_pd(point.x, point.y);
+    __m128d vc = _mm_set1_pd(c), vs = _mm_setr_pd(-s, s);
+    for (; i < n; i++) {
+      __m128d d = _mm_sub_pd(_mm_loadu_pd(xs + 2 * i), p);
+      __m128d swapped = _mm_shuffle_pd(d, d, 1);
+      __m128d r = _mm_add_pd(_mm_mul_pd(d, vc), _mm_mul_pd(swapped, vs));
+      _mm_storeu_pd(xs + 2 * i, _mm_add_pd(r, p));
+    }
+  }
+  scalar_rotate(xs + i * stride, ys + i * stride, stride, n - i, c, s, point);
+}
+
+static void sse2_dot(const double *xs, const double *ys, size_t stride,
+                     size_t n, vector_t v, double *out) {
+  size_t i = 0;
+  __m128d vx = _mm_set1_pd(v.x), vy = _mm_set1_pd(v.y);
+  if (stride == 1) {
+    for (; i + 2 <= n; i += 2) {
+      __m128d d = _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(xs + i), vx),
+                             _mm_mul_pd(_mm_loadu_pd(ys + i), vy));
+      _mm_storeu_pd(out + i, d);
+    }
+  } else if (INTERLEAVED(xs, ys, stride)) {
+    for (; i + 2 <= n; i += 2) {
+      __m128d a = _mm_loadu_pd(xs + 2 * i), b = _mm_loadu_pd(xs + 2 * i + 2);
+      __m128d d = _mm_add_pd(_mm_mul_pd(_mm_unpacklo_pd(a, b), vx),
+                             _mm_mul_pd(_mm_unpackhi_pd(a, b), vy));
+      _mm_storeu_pd(out + i, d);
+    }
+  }
+  scalar_dot(xs + i * stride, ys + i * stride, stride, n - i, v, out + i);
+}
+
+static void sse2_minmax(const double *xs, const double *ys, size_t stride,
+                        size_t n, vector_t axis, double *min, double *max) {
+  size_t i = 0;
+  __m128d vx = _mm_set1_pd(axis.x), vy = _mm_set1_pd(axis.y);
+  __m128d lo = _mm_set1_pd(*min), hi = _mm_set1_pd(*max);
+  if (stride == 1) {
+    for (; i + 2 <= n; i += 2) {
+      __m128d d = _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(xs + i), vx),
+                             _mm_mul_pd(_mm_loadu_pd(ys + i), vy));
+      lo = _mm_min_pd(lo, d);
+      hi = _mm_max_pd(hi, d);
+    }
+  } else if (INTERLEAVED(xs, ys, stride)) {
+    for (; i + 2 <= n; i += 2) {
+      __m128d a = _mm_loadu_pd(xs + 2 * i), b = _mm_loadu_pd(xs + 2 * i + 2);
+      __m128d d = _mm_add_pd(_mm_mul_pd(_mm_unpacklo_pd(a, b), vx),
+                             _mm_mul_pd(_mm_unpackhi_pd(a, b), vy));
+      lo = _mm_min_pd(lo, d);
+      hi = _mm_max_pd(hi, d);
+    }
+  }
+  *min = sse2_hmin(lo);
+  *max = sse2_hmax(hi);
+  scalar_minmax(xs + i * stride, ys + i * stride, stride, n - i, axis, min,
+                max);
+}
+
+static void sse2_to_pixels(const double *xs, const double *ys, size_t stride,
+                           size_t n, vector_t center, double scale,
+                           vector_t window_center, int16_t *px, int16_t *py) {
+  size_t i = 0;
+  double pixels[2];
+  if (stride == 1) {
+    __m128d vscale = _mm_set1_pd(scale);
+    __m128d cx = _mm_set1_pd(center.x), cy = _mm_set1_pd(center.y);
+    __m128d wx = _mm_set1_pd(window_center.x);
+    __m128d wy = _mm_set1_pd(window_center.y);
+    for (; i + 2 <= n; i += 2) {
+      __m128d x = _mm_sub_pd(_mm_loadu_pd(xs + i), cx);
+      __m128d y = _mm_sub_pd(_mm_loadu_pd(ys + i), cy);
+      _mm_storeu_pd(pixels, sse2_round(_mm_add_pd(wx, _mm_mul_pd(vscale, x))));
+      px[i] = pixels[0];
+      px[i + 1] = pixels[1];
+      _mm_storeu_pd(pixels, sse2_round(_mm_sub_pd(wy, _mm_mul_pd(vscale, y))));
+      py[i] = pixels[0];
+      py[i + 1] = pixels[1];
+    }
+  } else if (INTERLEAVED(xs, ys, stride)) {
+    // Negating the y scale flips the y axis
+    __m128d vscale = _mm_setr_pd(scale, -scale);
+    __m128d c = _mm_setr_pd(center.x, center.y);
+    __m128d w = _mm_setr_pd(window_center.x, window_center.y);
+    for (; i < n; i++) {
+      __m128d d = _mm_sub_pd(_mm_loadu_pd(xs + 2 * i), c);
+      _mm_storeu_pd(pixels, sse2_round(_mm_add_pd(w, _mm_mul_pd(vscale, d))));
+      px[i] = pixels[0];
+      py[i] = pixels[1];
+    }
+  }
+  scalar_to_pixels(xs + i * stride, ys + i * stride, stride, n - i, center,
+                   scale, window_center, px + i, py + i);
+}
+
+// Integrates one axis of 2 bodies; the same code handles x and y
+static inline void sse2_integrate_axis(double *pos, double *vel, double *force,
+                                       double *impulse, __m128d inv_mass,
+                                       __m128d dt, __m128d half_dt) {
+  __m128d added = _mm_add_pd(
+      _mm_mul_pd(dt, _mm_mul_pd(inv_mass, _mm_loadu_pd(force))),
+      _mm_mul_pd(inv_mass, _mm_loadu_pd(impulse)));
+  __m128d v = _mm_loadu_pd(vel);
+  __m128d new_v = _mm_add_pd(v, added);
+  __m128d moved = _mm_mul_pd(half_dt, _mm_add_pd(v, new_v));
+  _mm_storeu_pd(pos, _mm_add_pd(_mm_loadu_pd(pos), moved));
+  _mm_storeu_pd(vel, new_v);
+  _mm_storeu_pd(force, _mm_setzero_pd());
+  _mm_storeu_pd(impulse, _mm_setzero_pd());
+}
+
+static void sse2_integrate(const particle_arrays_t *p, size_t start, size_t n,
+                           double dt) {
+  size_t i = start;
+  __m128d vdt = _mm_set1_pd(dt), half_dt = _mm_set1_pd(0.5 * dt);
+  for (; i + 2 <= n; i += 2) {
+    __m128d inv_mass = _mm_loadu_pd(p->inv_mass + i);
+    sse2_integrate_axis(p->pos_x + i, p->vel_x + i, p->force_x + i,
+                        p->impulse_x + i, inv_mass, vdt, half_dt);
+    sse2_integrate_axis(p->pos_y + i, p->vel_y + i, p->force_y + i,
+                        p->impulse_y + i, inv_mass, vdt, half_dt);
+  }
+  scalar_integrate(p, i, n, dt);
+}
+
+static const kernels_t SSE2_KERNELS = {sse2_translate, sse2_rotate, sse2_dot,
+                                       sse2_minmax,    sse2_to_pixels,
+                                       sse2_integrate};
+
+/*
+ * AVX2 kernels, 4 doubles per register.
+ * Only used if the CPU reports AVX2 support.
+ */
+
+AVX2 static inline __m256d avx2_round(__m256d t) {
+  __m256d r = _mm256_cvtepi32_pd(_mm256_cvttpd_epi32(t));
+  __m256d f = _mm256_sub_pd(t, r);
+  __m256d one = _mm256_set1_pd(1.0);
+  __m256d up =
+      _mm256_and_pd(_mm256_cmp_pd(f, _mm256_set1_pd(0.5), _CMP_GE_OQ), one);
+  __m256d down =
+      _mm256_and_pd(_mm256_cmp_pd(f, _mm256_set1_pd(-0.5), _CMP_LE_OQ), one);
+  return _mm256_sub_pd(_mm256_add_pd(r, up), down);
+}
+
+// Loads 4 interleaved vectors as [x0 x2 x1 x3] and [y0 y2 y1 y3]
+AVX2 static inline void avx2_deinterleave(const double *v, __m256d *x,
+                                          __m256d *y) {
+  __m256d a = _mm256_loadu_pd(v), b = _mm256_loadu_pd(v + 4);
+  *x = _mm256_unpacklo_pd(a, b);
+  *y = _mm256_unpackhi_pd(a, b);
+}
+
+AVX2 static void avx2_translate(double *xs, double *ys, size_t stride,
+                                size_t n, vector_t translation) {
+  size_t i = 0;
+  if (stride == 1) {
+    __m256d tx = _mm256_set1_pd(translation.x);
+    __m256d ty = _mm256_set1_pd(translation.y);
+    for (; i + 4 <= n; i += 4) {
+      _mm256_storeu_pd(xs + i, _mm256_add_pd(_mm256_loadu_pd(xs + i), tx));
+      _mm256_storeu_pd(ys + i, _mm256_add_pd(_mm256_loadu_pd(ys + i), ty));
+    }
+  } else if (INTERLEAVED(xs, ys, stride)) {
+    __m256d t = _mm256_setr_pd(translation.x, translation.y, translation.x,
+                               translation.y);
+    for (; i + 2 <= n; i += 2) {
+      double *v = xs + 2 * i;
+      _mm256_storeu_pd(v, _mm256_add_pd(_mm256_loadu_pd(v), t));
+    }
+  }
+  scalar_translate(xs + i * stride, ys + i * stride, stride, n - i,
+                   translation);
+}
+
+AVX2 static void avx2_rotate(double *xs, double *ys, size_t stride, size_t n,
+                             double c, double s, vector_t point) {
+  size_t i = 0;
+  if (stride == 1) {
+    __m256d vc = _mm256_set1_pd(c), vs = _mm256_set1_pd(s);
+    __m256d px = _mm256_set1_pd(point.x), py = _mm256_set1_pd(point.y);
+    for (; i + 4 <= n; i += 4) {
+      __m256d x = _mm256_sub_pd(_mm256_loadu_pd(xs + i), px);
+      __m256d y = _mm256_sub_pd(_mm256_loadu_pd(ys + i), py);
+      __m256d nx = _mm256_sub_pd(_mm256_mul_pd(x, vc), _mm256_mul_pd(y, vs));
+      __m256d ny = _mm256_add_pd(_mm256_mul_pd(x, vs), _mm256_mul_pd(y, vc));
+      _mm256_storeu_pd(xs + i, _mm256_add_pd(nx, px));
+      _mm256_storeu_pd(ys + i, _mm256_add_pd(ny, py));
+    }
+  } else if (INTERLEAVED(xs, ys, stride)) {
+    __m256d p = _mm256_setr_pd(point.x, point.y, point.x, point.y);
+    __m256d vc = _mm256_set1_pd(c), vs = _mm256_setr_pd(-s, s, -s, s);
+    for (; i + 2 <= n; i += 2) {
+      double *v = xs + 2 * i;
+      __m256d d = _mm256_sub_pd(_mm256_loadu_pd(v), p);
+      __m256d swapped = _mm256_permute_pd(d, 0x5);
+      __m256d r =
+          _mm256_add_pd(_mm256_mul_pd(d, vc), _mm256_mul_pd(swapped, vs));
+      _mm256_storeu_pd(v, _mm256_add_pd(r, p));
+    }
+  }
+  scalar_rotate(xs + i * stride, ys + i * stride, stride, n - i, c, s, point);
+}
+
+AVX2 static void avx2_dot(const double *xs, const double *ys, size_t stride,
+                          size_t n, vector_t v, double *out) {
+  size_t i = 0;
+  __m256d vx = _mm256_set1_pd(v.x), vy = _mm256_set1_pd(v.y);
+  if (stride == 1) {
+    for (; i + 4 <= n; i += 4) {
+      __m256d d = _mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(xs + i), vx),
+                                _mm256_mul_pd(_mm256_loadu_pd(ys + i), vy));
+      _mm256_storeu_pd(out + i, d);
+    }
+  } else if (INTERLEAVED(xs, ys, stride)) {
+    for (; i + 4 <= n; i += 4) {
+      __m256d x, y;
+      avx2_deinterleave(xs + 2 * i, &x, &y);
+      __m256d d = _mm256_add_pd(_mm256_mul_pd(x, vx), _mm256_mul_pd(y, vy));
+      // Undo the lane order of the deinterleave
+      _mm256_storeu_pd(out + i, _mm256_permute4x64_pd(d, 0xD8));
+    }
+  }
+  scalar_dot(xs + i * stride, ys + i * stride, stride, n - i, v, out + i);
+}
+
+AVX2 static void avx2_minmax(const double *xs, const double *ys,
+                             size_t stride, size_t n, vector_t axis,
+                             double *min, double *max) {
+  size_t i = 0;
+  __m256d vx = _mm256_set1_pd(axis.x), vy = _mm256_set1_pd(axis.y);
+  __m256d lo = _mm256_set1_pd(*min), hi = _mm256_set1_pd(*max);
+  if (stride == 1) {
+    for (; i + 4 <= n; i += 4) {
+      __m256d d = _mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(xs + i), vx),
+                                _mm256_mul_pd(_mm256_loadu_pd(ys + i), vy));
+      lo = _mm256_min_pd(lo, d);
+      hi = _mm256_max_pd(hi, d);
+    }
+  } else if (INTERLEAVED(xs, ys, stride)) {
+    for (; i + 4 <= n; i += 4) {
+      __m256d x, y;
+      avx2_deinterleave(xs + 2 * i, &x, &y);
+      __m256d d = _mm256_add_pd(_mm256_mul_pd(x, vx), _mm256_mul_pd(y, vy));
+      lo = _mm256_min_pd(lo, d);
+      hi = _mm256_max_pd(hi, d);
+    }
+  }
+  __m128d lo2 = _mm_min_pd(_mm256_castpd256_pd128(lo),
+                           _mm256_extractf128_pd(lo, 1));
+  __m128d hi2 = _mm_max_pd(_mm256_castpd256_pd128(hi),
+                           _mm256_extractf128_pd(hi, 1));
+  *min = sse2_hmin(lo2);
+  *max = sse2_hmax(hi2);
+  scalar_minmax(xs + i * stride, ys + i * stride, stride, n - i, axis, min,
+                max);
+}
+
+AVX2 static void avx2_to_pixels(const double *xs, const double *ys,
+                                size_t stride, size_t n, vector_t center,
+                                double scale, vector_t window_center,
+                                int16_t *px, int16_t *py) {
+  size_t i = 0;
+  double pixels[4];
+  if (stride == 1) {
+    __m256d vscale = _mm256_set1_pd(scale);
+    __m256d cx = _mm256_set1_pd(center.x), cy = _mm256_set1_pd(center.y);
+    __m256d wx = _mm256_set1_pd(window_center.x);
+    __m256d wy = _mm256_set1_pd(window_center.y);
+    for (; i + 4 <= n; i += 4) {
+      __m256d x = _mm256_sub_pd(_mm256_loadu_pd(xs + i), cx);
+      __m256d y = _mm256_sub_pd(_mm256_loadu_pd(ys + i), cy);
+      _mm256_storeu_pd(pixels,
+                       avx2_round(_mm256_add_pd(wx, _mm256_mul_pd(vscale, x))));
+      for (size_t k = 0; k < 4; k++) {
+        px[i + k] = pixels[k];
+      }
+      _mm256_storeu_pd(pixels,
+                       avx2_round(_mm256_sub_pd(wy, _mm256_mul_pd(vscale, y))));
+      for (size_t k = 0; k < 4; k++) {
+        py[i + k] = pixels[k];
+      }
+    }
+  } else if (INTERLEAVED(xs, ys, stride)) {
+    __m256d vscale = _mm256_setr_pd(scale, -scale, scale, -scale);
+    __m256d c = _mm256_setr_pd(center.x, center.y, center.x, center.y);
+    __m256d w = _mm256_setr_pd(window_center.x, window_center.y,
+                               window_center.x, window_center.y);
+    for (; i + 2 <= n; i += 2) {
+      __m256d d = _mm256_sub_pd(_mm256_loadu_pd(xs + 2 * i), c);
+      _mm256_storeu_pd(pixels,
+                       avx2_round(_mm256_add_pd(w, _mm256_mul_pd(vscale, d))));
+      px[i] = pixels[0];
+      py[i] = pixels[1];
+      px[i + 1] = pixels[2];
+      py[i + 1] = pixels[3];
+    }
+  }
+  scalar_to_pixels(xs + i * stride, ys + i * stride, stride, n - i, center,
+                   scale, window_center, px + i, py + i);
+}
+
+AVX2 static inline void avx2_integrate_axis(double *pos, double *vel,
+                                            double *force, double *impulse,
+                                            __m256d inv_mass, __m256d dt,
+                                            __m256d half_dt) {
+  __m256d added = _mm256_add_pd(
+      _mm256_mul_pd(dt, _mm256_mul_pd(inv_mass, _mm256_loadu_pd(force))),
+      _mm256_mul_pd(inv_mass, _mm256_loadu_pd(impulse)));
+  __m256d v = _mm256_loadu_pd(vel);
+  __m256d new_v = _mm256_add_pd(v, added);
+  __m256d moved = _mm256_mul_pd(half_dt, _mm256_add_pd(v, new_v));
+  _mm256_storeu_pd(pos, _mm256_add_pd(_mm256_loadu_pd(pos), moved));
+  _mm256_storeu_pd(vel, new_v);
+  _mm256_storeu_pd(force, _mm256_setzero_pd());
+  _mm256_storeu_pd(impulse, _mm256_setzero_pd());
+}
+
+AVX2 static void avx2_integrate(const particle_arrays_t *p, size_t start,
+                                size_t n, double dt) {
+  size_t i = start;
+  __m256d vdt = _mm256_set1_pd(dt), half_dt = _mm256_set1_pd(0.5 * dt);
+  for (; i + 4 <= n; i += 4) {
+    __m256d inv_mass = _mm256_loadu_pd(p->inv_mass + i);
+    avx2_integrate_axis(p->pos_x + i, p->vel_x + i, p->force_x + i,
+                        p->impulse_x + i, inv_mass, vdt, half_dt);
+    avx2_integrate_axis(p->pos_y + i, p->vel_y + i, p->force_y + i,
+                        p->impulse_y + i, inv_mass, vdt, half_dt);
+  }
+  scalar_integrate(p, i, n, dt);
+}
+
+static const kernels_t AVX2_KERNELS = {avx2_translate, avx2_rotate, avx2_dot,
+                                       avx2_minmax,    avx2_to_pixels,
+                                       avx2_integrate};
+
+#endif // #ifdef VEC_BATCH_X86
+
+// The kernels in use, picked on the first call
+static const kernels_t *kernels = NULL;
+static vec_batch_backend_t backend;
+
+bool vec_batch_set_backend(vec_batch_backend_t new_backend) {
+  switch (new_backend) {
+  case VEC_BATCH_SCALAR:
+    kernels = &SCALAR_KERNELS;
+    break;
+#ifdef VEC_BATCH_X86
+  case VEC_BATCH_SSE2:
+    kernels = &SSE2_KERNELS;
+    break;
+  case VEC_BATCH_AVX2:
+    __builtin_cpu_init();
+    if (!__builtin_cpu_supports("avx2")) {
+      return false;
+    }
+    kernels = &AVX2_KERNELS;
+    break;
+#endif
+  default:
+    return false;
+  }
+  backend = new_backend;
+  return true;
+}
+
+vec_batch_backend_t vec_batch_get_backend(void) {
+  if (kernels == NULL) {
+    if (!vec_batch_set_backend(VEC_BATCH_AVX2) &&
+        !vec_batch_set_backend(VEC_BATCH_SSE2)) {
+      vec_batch_set_backend(VEC_BATCH_SCALAR);
+    }
+  }
+  return backend;
+}
+
+void vec_translate_n(real_t *xs, real_t *ys, size_t stride, size_t n,
+                     vector_t translation) {
+  vec_batch_get_backend();
+  kernels->translate(xs, ys, stride, n, translation);
+}
+
+void vec_rotate_n(real_t *xs, real_t *ys, size_t stride, size_t n, rot_t rot,
+                  vector_t point) {
+  vec_batch_get_backend();
+  kernels->rotate(xs, ys, stride, n, rot.cos, rot.sin, point);
+}
+
+void vec_dot_n(const real_t *xs, const real_t *ys, size_t stride, size_t n,
+               vector_t v, real_t *out) {
+  vec_batch_get_backend();
+  kernels->dot(xs, ys, stride, n, v, out);
+}
+
+void vec_minmax_project_n(const real_t *xs, const real_t *ys, size_t stride,
+                          size_t n, vector_t axis, real_t *min, real_t *max) {
+  assert(n > 0);
+  vec_batch_get_backend();
+  *min = INFINITY;
+  *max = -INFINITY;
+  kernels->minmax(xs, ys, stride, n, axis, min, max);
+}
+
+void vec_to_pixels_n(const real_t *xs, const real_t *ys, size_t stride,
+                     size_t n, vector_t center, real_t scale,
+                     vector_t window_center, int16_t *px, int16_t *py) {
+  vec_batch_get_backend();
+  kernels->to_pixels(xs, ys, stride, n, center, scale, window_center, px, py);
+}
+
+void vec_integrate_n(const particle_arrays_t *particles, size_t n, double dt) {
+  vec_batch_get_backend();
+  kernels->integrate(particles, 0, n, dt);
+}
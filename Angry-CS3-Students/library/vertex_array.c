@@ -0,0 +1,62 @@
+#include "vertex_array.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+vertex_array_t *vertex_array_init(size_t size) {
+  vertex_array_t *array = malloc(sizeof(vertex_array_t) + sizeof(vector_t) * size);
+  assert(array != NULL);
+  array->size = size;
+  for (size_t i = 0; i < size; i++) {
+    array->data[i] = VEC_ZERO;
+  }
+  return array;
+}
+
+vertex_array_t *vertex_array_from(const vector_t *points, size_t size) {
+  vertex_array_t *array = malloc(sizeof(vertex_array_t) + sizeof(vector_t) * size);
+  assert(array != NULL);
+  array->size = size;
+  memcpy(array->data, points, sizeof(vector_t) * size);
+  return array;
+}
+
+vertex_array_t *vertex_array_from_list(list_t *list) {
+  size_t size = list_size(list);
+  vertex_array_t *array = malloc(sizeof(vertex_array_t) + sizeof(vector_t) * size);
+  assert(array != NULL);
+  array->size = size;
+  for (size_t i = 0; i < size; i++) {
+    array->data[i] = *(vector_t *)list_get(list, i);
+  }
+  return array;
+}
+
+list_t *vertex_array_to_list(const vertex_array_t *array) {
+  list_t *list = list_init(array->size, free);
+  for (size_t i = 0; i < array->size; i++) {
+    vector_t *v = malloc(sizeof(*v));
+    assert(v != NULL);
+    *v = array->data[i];
+    list_add(list, v);
+  }
+  return list;
+}
+
+vertex_array_t *vertex_array_copy(const vertex_array_t *array) {
+  return vertex_array_from(array->data, array->size);
+}
+
+void vertex_array_free(vertex_array_t *array) { free(array); }
+
+size_t vertex_array_size(const vertex_array_t *array) { return array->size; }
+
+vector_t vertex_array_get(const vertex_array_t *array, size_t index) {
+  assert(index < array->size);
+  return array->data[index];
+}
+
+void vertex_array_set(vertex_array_t *array, size_t index, vector_t vertex) {
+  assert(index < array->size);
+  array->data[index] = vertex;
+}
@@ -446,6 +446,7 @@ int main() {
   }
 
   scene_free(state->scene);
+  body_free_pools();
   free(state->rubber_center);
   free(state);
 
@@ -0,0 +1,158 @@
+// Headless replay of every level, used as the training run for the
+// profile-guided release build ('make release').
+// Each level is built exactly as the game builds it, then every bird is
+// launched along a fixed, scripted trajectory and the scene is stepped at a
+// fixed frame rate until the bird leaves the window, so the profile covers
+// level setup, force creators, collisions and body reaping.
+// Nothing is drawn, and the run is deterministic. Each level prints a hash
+// of the final body positions; in a PHYSICS_FIXED build the hashes match
+// across compilers and targets.
+
+#include "body.h"
+#include "forces.h"
+#include "levels.h"
+#include "scene.h"
+#include "utils.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Game constants required by utils and levels (see demo/angryCS3students.c)
+const size_t WINDOW_W = 1000;
+const size_t WINDOW_H = 500;
+
+const size_t PIG_ID = 0;
+const size_t N_CIRCLE_PTS = 20;
+const size_t PIG_RADIUS = 10;
+const double PIG_MASS = 1;
+const rgb_color_t PIG_COLOR = {0.0, 1.0, 0.0};
+
+const size_t BIRD_ID = 1;
+const size_t BIRD_RADIUS = 15;
+const size_t BIRD_SPEEDY_SIDE = 50;
+const double BIRD_MASS = 10;
+const rgb_color_t BIRD_STANDARD_COLOR = {1.0, 0.0, 0.0};
+const rgb_color_t BIRD_EGG_COLOR = {0.75, 1.0, 0.0};
+const rgb_color_t BIRD_SPLIT_COLOR = {0.0, 1.0, 1.0};
+const rgb_color_t BIRD_BOMB_COLOR = {0.0, 0.0, 0.0};
+const rgb_color_t BIRD_SPEEDY_COLOR = {0.5, 1.0, 0.0};
+
+const size_t PLAT_ID = 2;
+const int32_t PLAT_LENGTH = 40;
+const int32_t PLAT_HEIGHT = 5;
+const int32_t WALL_LENGTH = 5;
+const int32_t WALL_HEIGHT = 25;
+const rgb_color_t PLAT_COLOR = {0.0, 0.0, 1.0};
+const size_t WALL_ID = 8;
+
+const size_t N_OBSTACLES = 2;
+const rgb_color_t SLINGSHOT_COLOR = {0.588, 0.294, 0};
+const vector_t RUBBER_CENTER = {146.0, 127.0};
+
+const size_t GRAVITY_ID = 0;
+const size_t GRAVITY_CONST = 1600;
+
+const char *SPRITE_FOLDER = "assets/";
+const char *SPRITE_TYPE = ".png";
+const char *STUDENT_NAMES[] = {"cloudly", "lea", "saraswati", "asav", "hopper"};
+const char *TA_NAMES[] = {"alice", "sarah", "eshani", "devin", "eli", "enoch",
+                          "jun", "jia", "leoJ", "leoZ", "markus", "maria",
+                          "sahil", "rachael", "winter"};
+const size_t N_STUDENTS = 5;
+const size_t N_TAS = 15;
+
+// Replay constants
+const double REPLAY_DT = 1.0 / 60.0;
+const size_t MAX_FLIGHT_TICKS = 600;
+const size_t N_LEVELS = 6;
+const double LAUNCH_SPEED = 600;
+// Launch angles in radians, cycled through for successive birds
+const double LAUNCH_ANGLES[] = {0.35, 0.6, 0.85, 0.2, 0.5, 0.75, 1.0};
+const size_t N_LAUNCH_ANGLES = 7;
+
+typedef void (*level_builder_t)(scene_t *scene);
+
+const level_builder_t LEVELS[] = {level_one,   level_two, level_three,
+                                  level_four,  level_five, level_six};
+
+bool out_of_window(body_t *body) {
+  vector_t centroid = body_get_centroid(body);
+  return centroid.x < 0 || centroid.x > WINDOW_W || centroid.y < 0 ||
+         centroid.y > WINDOW_H;
+}
+
+// Counts the bodies in the scene with the given id
+size_t count_bodies(scene_t *scene, size_t id) {
+  size_t count = 0;
+  for (size_t i = 0; i < scene_bodies(scene); i++) {
+    size_t *info = body_get_info(scene_get_body(scene, i));
+    if (*info == id) {
+      count++;
+    }
+  }
+  return count;
+}
+
+// Hashes the bits of every body's position and velocity (FNV-1a)
+uint64_t hash_scene(scene_t *scene) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (size_t i = 0; i < scene_bodies(scene); i++) {
+    body_t *body = scene_get_body(scene, i);
+    vector_t state[] = {body_get_centroid(body), body_get_velocity(body)};
+    unsigned char bytes[sizeof(state)];
+    memcpy(bytes, state, sizeof(state));
+    for (size_t j = 0; j < sizeof(bytes); j++) {
+      hash = (hash ^ bytes[j]) * 1099511628211ULL;
+    }
+  }
+  return hash;
+}
+
+// Launches every bird in the level in turn and returns the number of ticks run
+size_t replay_level(scene_t *scene) {
+  size_t ticks = 0;
+  size_t shot = 0;
+  while (count_bodies(scene, BIRD_ID) > 0 && count_bodies(scene, PIG_ID) > 0) {
+    body_t *bird = get_body(scene, BIRD_ID);
+    double angle = LAUNCH_ANGLES[shot % N_LAUNCH_ANGLES];
+    body_set_centroid(bird, RUBBER_CENTER);
+    body_set_velocity(bird, vec_multiply(LAUNCH_SPEED,
+                                         (vector_t){cos(angle), sin(angle)}));
+    create_downward_gravity(scene, GRAVITY_CONST, bird, GRAVITY_ID);
+
+    for (size_t i = 0; i < MAX_FLIGHT_TICKS && !out_of_window(bird); i++) {
+      scene_tick(scene, REPLAY_DT);
+      ticks++;
+      if (body_is_removed(bird)) {
+        break;
+      }
+    }
+    if (!body_is_removed(bird)) {
+      body_remove(bird);
+    }
+    scene_tick(scene, 0);
+    shot++;
+  }
+  return ticks;
+}
+
+int main(int argc, char *argv[]) {
+  size_t rounds = argc > 1 ? strtoul(argv[1], NULL, 10) : 1;
+  for (size_t round = 0; round < rounds; round++) {
+    for (size_t level = 0; level < N_LEVELS; level++) {
+      scene_t *scene = scene_init();
+      scene_set_broadphase(scene, SCENE_BROADPHASE_SWEEP);
+      LEVELS[level](scene);
+      size_t pigs = count_bodies(scene, PIG_ID);
+      size_t ticks = replay_level(scene);
+      printf("level %zu: %zu ticks, %zu/%zu pigs hit, state %016llx\n",
+             level + 1, ticks, pigs - count_bodies(scene, PIG_ID), pigs,
+             (unsigned long long)hash_scene(scene));
+      scene_free(scene);
+    }
+  }
+  body_free_pools();
+  puts("replay PASS");
+}
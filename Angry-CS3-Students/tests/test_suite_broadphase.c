@@ -0,0 +1,403 @@
+#include "broadphase.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdlib.h>
+
+// A random box with its lower corner in [-range, range)
+aabb_t random_box(real_t range, real_t max_size) {
+  real_t x = (rand() / (real_t)RAND_MAX * 2 - 1) * range;
+  real_t y = (rand() / (real_t)RAND_MAX * 2 - 1) * range;
+  real_t width = rand() / (real_t)RAND_MAX * max_size;
+  real_t height = rand() / (real_t)RAND_MAX * max_size;
+  return (aabb_t){{x, y}, {x + width, y + height}};
+}
+
+// Checks that the grid finds exactly the pairs that testing every pair does
+void check_pairs(grid_t *grid, const aabb_t *boxes, size_t n) {
+  box_pair_array_t pairs;
+  box_pair_array_init(&pairs, 0);
+  grid_find_pairs(grid, boxes, n, &pairs);
+  size_t k = 0;
+  for (size_t i = 0; i < n; i++) {
+    for (size_t j = i + 1; j < n; j++) {
+      if (aabb_overlap(boxes[i], boxes[j])) {
+        box_pair_t pair = box_pair_array_get(&pairs, k++);
+        assert(pair.first == i && pair.second == j);
+      }
+    }
+  }
+  assert(box_pair_array_size(&pairs) == k);
+  box_pair_array_free(&pairs);
+}
+
+void test_aabb() {
+  vector_t points[] = {{1, 2}, {4, -1}, {3, 5}, {-2, 0}};
+  vertex_array_t *vertices = vertex_array_from(points, 4);
+  aabb_t box = aabb_of(vertices);
+  assert(vec_equal(box.min, (vector_t){-2, -1}));
+  assert(vec_equal(box.max, (vector_t){4, 5}));
+  vertex_array_free(vertices);
+
+  assert(aabb_overlap(box, (aabb_t){{3, 4}, {10, 10}}));
+  // Touching counts
+  assert(aabb_overlap(box, (aabb_t){{4, 5}, {10, 10}}));
+  assert(!aabb_overlap(box, (aabb_t){{4.5, 0}, {10, 10}}));
+  assert(!aabb_overlap(box, (aabb_t){{0, -3}, {1, -1.5}}));
+}
+
+void test_grid_pairs() {
+  grid_t *grid = grid_init(10);
+  aabb_t boxes[] = {
+      {{0, 0}, {5, 5}},
+      // Shares several cells with box 0 but is only reported once
+      {{4, 4}, {25, 25}},
+      {{30, 30}, {31, 31}},
+      // Exactly on a cell boundary
+      {{-10, -10}, {0, 0}},
+      // Far away
+      {{1e12, 1e12}, {1e12 + 1, 1e12 + 1}},
+      {{1e12, 1e12}, {1e12 + 1, 1e12 + 1}},
+  };
+  box_pair_array_t pairs;
+  box_pair_array_init(&pairs, 0);
+  grid_find_pairs(grid, boxes, 6, &pairs);
+  assert(box_pair_array_size(&pairs) == 3);
+  assert(box_pair_array_get(&pairs, 0).first == 0);
+  assert(box_pair_array_get(&pairs, 0).second == 1);
+  assert(box_pair_array_get(&pairs, 1).first == 0);
+  assert(box_pair_array_get(&pairs, 1).second == 3);
+  assert(box_pair_array_get(&pairs, 2).first == 4);
+  assert(box_pair_array_get(&pairs, 2).second == 5);
+
+  // Nothing is kept between calls
+  grid_find_pairs(grid, boxes, 1, &pairs);
+  assert(box_pair_array_size(&pairs) == 0);
+  box_pair_array_free(&pairs);
+  grid_free(grid);
+}
+
+void test_grid_random() {
+  const size_t N = 300;
+  aabb_t *boxes = malloc(sizeof(aabb_t) * N);
+  grid_t *grid = grid_init(8);
+  for (size_t trial = 0; trial < 5; trial++) {
+    for (size_t i = 0; i < N; i++) {
+      // A few boxes are too big to enter in the grid
+      boxes[i] = random_box(200, i % 50 == 0 ? 400 : 12);
+    }
+    check_pairs(grid, boxes, N);
+  }
+  grid_free(grid);
+  free(boxes);
+}
+
+// Whether a list of pairs has a pair
+bool has_pair(box_pair_array_t *pairs, size_t first, size_t second) {
+  for (size_t i = 0; i < box_pair_array_size(pairs); i++) {
+    box_pair_t pair = box_pair_array_get(pairs, i);
+    if (pair.first == first && pair.second == second) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void test_sweep_deltas() {
+  sweep_t *sweep = sweep_init();
+  box_pair_array_t added, removed;
+  box_pair_array_init(&added, 0);
+  box_pair_array_init(&removed, 0);
+  size_t a = sweep_add(sweep, (aabb_t){{0, 0}, {2, 2}});
+  size_t b = sweep_add(sweep, (aabb_t){{1, 1}, {3, 3}});
+  size_t c = sweep_add(sweep, (aabb_t){{10, 0}, {12, 2}});
+  sweep_update(sweep, &added, &removed);
+  assert(box_pair_array_size(&added) == 1 && has_pair(&added, a, b));
+  assert(box_pair_array_size(&removed) == 0);
+  assert(sweep_pairs(sweep) == 1);
+
+  // Nothing moved, so nothing changed
+  sweep_update(sweep, &added, &removed);
+  assert(box_pair_array_size(&added) == 0);
+  assert(box_pair_array_size(&removed) == 0);
+
+  // Overlapping along x but not y
+  sweep_move(sweep, c, (aabb_t){{1, 5}, {3, 7}});
+  sweep_update(sweep, &added, &removed);
+  assert(box_pair_array_size(&added) == 0);
+  sweep_move(sweep, c, (aabb_t){{1, 3}, {3, 5}});
+  sweep_update(sweep, &added, &removed);
+  // Touching counts
+  assert(box_pair_array_size(&added) == 1 && has_pair(&added, b, c));
+  sweep_move(sweep, b, (aabb_t){{20, 20}, {21, 21}});
+  sweep_update(sweep, &added, &removed);
+  assert(box_pair_array_size(&added) == 0);
+  assert(box_pair_array_size(&removed) == 2);
+  assert(has_pair(&removed, a, b) && has_pair(&removed, b, c));
+  assert(sweep_pairs(sweep) == 0);
+
+  // Moving away and back between updates reports nothing
+  sweep_move(sweep, b, (aabb_t){{0, 0}, {1, 1}});
+  sweep_update(sweep, &added, &removed);
+  assert(box_pair_array_size(&added) == 1 && has_pair(&added, a, b));
+  sweep_move(sweep, b, (aabb_t){{20, 20}, {21, 21}});
+  sweep_move(sweep, b, (aabb_t){{0, 0}, {1, 1}});
+  sweep_update(sweep, &added, &removed);
+  assert(box_pair_array_size(&added) == 0);
+  assert(box_pair_array_size(&removed) == 0);
+
+  // A removed box's pairs are reported before its proxy is reused
+  sweep_remove(sweep, a);
+  assert(sweep_pairs(sweep) == 0);
+  size_t d = sweep_add(sweep, (aabb_t){{0, 0}, {1, 1}});
+  assert(d != a);
+  sweep_update(sweep, &added, &removed);
+  assert(box_pair_array_size(&removed) == 1 && has_pair(&removed, a, b));
+  assert(box_pair_array_size(&added) == 1 && has_pair(&added, b, d));
+  sweep_remove(sweep, d);
+  sweep_update(sweep, &added, &removed);
+  assert(sweep_add(sweep, (aabb_t){{0, 0}, {1, 1}}) == d);
+
+  box_pair_array_free(&added);
+  box_pair_array_free(&removed);
+  sweep_free(sweep);
+}
+
+void test_sweep_random() {
+  const size_t N = 200;
+  aabb_t *boxes = malloc(sizeof(aabb_t) * N);
+  size_t *proxies = malloc(sizeof(size_t) * N);
+  // Proxies of removed boxes are not reused straight away,
+  // so there can be more proxies than boxes
+  const size_t M = 2 * N;
+  // Which pairs of proxies overlap, according to the deltas
+  bool *overlapping = calloc(M * M, sizeof(bool));
+  box_pair_array_t added, removed;
+  box_pair_array_init(&added, 0);
+  box_pair_array_init(&removed, 0);
+  sweep_t *sweep = sweep_init();
+  for (size_t i = 0; i < N; i++) {
+    boxes[i] = random_box(100, 10);
+    proxies[i] = sweep_add(sweep, boxes[i]);
+  }
+  for (size_t step = 0; step < 50; step++) {
+    sweep_update(sweep, &added, &removed);
+    for (size_t i = 0; i < box_pair_array_size(&removed); i++) {
+      box_pair_t pair = box_pair_array_get(&removed, i);
+      assert(overlapping[pair.first * M + pair.second]);
+      overlapping[pair.first * M + pair.second] = false;
+    }
+    for (size_t i = 0; i < box_pair_array_size(&added); i++) {
+      box_pair_t pair = box_pair_array_get(&added, i);
+      assert(!overlapping[pair.first * M + pair.second]);
+      overlapping[pair.first * M + pair.second] = true;
+    }
+    size_t n_pairs = 0;
+    for (size_t i = 0; i < N; i++) {
+      for (size_t j = i + 1; j < N; j++) {
+        bool overlap = aabb_overlap(boxes[i], boxes[j]);
+        size_t first = proxies[i] < proxies[j] ? proxies[i] : proxies[j];
+        size_t second = proxies[i] < proxies[j] ? proxies[j] : proxies[i];
+        assert(overlapping[first * M + second] == overlap);
+        n_pairs += overlap;
+      }
+    }
+    assert(sweep_pairs(sweep) == n_pairs);
+
+    // Jiggle every box a little, move a few far, and replace a few
+    for (size_t i = 0; i < N; i++) {
+      vector_t shift = {rand() % 5 - 2, rand() % 5 - 2};
+      if (rand() % 20 == 0) {
+        shift = (vector_t){rand() % 100 - 50, rand() % 100 - 50};
+      }
+      boxes[i].min = vec_add(boxes[i].min, shift);
+      boxes[i].max = vec_add(boxes[i].max, shift);
+      if (rand() % 50 == 0) {
+        sweep_remove(sweep, proxies[i]);
+        boxes[i] = random_box(100, 10);
+        proxies[i] = sweep_add(sweep, boxes[i]);
+      } else {
+        sweep_move(sweep, proxies[i], boxes[i]);
+      }
+    }
+  }
+  sweep_free(sweep);
+  box_pair_array_free(&added);
+  box_pair_array_free(&removed);
+  free(overlapping);
+  free(proxies);
+  free(boxes);
+}
+
+// Whether a list of proxies has a proxy
+bool has_proxy(proxy_array_t *proxies, size_t proxy) {
+  for (size_t i = 0; i < proxy_array_size(proxies); i++) {
+    if (proxy_array_get(proxies, i) == proxy) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void test_tree_queries() {
+  aabb_tree_t *tree = aabb_tree_init(1);
+  proxy_array_t found;
+  proxy_array_init(&found, 0);
+  aabb_tree_query_point(tree, (vector_t){0, 0}, &found);
+  assert(proxy_array_size(&found) == 0);
+  assert(aabb_tree_height(tree) == 0);
+
+  int data[3];
+  size_t a = aabb_tree_insert(tree, (aabb_t){{0, 0}, {2, 2}}, &data[0]);
+  size_t b = aabb_tree_insert(tree, (aabb_t){{5, 0}, {7, 2}}, &data[1]);
+  size_t c = aabb_tree_insert(tree, (aabb_t){{10, 0}, {12, 2}}, &data[2]);
+  assert(aabb_tree_data(tree, b) == &data[1]);
+
+  aabb_tree_query_point(tree, (vector_t){1, 1}, &found);
+  assert(proxy_array_size(&found) == 1 && has_proxy(&found, a));
+  // Inside a's fat box but not a itself
+  aabb_tree_query_point(tree, (vector_t){2.5, 1}, &found);
+  assert(proxy_array_size(&found) == 0);
+  aabb_tree_query_box(tree, (aabb_t){{2, 1}, {5, 1}}, &found);
+  assert(proxy_array_size(&found) == 2);
+  assert(has_proxy(&found, a) && has_proxy(&found, b));
+  // The corner of the square around the circle reaches a, but the circle not
+  aabb_tree_query_radius(tree, (vector_t){3.5, 3.5}, 2, &found);
+  assert(proxy_array_size(&found) == 0);
+  aabb_tree_query_radius(tree, (vector_t){3.5, 1}, 1.5, &found);
+  assert(proxy_array_size(&found) == 2);
+
+  // Segments give the boxes they enter in order
+  aabb_tree_query_ray(tree, (vector_t){20, 1}, (vector_t){-1, 1}, &found);
+  assert(proxy_array_size(&found) == 3);
+  assert(proxy_array_get(&found, 0) == c);
+  assert(proxy_array_get(&found, 1) == b);
+  assert(proxy_array_get(&found, 2) == a);
+  aabb_tree_query_ray(tree, (vector_t){6, 1}, (vector_t){6, 10}, &found);
+  assert(proxy_array_size(&found) == 1 && has_proxy(&found, b));
+  aabb_tree_query_ray(tree, (vector_t){0, 3}, (vector_t){12, 3}, &found);
+  assert(proxy_array_size(&found) == 0);
+
+  // Small moves stay in the fat box
+  assert(!aabb_tree_move(tree, a, (aabb_t){{0.5, 0}, {2.5, 2}}));
+  aabb_tree_query_point(tree, (vector_t){2.5, 1}, &found);
+  assert(proxy_array_size(&found) == 1 && has_proxy(&found, a));
+  assert(aabb_tree_move(tree, a, (aabb_t){{50, 50}, {52, 52}}));
+  aabb_tree_query_point(tree, (vector_t){51, 51}, &found);
+  assert(proxy_array_size(&found) == 1 && has_proxy(&found, a));
+
+  // Removed proxies are reused
+  aabb_tree_remove(tree, b);
+  aabb_tree_query_point(tree, (vector_t){6, 1}, &found);
+  assert(proxy_array_size(&found) == 0);
+  aabb_tree_insert(tree, (aabb_t){{0, 0}, {1, 1}}, NULL);
+  aabb_tree_remove(tree, a);
+  aabb_tree_remove(tree, c);
+  assert(aabb_tree_height(tree) == 1);
+
+  proxy_array_free(&found);
+  aabb_tree_free(tree);
+}
+
+void test_tree_random() {
+  const size_t N = 300;
+  aabb_t *boxes = malloc(sizeof(aabb_t) * N);
+  size_t *proxies = malloc(sizeof(size_t) * N);
+  // Proxies share their numbering with the tree's inner nodes,
+  // so there are about twice as many as boxes
+  const size_t M = 2 * N;
+  // The box each proxy was made for
+  size_t *box_of = malloc(sizeof(size_t) * M);
+  proxy_array_t found;
+  proxy_array_init(&found, 0);
+  box_pair_array_t pairs, expected;
+  box_pair_array_init(&pairs, 0);
+  box_pair_array_init(&expected, 0);
+  grid_t *grid = grid_init(8);
+  aabb_tree_t *tree = aabb_tree_init(2);
+  for (size_t i = 0; i < N; i++) {
+    boxes[i] = random_box(200, 10);
+    proxies[i] = aabb_tree_insert(tree, boxes[i], NULL);
+    assert(proxies[i] < M);
+    box_of[proxies[i]] = i;
+  }
+  for (size_t step = 0; step < 20; step++) {
+    // log2(300) is a little over 8
+    assert(aabb_tree_height(tree) <= 20);
+
+    aabb_t box = random_box(200, 50);
+    aabb_tree_query_box(tree, box, &found);
+    size_t n_found = 0;
+    for (size_t i = 0; i < N; i++) {
+      bool overlap = aabb_overlap(boxes[i], box);
+      assert(has_proxy(&found, proxies[i]) == overlap);
+      n_found += overlap;
+    }
+    assert(proxy_array_size(&found) == n_found);
+
+    // The pairs are the grid's, by proxy rather than by index
+    aabb_tree_find_pairs(tree, &pairs);
+    grid_find_pairs(grid, boxes, N, &expected);
+    assert(box_pair_array_size(&pairs) == box_pair_array_size(&expected));
+    for (size_t i = 0; i < box_pair_array_size(&pairs); i++) {
+      box_pair_t pair = box_pair_array_get(&pairs, i);
+      size_t first = box_of[pair.first];
+      size_t second = box_of[pair.second];
+      assert(has_pair(&expected, first < second ? first : second,
+                      first < second ? second : first));
+    }
+
+    for (size_t i = 0; i < N; i++) {
+      vector_t shift = {rand() % 5 - 2, rand() % 5 - 2};
+      if (rand() % 20 == 0) {
+        shift = (vector_t){rand() % 100 - 50, rand() % 100 - 50};
+      }
+      boxes[i].min = vec_add(boxes[i].min, shift);
+      boxes[i].max = vec_add(boxes[i].max, shift);
+      if (rand() % 50 == 0) {
+        aabb_tree_remove(tree, proxies[i]);
+        boxes[i] = random_box(200, 10);
+        proxies[i] = aabb_tree_insert(tree, boxes[i], NULL);
+        box_of[proxies[i]] = i;
+      } else {
+        aabb_tree_move(tree, proxies[i], boxes[i]);
+      }
+    }
+  }
+
+  // Boxes inserted in order do not make a long chain
+  aabb_tree_t *line = aabb_tree_init(0);
+  for (size_t i = 0; i < 1024; i++) {
+    aabb_tree_insert(line, (aabb_t){{i, 0}, {i + 0.5, 1}}, NULL);
+  }
+  assert(aabb_tree_height(line) <= 2 * 11);
+  aabb_tree_free(line);
+
+  aabb_tree_free(tree);
+  grid_free(grid);
+  box_pair_array_free(&pairs);
+  box_pair_array_free(&expected);
+  proxy_array_free(&found);
+  free(box_of);
+  free(proxies);
+  free(boxes);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_aabb)
+  DO_TEST(test_grid_pairs)
+  DO_TEST(test_grid_random)
+  DO_TEST(test_sweep_deltas)
+  DO_TEST(test_sweep_random)
+  DO_TEST(test_tree_queries)
+  DO_TEST(test_tree_random)
+
+  puts("broadphase_test PASS");
+}
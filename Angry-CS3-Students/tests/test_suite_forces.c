@@ -36,8 +36,8 @@ void test_spring_sinusoid() {
   scene_add_body(scene, anchor);
   create_spring(scene, K, mass, anchor);
   for (int i = 0; i < STEPS; i++) {
-    assert(vec_isclose(body_get_centroid(mass),
-                       (vector_t){A * cos(sqrt(K / M) * i * DT), 0}));
+    assert(vec_within(TEST_EPS, body_get_centroid(mass),
+                      (vector_t){A * cos(sqrt(K / M) * i * DT), 0}));
     assert(vec_equal(body_get_centroid(anchor), VEC_ZERO));
     scene_tick(scene, DT);
   }
@@ -71,7 +71,7 @@ void test_energy_conservation() {
     assert(body_get_centroid(mass1).x < body_get_centroid(mass2).x);
     double energy = gravity_potential(G, mass1, mass2) + kinetic_energy(mass1) +
                     kinetic_energy(mass2);
-    assert(within(1e-4, energy / initial_energy, 1.0));
+    assert(within(1e-4 + TEST_EPS, energy / initial_energy, 1.0));
     scene_tick(scene, DT);
   }
   scene_free(scene);
@@ -150,6 +150,22 @@ void test_forces_removed() {
   scene_free(scene);
 }
 
+// Tests that physics collisions leave two immovable bodies alone
+void test_immovable_collision() {
+  scene_t *scene = scene_init();
+  body_t *wall1 = body_init(make_shape(), INFINITY, (rgb_color_t){0, 0, 0});
+  body_set_velocity(wall1, (vector_t){1, 0});
+  scene_add_body(scene, wall1);
+  body_t *wall2 = body_init(make_shape(), INFINITY, (rgb_color_t){0, 0, 0});
+  body_set_centroid(wall2, (vector_t){1, 0});
+  scene_add_body(scene, wall2);
+  create_physics_collision(scene, 1, wall1, wall2);
+  scene_tick(scene, 1);
+  assert(vec_equal(body_get_velocity(wall1), (vector_t){1, 0}));
+  assert(vec_equal(body_get_velocity(wall2), VEC_ZERO));
+  scene_free(scene);
+}
+
 int main(int argc, char *argv[]) {
   // Run all tests if there are no command-line arguments
   bool all_tests = argc == 1;
@@ -163,6 +179,7 @@ int main(int argc, char *argv[]) {
   DO_TEST(test_energy_conservation)
   DO_TEST(test_collisions)
   DO_TEST(test_forces_removed)
+  DO_TEST(test_immovable_collision)
 
   puts("forces_test PASS");
 }
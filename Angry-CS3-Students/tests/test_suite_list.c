@@ -1,8 +1,11 @@
+#include "array.h"
 #include "list.h"
 #include "test_util.h"
 #include <assert.h>
 #include <stdlib.h>
 
+DEFINE_ARRAY(int, int)
+
 void test_list_size0() {
   list_t *l = list_init(0, free);
   assert(list_size(l) == 0);
@@ -245,6 +248,169 @@ void test_null_values() {
   list_free(l);
 }
 
+// Adds n vectors (i, i) to a list
+void fill_list(list_t *l, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    vector_t *v = malloc(sizeof(*v));
+    v->x = v->y = i;
+    list_add(l, v);
+  }
+}
+
+void test_swap_remove() {
+  list_t *l = list_init(5, free);
+  fill_list(l, 5);
+  // Removing from the middle moves the last element into the gap
+  vector_t *v = list_swap_remove(l, 1);
+  assert(vec_equal(*v, (vector_t){1, 1}));
+  free(v);
+  assert(list_size(l) == 4);
+  assert(vec_equal(*(vector_t *)list_get(l, 0), (vector_t){0, 0}));
+  assert(vec_equal(*(vector_t *)list_get(l, 1), (vector_t){4, 4}));
+  assert(vec_equal(*(vector_t *)list_get(l, 3), (vector_t){3, 3}));
+  // Removing the last element just shrinks the list
+  v = list_swap_remove(l, 3);
+  assert(vec_equal(*v, (vector_t){3, 3}));
+  free(v);
+  assert(list_size(l) == 3);
+  list_free(l);
+}
+
+bool is_odd(void *element, void *aux) {
+  return (size_t)((vector_t *)element)->x % 2 == 1;
+}
+
+size_t n_freed = 0;
+void count_free(void *element) {
+  n_freed++;
+  free(element);
+}
+
+void test_remove_if() {
+  list_t *l = list_init(10, free);
+  fill_list(l, 10);
+  assert(list_remove_if(l, is_odd, NULL) == 5);
+  assert(list_size(l) == 5);
+  // Remaining elements keep their order
+  for (size_t i = 0; i < 5; i++) {
+    assert(vec_equal(*(vector_t *)list_get(l, i), (vector_t){2 * i, 2 * i}));
+  }
+  assert(list_remove_if(l, is_odd, NULL) == 0);
+  assert(list_size(l) == 5);
+  list_free(l);
+}
+
+bool always(void *element, void *aux) { return true; }
+
+void test_remove_if_freer() {
+  n_freed = 0;
+  list_t *l = list_init(4, count_free);
+  fill_list(l, 4);
+  assert(list_remove_if(l, is_odd, NULL) == 2);
+  assert(n_freed == 2);
+  assert(list_remove_if(l, always, NULL) == 2);
+  assert(n_freed == 4);
+  assert(list_size(l) == 0);
+  list_free(l);
+  assert(n_freed == 4);
+}
+
+void test_reserve_shrink() {
+  list_t *l = list_init(0, free);
+  // Adding to a list created with no capacity grows it
+  fill_list(l, 3);
+  assert(list_size(l) == 3);
+  list_reserve(l, 100);
+  fill_list(l, 97);
+  assert(list_size(l) == 100);
+  assert(vec_equal(*(vector_t *)list_get(l, 99), (vector_t){96, 96}));
+  // Reserving less than the current capacity does nothing
+  list_reserve(l, 10);
+  assert(list_size(l) == 100);
+  free(list_remove(l, 0));
+  list_shrink_to_fit(l);
+  assert(list_size(l) == 99);
+  assert(vec_equal(*(vector_t *)list_get(l, 0), (vector_t){1, 1}));
+  fill_list(l, 1);
+  assert(list_size(l) == 100);
+  list_free(l);
+}
+
+// Small lists start out in inline storage; make sure spilling to the heap
+// and shrinking back preserves the elements
+void test_small_list_spill() {
+  list_t *l = list_init(2, free);
+  fill_list(l, 2);
+  assert(list_size(l) == 2);
+  fill_list(l, 7);
+  assert(list_size(l) == 9);
+  for (size_t i = 0; i < 2; i++) {
+    assert(vec_equal(*(vector_t *)list_get(l, i), (vector_t){i, i}));
+  }
+  for (size_t i = 2; i < 9; i++) {
+    assert(vec_equal(*(vector_t *)list_get(l, i), (vector_t){i - 2, i - 2}));
+  }
+  while (list_size(l) > 3) {
+    free(list_remove(l, 0));
+  }
+  list_shrink_to_fit(l);
+  assert(vec_equal(*(vector_t *)list_get(l, 0), (vector_t){4, 4}));
+  assert(vec_equal(*(vector_t *)list_get(l, 2), (vector_t){6, 6}));
+  fill_list(l, 2);
+  assert(list_size(l) == 5);
+  assert(vec_equal(*(vector_t *)list_get(l, 4), (vector_t){1, 1}));
+  list_free(l);
+}
+
+void int_array_get_out_of_bounds(void *array) {
+  int_array_get(array, int_array_size(array));
+}
+
+void test_typed_array() {
+  int_array_t array;
+  int_array_init(&array, 0);
+  for (int i = 0; i < 100; i++) {
+    int_array_push(&array, i);
+  }
+  assert(int_array_size(&array) == 100);
+  for (int i = 0; i < 100; i++) {
+    assert(int_array_get(&array, i) == i);
+  }
+  int_array_set(&array, 7, -7);
+  *int_array_at(&array, 8) = -8;
+  assert(int_array_get(&array, 7) == -7);
+  assert(int_array_get(&array, 8) == -8);
+  assert(int_array_pop(&array) == 99);
+  assert(int_array_size(&array) == 99);
+#if !defined(ARRAY_NO_BOUNDS_CHECK) && !defined(NDEBUG)
+  assert(test_assert_fail(int_array_get_out_of_bounds, &array));
+#endif
+  int_array_free(&array);
+}
+
+void test_typed_array_remove() {
+  int_array_t array;
+  int_array_init(&array, 2);
+  for (int i = 0; i < 5; i++) {
+    int_array_push(&array, i);
+  }
+  // Ordered removal shifts the tail down: 0 1 3 4
+  assert(int_array_remove(&array, 2) == 2);
+  assert(int_array_size(&array) == 4);
+  assert(int_array_get(&array, 2) == 3);
+  assert(int_array_get(&array, 3) == 4);
+  // Swap removal moves the last element into the gap: 4 1 3
+  assert(int_array_swap_remove(&array, 0) == 0);
+  assert(int_array_size(&array) == 3);
+  assert(int_array_get(&array, 0) == 4);
+  assert(int_array_get(&array, 1) == 1);
+  assert(int_array_get(&array, 2) == 3);
+  int_array_truncate(&array, 1);
+  assert(int_array_size(&array) == 1);
+  assert(int_array_get(&array, 0) == 4);
+  int_array_free(&array);
+}
+
 int main(int argc, char *argv[]) {
   // Run all tests if there are no command-line arguments
   bool all_tests = argc == 1;
@@ -263,6 +429,13 @@ int main(int argc, char *argv[]) {
   DO_TEST(test_full_add)
   DO_TEST(test_empty_remove)
   DO_TEST(test_null_values)
+  DO_TEST(test_swap_remove)
+  DO_TEST(test_remove_if)
+  DO_TEST(test_remove_if_freer)
+  DO_TEST(test_reserve_shrink)
+  DO_TEST(test_small_list_spill)
+  DO_TEST(test_typed_array)
+  DO_TEST(test_typed_array_remove)
 
   puts("list_test PASS");
 }
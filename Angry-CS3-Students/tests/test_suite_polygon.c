@@ -218,6 +218,57 @@ void test_weird_rotate() {
   list_free(w);
 }
 
+void test_array_square() {
+  vector_t points[] = {{+1, +1}, {-1, +1}, {-1, -1}, {+1, -1}};
+  vertex_array_t *sq = vertex_array_from(points, 4);
+  assert(isclose(polygon_array_area(sq), 4));
+  assert(vec_isclose(polygon_array_centroid(sq), VEC_ZERO));
+  polygon_array_translate(sq, (vector_t){2, 3});
+  assert(vec_equal(sq->data[0], (vector_t){3, 4}));
+  assert(vec_equal(sq->data[2], (vector_t){1, 2}));
+  assert(vec_isclose(polygon_array_centroid(sq), (vector_t){2, 3}));
+  polygon_array_rotate(sq, 0.25 * M_PI, (vector_t){2, 3});
+  assert(vec_isclose(sq->data[0], (vector_t){2, 3 + sqrt(2)}));
+  assert(vec_isclose(sq->data[1], (vector_t){2 - sqrt(2), 3}));
+  assert(isclose(polygon_array_area(sq), 4));
+  vertex_array_free(sq);
+}
+
+void test_mass_properties() {
+  vector_t rect_points[] = {{10, 20}, {14, 20}, {14, 22}, {10, 22}};
+  vertex_array_t *rect = vertex_array_from(rect_points, 4);
+  polygon_mass_properties_t properties = polygon_array_mass_properties(rect);
+  assert(isclose(properties.area, 8));
+  assert(vec_isclose(properties.centroid, (vector_t){12, 21}));
+  // A (w^2 + h^2) / 12
+  assert(isclose(properties.inertia, 40.0 / 3));
+  vertex_array_free(rect);
+
+  list_t *tri = make_triangle();
+  vector_t *v = list_get(tri, 1);
+  *v = (vector_t){3, 0};
+  v = list_get(tri, 2);
+  *v = (vector_t){0, 6};
+  properties = polygon_mass_properties(tri);
+  assert(isclose(properties.area, 9));
+  assert(vec_isclose(properties.centroid, (vector_t){1, 2}));
+  // b h^3 / 36 + h b^3 / 36
+  assert(isclose(properties.inertia, 22.5));
+  list_free(tri);
+}
+
+void test_unit_circle() {
+  const vector_t *circle = polygon_unit_circle(20);
+  for (size_t i = 0; i < 20; i++) {
+    double angle = 2 * M_PI * i / 20;
+    assert(vec_isclose(circle[i], (vector_t){cos(angle), sin(angle)}));
+  }
+  assert(vec_equal(circle[0], (vector_t){1, 0}));
+  // Tables are built once and shared
+  assert(polygon_unit_circle(20) == circle);
+  assert(polygon_unit_circle(7) != circle);
+}
+
 int main(int argc, char *argv[]) {
   // Run all tests? True if there are no command-line arguments
   bool all_tests = argc == 1;
@@ -239,6 +290,9 @@ int main(int argc, char *argv[]) {
   DO_TEST(test_weird_area_centroid)
   DO_TEST(test_weird_translate)
   DO_TEST(test_weird_rotate)
+  DO_TEST(test_array_square)
+  DO_TEST(test_mass_properties)
+  DO_TEST(test_unit_circle)
 
   puts("polygon_test PASS");
 }
@@ -0,0 +1,95 @@
+#include "list.h"
+#include "pool.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  double x;
+  char name[20];
+} thing_t;
+
+void test_pool_alloc() {
+  pool_t *pool = pool_init(sizeof(thing_t), 4);
+  assert(pool_live(pool) == 0);
+  thing_t *a = pool_alloc(pool);
+  thing_t *b = pool_alloc(pool);
+  assert(a != b);
+  assert(pool_live(pool) == 2);
+  a->x = 1;
+  strcpy(a->name, "first");
+  b->x = 2;
+  strcpy(b->name, "second");
+  assert(a->x == 1 && strcmp(a->name, "first") == 0);
+  assert(b->x == 2 && strcmp(b->name, "second") == 0);
+  pool_release(a);
+  pool_release(b);
+  assert(pool_live(pool) == 0);
+  pool_free(pool);
+}
+
+void test_pool_reuse() {
+  pool_t *pool = pool_init(sizeof(thing_t), 4);
+  thing_t *a = pool_alloc(pool);
+  pool_release(a);
+  // The most recently released object is handed out next
+  assert(pool_alloc(pool) == a);
+  pool_release(a);
+  pool_release(NULL);
+  assert(pool_live(pool) == 0);
+  pool_free(pool);
+}
+
+void test_pool_many_slabs() {
+  const size_t N = 1000;
+  pool_t *pool = pool_init(sizeof(size_t), 16);
+  size_t **objects = malloc(sizeof(size_t *) * N);
+  for (size_t i = 0; i < N; i++) {
+    objects[i] = pool_alloc(pool);
+    // Every object is aligned for any type
+    assert((uintptr_t)objects[i] % _Alignof(max_align_t) == 0);
+    *objects[i] = i;
+  }
+  assert(pool_live(pool) == N);
+  for (size_t i = 0; i < N; i++) {
+    assert(*objects[i] == i);
+  }
+  // Release every other object; the rest must be untouched
+  for (size_t i = 0; i < N; i += 2) {
+    pool_release(objects[i]);
+  }
+  assert(pool_live(pool) == N / 2);
+  for (size_t i = 1; i < N; i += 2) {
+    assert(*objects[i] == i);
+  }
+  free(objects);
+  // Releases the objects that are still allocated too
+  pool_free(pool);
+}
+
+void test_pool_release_as_freer() {
+  pool_t *pool = pool_init(sizeof(thing_t), 2);
+  free_func_t freer = pool_release;
+  freer(pool_alloc(pool));
+  assert(pool_live(pool) == 0);
+  pool_free(pool);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_pool_alloc)
+  DO_TEST(test_pool_reuse)
+  DO_TEST(test_pool_many_slabs)
+  DO_TEST(test_pool_release_as_freer)
+
+  puts("pool_test PASS");
+}
@@ -91,7 +91,7 @@ void centripetal_force(void *aux) {
   body_t *body = aux;
   vector_t v = body_get_velocity(body);
   vector_t r = body_get_centroid(body);
-  assert(isclose(vec_dot(v, r), 0));
+  assert(within(TEST_EPS, vec_dot(v, r), 0));
   vector_t force =
       vec_multiply(-body_get_mass(body) * vec_dot(v, v) / vec_dot(r, r), r);
   body_add_force(body, force);
@@ -108,10 +108,11 @@ void test_force_creator() {
   body_set_centroid(body, radius);
   body_set_velocity(body, (vector_t){0, OMEGA * R});
   scene_add_body(scene, body);
-  scene_add_force_creator(scene, centripetal_force, body, NULL);
+  scene_add_force_creator(scene, centripetal_force, body, NULL, 0);
   for (int i = 0; i < STEPS; i++) {
     vector_t expected_x = vec_rotate(radius, OMEGA * i * DT);
-    assert(vec_within(1e-4, body_get_centroid(body), expected_x));
+    // The integration's own error, plus rounding
+    assert(vec_within(1e-4 + TEST_EPS, body_get_centroid(body), expected_x));
     scene_tick(scene, DT);
   }
   scene_free(scene);
@@ -161,11 +162,11 @@ void test_force_creator_aux() {
   force_aux_t *gravity_aux = malloc(sizeof(*gravity_aux));
   gravity_aux->scene = scene;
   gravity_aux->coefficient = GRAVITY;
-  scene_add_force_creator(scene, constant_gravity, gravity_aux, free);
+  scene_add_force_creator(scene, constant_gravity, gravity_aux, free, 0);
   force_aux_t *drag_aux = malloc(sizeof(*drag_aux));
   drag_aux->scene = scene;
   drag_aux->coefficient = DRAG;
-  scene_add_force_creator(scene, air_drag, drag_aux, free);
+  scene_add_force_creator(scene, air_drag, drag_aux, free, 0);
   for (int i = 0; i < STEPS; i++)
     scene_tick(scene, DT);
   assert(vec_isclose(body_get_velocity(light),
@@ -208,7 +209,7 @@ void test_reaping() {
     scene_add_body(scene, body_init(make_shape(), 1, (rgb_color_t){0, 0, 0}));
   }
   scene_add_bodies_force_creator(scene, remove_body, scene, list_init(0, NULL),
-                                 NULL);
+                                 NULL, 0);
 
   count_aux_t *count_aux = malloc(sizeof(*count_aux));
   count_aux->count = 0;
@@ -217,7 +218,7 @@ void test_reaping() {
   list_add(required_bodies, scene_get_body(scene, 0));
   list_add(required_bodies, scene_get_body(scene, 1));
   scene_add_bodies_force_creator(scene, count_calls, count_aux, required_bodies,
-                                 NULL);
+                                 NULL, 0);
 
   while (scene_bodies(scene) > 0) {
     scene_tick(scene, 1);
@@ -228,6 +229,414 @@ void test_reaping() {
   scene_free(scene);
 }
 
+void count_freed(void *aux) { (*(int *)aux)++; }
+
+void do_nothing(void *aux) {}
+
+list_t *pair(body_t *body1, body_t *body2) {
+  list_t *bodies = list_init(2, NULL);
+  list_add(bodies, body1);
+  if (body2 != NULL) {
+    list_add(bodies, body2);
+  }
+  return bodies;
+}
+
+// Removing a body reaps exactly the force creators that depend on it
+void test_reaping_shared_bodies() {
+  scene_t *scene = scene_init();
+  body_t *bodies[4];
+  for (int i = 0; i < 4; i++) {
+    bodies[i] = body_init(make_shape(), 1, (rgb_color_t){0, 0, 0});
+    scene_add_body(scene, bodies[i]);
+  }
+  int freed[6] = {0};
+  scene_add_bodies_force_creator(scene, do_nothing, &freed[0],
+                                 pair(bodies[0], bodies[1]), count_freed, 1);
+  scene_add_bodies_force_creator(scene, do_nothing, &freed[1],
+                                 pair(bodies[1], bodies[2]), count_freed, 2);
+  scene_add_bodies_force_creator(scene, do_nothing, &freed[2],
+                                 pair(bodies[0], bodies[2]), count_freed, 3);
+  scene_add_bodies_force_creator(scene, do_nothing, &freed[3],
+                                 pair(bodies[2], NULL), count_freed, 4);
+  scene_add_bodies_force_creator(scene, do_nothing, &freed[4],
+                                 pair(bodies[3], bodies[1]), count_freed, 5);
+  scene_add_force_creator(scene, do_nothing, &freed[5], count_freed, 6);
+
+  // A force creator removed by id no longer depends on its bodies
+  scene_remove_force_creator(scene, 5);
+  assert(freed[4] == 1);
+
+  body_remove(bodies[0]);
+  scene_tick(scene, 1);
+  assert(freed[0] == 1 && freed[1] == 0 && freed[2] == 1 && freed[3] == 0);
+
+  body_remove(bodies[2]);
+  body_remove(bodies[3]);
+  scene_tick(scene, 1);
+  assert(freed[1] == 1 && freed[3] == 1 && freed[4] == 1 && freed[5] == 0);
+  assert(scene_bodies(scene) == 1);
+  scene_free(scene);
+  assert(freed[5] == 1);
+}
+
+// Each counter is {calls, frees}
+void count_call(void *aux) { ((int *)aux)[0]++; }
+
+void count_free(void *aux) { ((int *)aux)[1]++; }
+
+// A different force creator that counts the same way
+void count_call_too(void *aux) { ((int *)aux)[0]++; }
+
+void test_force_creator_ids() {
+  scene_t *scene = scene_init();
+  body_t *bodies[2];
+  for (int i = 0; i < 2; i++) {
+    bodies[i] = body_init(make_shape(), 1, (rgb_color_t){0, 0, 0});
+    scene_add_body(scene, bodies[i]);
+  }
+  int counters[5][2] = {{0}};
+  // Consecutive force creators with one id are all removed
+  scene_add_bodies_force_creator(scene, count_call, counters[0],
+                                 pair(bodies[0], NULL), count_free, 1);
+  scene_add_bodies_force_creator(scene, count_call, counters[1],
+                                 pair(bodies[1], NULL), count_free, 1);
+  scene_add_bodies_force_creator(scene, count_call, counters[2],
+                                 pair(bodies[0], bodies[1]), count_free, 1);
+  scene_add_bodies_force_creator(scene, count_call, counters[3],
+                                 pair(bodies[0], NULL), count_free, 2);
+  scene_remove_force_creator(scene, 1);
+  assert(counters[0][1] == 1 && counters[1][1] == 1 && counters[2][1] == 1);
+  scene_tick(scene, 1);
+  assert(counters[0][0] == 0 && counters[1][0] == 0 && counters[2][0] == 0);
+  assert(counters[3][0] == 1 && counters[3][1] == 0);
+  scene_remove_force_creator(scene, 7);
+
+  // Upserting replaces only the force creator on the same bodies
+  scene_add_bodies_force_creator(scene, count_call, counters[0],
+                                 pair(bodies[1], NULL), count_free, 2);
+  scene_upsert_bodies_force_creator(scene, count_call, counters[4],
+                                    pair(bodies[0], NULL), count_free, 2);
+  assert(counters[3][1] == 1 && counters[0][1] == 1);
+  scene_tick(scene, 1);
+  assert(counters[3][0] == 1 && counters[4][0] == 1 && counters[0][0] == 1);
+
+  // Different force creators with one id on one body are kept apart
+  int others[3][2] = {{0}};
+  scene_add_bodies_force_creator(scene, count_call_too, others[0],
+                                 pair(bodies[1], NULL), count_free, 3);
+  scene_upsert_bodies_force_creator(scene, count_call, others[1],
+                                    pair(bodies[1], NULL), count_free, 3);
+  assert(others[0][1] == 0);
+  scene_upsert_bodies_force_creator(scene, count_call_too, others[2],
+                                    pair(bodies[1], NULL), count_free, 3);
+  assert(others[0][1] == 1 && others[1][1] == 0);
+  scene_tick(scene, 1);
+  assert(others[1][0] == 1 && others[2][0] == 1 && others[0][0] == 0);
+
+  // The replacement is still removed with its body
+  body_remove(bodies[0]);
+  scene_tick(scene, 1);
+  assert(counters[4][1] == 1 && counters[0][1] == 1);
+  scene_free(scene);
+  assert(counters[0][1] == 2);
+}
+
+typedef struct {
+  int calls;
+  body_t *body1;
+  body_t *body2;
+  vector_t axis;
+} hit_t;
+
+void record_hit(body_t *body1, body_t *body2, vector_t axis, void *aux) {
+  hit_t *hit = aux;
+  hit->calls++;
+  hit->body1 = body1;
+  hit->body2 = body2;
+  hit->axis = axis;
+}
+
+void ignore_hit(body_t *body1, body_t *body2, vector_t axis, void *aux) {}
+
+body_t *collider(scene_t *scene, size_t tag, vector_t centroid) {
+  body_t *body = body_init(make_shape(), 1, (rgb_color_t){0, 0, 0});
+  body_set_tag(body, tag);
+  body_set_collidable(body, true);
+  body_set_centroid(body, centroid);
+  scene_add_body(scene, body);
+  return body;
+}
+
+void check_collisions(scene_broadphase_t broadphase) {
+  scene_t *scene = scene_init();
+  scene_set_broadphase(scene, broadphase);
+  body_t *a = collider(scene, 1, (vector_t){0, 0});
+  body_t *b = collider(scene, 2, (vector_t){1.5, 0});
+  body_t *far = collider(scene, 2, (vector_t){500, 0});
+  // Overlaps a, but has not opted in
+  body_t *ghost = collider(scene, 2, (vector_t){-1.5, 0});
+  body_set_collidable(ghost, false);
+  // Overlaps a, but no handler has its tag
+  collider(scene, 3, (vector_t){0, 1.5});
+  hit_t hit = {0};
+  int freed[2] = {0};
+  scene_add_collision_handler(scene, 2, 1, record_hit, &freed[0],
+                              count_freed);
+  // Replaces the handler above
+  scene_add_collision_handler(scene, 2, 1, record_hit, &hit, NULL);
+  assert(freed[0] == 1);
+
+  scene_tick(scene, 0);
+  assert(hit.calls == 1);
+  assert(hit.body1 == b && hit.body2 == a);
+  // The axis is found with the bodies in the handler's order, as
+  // create_collision() finds it, so either normal may be the axis
+  assert(isclose(fabs(hit.axis.x), 1) && isclose(hit.axis.y, 0));
+  // Only called again once the bodies have separated
+  scene_tick(scene, 0);
+  assert(hit.calls == 1);
+  body_set_centroid(b, (vector_t){5, 0});
+  scene_tick(scene, 0);
+  assert(hit.calls == 1);
+  body_set_centroid(b, (vector_t){0, 1});
+  scene_tick(scene, 0);
+  assert(hit.calls == 2);
+  assert(isclose(hit.axis.x, 0));
+
+  body_set_centroid(far, (vector_t){-1, 0});
+  scene_tick(scene, 0);
+  assert(hit.calls == 3 && hit.body1 == far);
+  // Removed bodies stop colliding
+  body_remove(b);
+  body_remove(far);
+  scene_tick(scene, 0);
+  body_set_centroid(ghost, (vector_t){0, 0.5});
+  scene_tick(scene, 0);
+  assert(hit.calls == 3);
+
+  // A rule between a tag and itself applies to both orders of a pair,
+  // in the order of the bodies in the scene
+  hit_t same = {0};
+  scene_add_collision_handler(scene, 4, 4, record_hit, &same, NULL);
+  body_t *c = collider(scene, 4, (vector_t){100, 100});
+  body_t *d = collider(scene, 4, (vector_t){101, 100});
+  scene_tick(scene, 0);
+  assert(same.calls == 2 && same.body1 == c && same.body2 == d);
+
+  // A pair handler needs neither a tag rule nor opting in, and is called
+  // for a pair that is already touching when it is added
+  hit_t paired = {0};
+  int pair_freed = 0;
+  body_t *e = collider(scene, 5, (vector_t){200, 200});
+  body_t *f = collider(scene, 5, (vector_t){201, 200});
+  body_set_collidable(f, false);
+  scene_tick(scene, 0);
+  scene_add_pair_collision_handler(scene, e, f, record_hit, &paired, NULL);
+  scene_add_pair_collision_handler(scene, e, f, ignore_hit, &pair_freed,
+                                   count_freed);
+  scene_tick(scene, 0);
+  assert(paired.calls == 1 && paired.body1 == e && paired.body2 == f);
+  scene_tick(scene, 0);
+  assert(paired.calls == 1);
+  body_set_centroid(f, (vector_t){300, 200});
+  scene_tick(scene, 0);
+  body_set_centroid(f, (vector_t){201, 200});
+  scene_tick(scene, 0);
+  assert(paired.calls == 2);
+  // Removed with either body
+  body_remove(e);
+  scene_tick(scene, 0);
+  assert(pair_freed == 1);
+  body_set_centroid(f, (vector_t){100, 100});
+  scene_tick(scene, 0);
+  assert(paired.calls == 2);
+  scene_free(scene);
+}
+
+void test_scene_collisions() {
+  check_collisions(SCENE_BROADPHASE_GRID);
+  check_collisions(SCENE_BROADPHASE_SWEEP);
+  check_collisions(SCENE_BROADPHASE_TREE);
+}
+
+void test_scene_queries() {
+  scene_t *scene = scene_init();
+  body_t *a = collider(scene, 1, (vector_t){0, 0});
+  body_t *b = collider(scene, 1, (vector_t){10, 0});
+  body_t *c = collider(scene, 1, (vector_t){20, 0});
+  body_ptr_array_t found;
+  body_ptr_array_init(&found, 0);
+
+  scene_query_point(scene, (vector_t){10.5, 0.5}, &found);
+  assert(body_ptr_array_size(&found) == 1);
+  assert(body_ptr_array_get(&found, 0) == b);
+  scene_query_box(scene, (aabb_t){{0.5, -5}, {9, 5}}, &found);
+  assert(body_ptr_array_size(&found) == 2);
+  scene_query_radius(scene, (vector_t){5, 0}, 3, &found);
+  assert(body_ptr_array_size(&found) == 0);
+  scene_query_radius(scene, (vector_t){5, 0}, 4, &found);
+  assert(body_ptr_array_size(&found) == 2);
+  scene_query_ray(scene, (vector_t){30, 0}, (vector_t){-5, 0}, &found);
+  assert(body_ptr_array_size(&found) == 3);
+  assert(body_ptr_array_get(&found, 0) == c);
+  assert(body_ptr_array_get(&found, 1) == b);
+  assert(body_ptr_array_get(&found, 2) == a);
+
+  // Bodies added are found straight away, and bodies moved after a tick
+  body_t *d = collider(scene, 1, (vector_t){100, 1});
+  scene_query_point(scene, (vector_t){100, 0.5}, &found);
+  assert(body_ptr_array_size(&found) == 1);
+  assert(body_ptr_array_get(&found, 0) == d);
+  body_set_centroid(a, (vector_t){100, 0});
+  scene_query_point(scene, (vector_t){0, 0}, &found);
+  assert(body_ptr_array_size(&found) == 1);
+  scene_tick(scene, 0);
+  scene_query_point(scene, (vector_t){100, 0.5}, &found);
+  assert(body_ptr_array_size(&found) == 2);
+  scene_query_point(scene, (vector_t){0, 0}, &found);
+  assert(body_ptr_array_size(&found) == 0);
+  // Ticking moves bodies in the tree too
+  body_set_velocity(c, (vector_t){0, 10});
+  scene_tick(scene, 1);
+  scene_query_point(scene, (vector_t){20, 10}, &found);
+  assert(body_ptr_array_size(&found) == 1);
+  assert(body_ptr_array_get(&found, 0) == c);
+
+  // Removed bodies are not found, before or after they are reaped
+  body_remove(d);
+  scene_query_point(scene, (vector_t){100, 0.5}, &found);
+  assert(body_ptr_array_size(&found) == 1);
+  assert(body_ptr_array_get(&found, 0) == a);
+  body_remove(b);
+  scene_tick(scene, 0);
+  scene_query_box(scene, (aabb_t){{-50, -50}, {50, 50}}, &found);
+  assert(body_ptr_array_size(&found) == 1);
+  assert(body_ptr_array_get(&found, 0) == c);
+
+  body_ptr_array_free(&found);
+  scene_free(scene);
+}
+
+void test_scene_tags() {
+  scene_t *scene = scene_init();
+  body_t *bodies[5];
+  size_t tags[] = {3, 1, 3, BODY_NO_TAG, 3};
+  for (int i = 0; i < 5; i++) {
+    bodies[i] = body_init(make_shape(), 1, (rgb_color_t){0, 0, 0});
+    if (tags[i] != BODY_NO_TAG) {
+      body_set_tag(bodies[i], tags[i]);
+    }
+    assert(body_get_tag(bodies[i]) == tags[i]);
+    scene_add_body(scene, bodies[i]);
+  }
+  assert(scene_count_tag(scene, 3) == 3);
+  assert(scene_count_tag(scene, 1) == 1);
+  assert(scene_count_tag(scene, 0) == 0);
+  assert(scene_count_tag(scene, 200) == 0);
+  assert(scene_first_tag(scene, 3) == bodies[0]);
+  assert(scene_first_tag(scene, 2) == NULL);
+  const body_ptr_array_t *threes = scene_get_tagged(scene, 3);
+  assert(body_ptr_array_get(threes, 1) == bodies[2]);
+  assert(body_ptr_array_get(threes, 2) == bodies[4]);
+
+  // Removed bodies leave their tag's bodies when they are reaped
+  body_remove(bodies[0]);
+  body_remove(bodies[3]);
+  assert(scene_count_tag(scene, 3) == 3);
+  scene_tick(scene, 1);
+  assert(scene_count_tag(scene, 3) == 2);
+  assert(scene_first_tag(scene, 3) == bodies[2]);
+  assert(scene_first_tag(scene, 1) == bodies[1]);
+  body_remove(bodies[1]);
+  scene_tick(scene, 1);
+  assert(scene_count_tag(scene, 1) == 0);
+  assert(scene_first_tag(scene, 1) == NULL);
+  scene_free(scene);
+}
+
+void test_scene_handles() {
+  scene_t *scene = scene_init();
+  body_handle_t handles[3];
+  for (int i = 0; i < 3; i++) {
+    body_t *body = body_init(make_shape(), 1, (rgb_color_t){0, 0, 0});
+    handles[i] = scene_add_body(scene, body);
+    assert(handles[i] == body_get_handle(body));
+  }
+  body_t *body2 = scene_get_body(scene, 2);
+  assert(scene_get_body_by_handle(scene, handles[2]) == body2);
+
+  // Handles stay valid as bodies before them are removed
+  scene_remove_body_by_handle(scene, handles[0]);
+  assert(scene_get_body_by_handle(scene, handles[0]) == NULL);
+  scene_tick(scene, 1);
+  assert(scene_bodies(scene) == 2);
+  assert(scene_get_body(scene, 1) == body2);
+  assert(scene_get_body_by_handle(scene, handles[2]) == body2);
+  scene_remove_body_by_handle(scene, handles[0]);
+  assert(scene_bodies(scene) == 2);
+
+  scene_remove_body_by_handle(scene, handles[2]);
+  scene_tick(scene, 1);
+  assert(scene_bodies(scene) == 1);
+  assert(scene_get_body_by_handle(scene, handles[1]) ==
+         scene_get_body(scene, 0));
+
+  // Another scene's handles are not found
+  scene_t *other = scene_init();
+  body_handle_t foreign = scene_add_body(
+      other, body_init(make_shape(), 1, (rgb_color_t){0, 0, 0}));
+  assert(scene_get_body_by_handle(scene, foreign) == NULL);
+  scene_remove_body_by_handle(scene, foreign);
+  assert(scene_get_body_by_handle(other, foreign) != NULL);
+  assert(scene_get_body_by_handle(other, handles[1]) == NULL);
+  scene_free(other);
+  scene_free(scene);
+}
+
+// A scene with SCENE_STORAGE_ARRAYS must behave exactly like the default
+void test_scene_storage() {
+  scene_t *scenes[] = {scene_init(),
+                       scene_init_with_storage(SCENE_STORAGE_ARRAYS)};
+  for (size_t s = 0; s < 2; s++) {
+    for (int i = 0; i < 5; i++) {
+      real_t mass = i == 0 ? INFINITY : i;
+      body_t *body = body_init(make_shape(), mass, (rgb_color_t){0, 0, 0});
+      body_set_centroid(body, (vector_t){3 * i, i});
+      body_set_velocity(body, (vector_t){-i, 2});
+      scene_add_body(scenes[s], body);
+    }
+  }
+
+  for (int t = 0; t < 100; t++) {
+    if (t == 50) {
+      body_remove(scene_get_body(scenes[0], 2));
+      body_remove(scene_get_body(scenes[1], 2));
+    }
+    for (size_t s = 0; s < 2; s++) {
+      for (size_t i = 0; i < scene_bodies(scenes[s]); i++) {
+        body_t *body = scene_get_body(scenes[s], i);
+        body_add_force(body, vec_negate(body_get_centroid(body)));
+        if (t % 10 == 0) {
+          body_add_impulse(body, (vector_t){1, -(real_t)i});
+        }
+      }
+      scene_tick(scenes[s], 0.01);
+    }
+
+    assert(scene_bodies(scenes[0]) == scene_bodies(scenes[1]));
+    for (size_t i = 0; i < scene_bodies(scenes[0]); i++) {
+      body_t *body0 = scene_get_body(scenes[0], i);
+      body_t *body1 = scene_get_body(scenes[1], i);
+      assert(vec_equal(body_get_centroid(body0), body_get_centroid(body1)));
+      assert(vec_equal(body_get_velocity(body0), body_get_velocity(body1)));
+    }
+  }
+  assert(scene_bodies(scenes[1]) == 4);
+  scene_free(scenes[0]);
+  scene_free(scenes[1]);
+}
+
 int main(int argc, char *argv[]) {
   // Run all tests if there are no command-line arguments
   bool all_tests = argc == 1;
@@ -242,6 +651,13 @@ int main(int argc, char *argv[]) {
   DO_TEST(test_force_creator)
   DO_TEST(test_force_creator_aux)
   DO_TEST(test_reaping)
+  DO_TEST(test_reaping_shared_bodies)
+  DO_TEST(test_force_creator_ids)
+  DO_TEST(test_scene_collisions)
+  DO_TEST(test_scene_queries)
+  DO_TEST(test_scene_tags)
+  DO_TEST(test_scene_handles)
+  DO_TEST(test_scene_storage)
 
   puts("scene_test PASS");
 }
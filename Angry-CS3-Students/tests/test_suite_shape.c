@@ -0,0 +1,86 @@
+#include "shape.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+size_t n_made = 0;
+
+// A width x height rectangle with a corner at the origin
+vertex_array_t *make_box(real_t width, real_t height) {
+  n_made++;
+  vector_t points[] = {{0, 0}, {width, 0}, {width, height}, {0, height}};
+  return vertex_array_from(points, 4);
+}
+
+void test_shape_init() {
+  vector_t points[] = {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+  shape_t *shape = shape_init(vertex_array_from(points, 4));
+  assert(shape->refs == 1);
+  assert(isclose(shape->area, 4));
+  assert(isclose(shape->inertia, 8.0 / 3.0));
+  assert(isclose(shape->radius, sqrt(2)));
+  assert(vec_isclose(shape->bounds.min, (vector_t){-1, -1}));
+  assert(vec_isclose(shape->bounds.max, (vector_t){1, 1}));
+  // Outward normals of the bottom, right, top and left edges
+  assert(vec_isclose(shape->normals->data[0], (vector_t){0, -1}));
+  assert(vec_isclose(shape->normals->data[1], (vector_t){1, 0}));
+  assert(vec_isclose(shape->normals->data[2], (vector_t){0, 1}));
+  assert(vec_isclose(shape->normals->data[3], (vector_t){-1, 0}));
+  // The top and left edges are parallel to the bottom and right ones
+  assert(shape->axes->size == 2);
+  assert(vec_isclose(shape->axes->data[0], (vector_t){0, -1}));
+  assert(vec_isclose(shape->axes->data[1], (vector_t){1, 0}));
+
+  assert(shape_retain(shape) == shape);
+  assert(shape->refs == 2);
+  shape_release(shape);
+  assert(shape->refs == 1);
+  shape_release(shape);
+}
+
+void test_shape_intern() {
+  shape_registry_clear();
+  n_made = 0;
+  shape_t *box = shape_intern("box", 4, 2, make_box);
+  assert(n_made == 1);
+  assert(shape_intern("box", 4, 2, make_box) == box);
+  assert(n_made == 1);
+  assert(shape_registry_size() == 1);
+  // Any difference in kind or parameters is a different shape
+  assert(shape_intern("box", 2, 4, make_box) != box);
+  assert(shape_intern("crate", 4, 2, make_box) != box);
+  assert(n_made == 3);
+  assert(shape_registry_size() == 3);
+
+  // Interned shapes are centered on their centroid
+  assert(vec_isclose(box->vertices->data[0], (vector_t){-2, -1}));
+  assert(vec_isclose(box->vertices->data[2], (vector_t){2, 1}));
+  assert(isclose(box->radius, sqrt(5)));
+
+  // Clearing the registry keeps shapes that are still referenced
+  shape_retain(box);
+  shape_registry_clear();
+  assert(shape_registry_size() == 0);
+  assert(box->refs == 1);
+  assert(isclose(box->area, 8));
+  shape_release(box);
+  assert(shape_intern("box", 4, 2, make_box) != NULL);
+  assert(n_made == 4);
+  shape_registry_clear();
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_shape_init)
+  DO_TEST(test_shape_intern)
+
+  puts("shape_test PASS");
+}
@@ -0,0 +1,220 @@
+#include "vec_batch.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_N 13
+#define N_LAYOUTS 3
+#define N_BACKENDS 3
+
+const vec_batch_backend_t BACKENDS[N_BACKENDS] = {
+    VEC_BATCH_SCALAR, VEC_BATCH_SSE2, VEC_BATCH_AVX2};
+
+// Components for MAX_N vectors in any of the layouts below
+typedef struct {
+  real_t data[3 * MAX_N];
+} buffer_t;
+
+// Gets the x and y arrays and stride of a layout:
+// structure-of-arrays, array of vector_t, or a wider stride
+void layout(buffer_t *buffer, size_t which, real_t **xs, real_t **ys,
+            size_t *stride) {
+  *xs = buffer->data;
+  if (which == 0) {
+    *ys = buffer->data + MAX_N;
+    *stride = 1;
+  } else {
+    *ys = buffer->data + 1;
+    *stride = which + 1;
+  }
+}
+
+buffer_t random_buffer() {
+  buffer_t buffer;
+  for (size_t i = 0; i < 3 * MAX_N; i++) {
+    buffer.data[i] = (double)rand() / RAND_MAX * 1000 - 500;
+  }
+  return buffer;
+}
+
+void test_backends() {
+  assert(vec_batch_set_backend(VEC_BATCH_SCALAR));
+  assert(vec_batch_get_backend() == VEC_BATCH_SCALAR);
+  // Unsupported backends leave the current one in place
+  for (size_t b = 0; b < N_BACKENDS; b++) {
+    if (vec_batch_set_backend(BACKENDS[b])) {
+      assert(vec_batch_get_backend() == BACKENDS[b]);
+    } else {
+      assert(vec_batch_get_backend() != BACKENDS[b]);
+    }
+  }
+}
+
+void test_batch_known_values() {
+  assert(vec_batch_set_backend(VEC_BATCH_SCALAR));
+  vector_t v[] = {{1, 0}, {0, 2}, {-3, 1}};
+  vec_translate_n(&v->x, &v->y, 2, 3, (vector_t){1, 1});
+  assert(vec_equal(v[0], (vector_t){2, 1}));
+  assert(vec_equal(v[2], (vector_t){-2, 2}));
+  vec_rotate_n(&v->x, &v->y, 2, 3, rot_init(M_PI / 2), (vector_t){1, 1});
+  assert(vec_isclose(v[0], (vector_t){1, 2}));
+  assert(vec_isclose(v[1], (vector_t){-1, 1}));
+
+  real_t xs[] = {1, 2, 3}, ys[] = {-1, 0, 4};
+  real_t dots[3];
+  vec_dot_n(xs, ys, 1, 3, (vector_t){2, 1}, dots);
+  assert(isclose(dots[0], 1) && isclose(dots[1], 4) && isclose(dots[2], 10));
+  real_t min, max;
+  vec_minmax_project_n(xs, ys, 1, 3, (vector_t){2, 1}, &min, &max);
+  assert(isclose(min, 1) && isclose(max, 10));
+
+  int16_t px[3], py[3];
+  vec_to_pixels_n(xs, ys, 1, 3, (vector_t){2, 0}, 10, (vector_t){100, 50},
+                  px, py);
+  assert(px[0] == 90 && py[0] == 60);
+  assert(px[1] == 100 && py[1] == 50);
+  assert(px[2] == 110 && py[2] == 10);
+}
+
+// Checks every backend against the scalar reference for every size and layout
+void test_batch_matches_scalar() {
+  for (size_t b = 1; b < N_BACKENDS; b++) {
+    for (size_t l = 0; l < N_LAYOUTS; l++) {
+      for (size_t n = 0; n < MAX_N; n++) {
+        buffer_t input = random_buffer();
+        buffer_t expected = input, actual = input;
+        real_t *ex, *ey, *ax, *ay;
+        size_t stride;
+        layout(&expected, l, &ex, &ey, &stride);
+        layout(&actual, l, &ax, &ay, &stride);
+        vector_t v = {(double)rand() / RAND_MAX - 0.5, 0.75};
+
+        if (!vec_batch_set_backend(BACKENDS[b])) {
+          continue;
+        }
+        vec_translate_n(ax, ay, stride, n, v);
+        vec_rotate_n(ax, ay, stride, n, rot_init(0.3), v);
+        real_t actual_dots[MAX_N];
+        vec_dot_n(ax, ay, stride, n, v, actual_dots);
+        int16_t actual_px[MAX_N], actual_py[MAX_N];
+        vec_to_pixels_n(ax, ay, stride, n, v, 0.9, (vector_t){400, 200},
+                        actual_px, actual_py);
+        real_t actual_min = 0, actual_max = 0;
+        if (n > 0) {
+          vec_minmax_project_n(ax, ay, stride, n, v, &actual_min, &actual_max);
+        }
+
+        assert(vec_batch_set_backend(VEC_BATCH_SCALAR));
+        vec_translate_n(ex, ey, stride, n, v);
+        vec_rotate_n(ex, ey, stride, n, rot_init(0.3), v);
+        real_t expected_dots[MAX_N];
+        vec_dot_n(ex, ey, stride, n, v, expected_dots);
+        int16_t expected_px[MAX_N], expected_py[MAX_N];
+        vec_to_pixels_n(ex, ey, stride, n, v, 0.9, (vector_t){400, 200},
+                        expected_px, expected_py);
+        real_t expected_min = 0, expected_max = 0;
+        if (n > 0) {
+          vec_minmax_project_n(ex, ey, stride, n, v, &expected_min,
+                               &expected_max);
+        }
+
+        // Untouched components must stay untouched too
+        for (size_t i = 0; i < 3 * MAX_N; i++) {
+          assert(isclose(actual.data[i], expected.data[i]));
+        }
+        for (size_t i = 0; i < n; i++) {
+          assert(isclose(actual_dots[i], expected_dots[i]));
+          assert(actual_px[i] == expected_px[i]);
+          assert(actual_py[i] == expected_py[i]);
+        }
+        assert(isclose(actual_min, expected_min));
+        assert(isclose(actual_max, expected_max));
+      }
+    }
+  }
+}
+
+// Random bodies for vec_integrate_n(), in 9 arrays of MAX_N
+particle_arrays_t random_particles(real_t *data) {
+  for (size_t i = 0; i < 9 * MAX_N; i++) {
+    data[i] = (double)rand() / RAND_MAX * 100 - 50;
+  }
+  particle_arrays_t p = {data,
+                         data + MAX_N,
+                         data + 2 * MAX_N,
+                         data + 3 * MAX_N,
+                         data + 4 * MAX_N,
+                         data + 5 * MAX_N,
+                         data + 6 * MAX_N,
+                         data + 7 * MAX_N,
+                         data + 8 * MAX_N};
+  return p;
+}
+
+void test_integrate() {
+  assert(vec_batch_set_backend(VEC_BATCH_SCALAR));
+  real_t pos_x = 1, pos_y = 2, vel_x = 3, vel_y = 0, force_x = 4, force_y = -2,
+         impulse_x = 1, impulse_y = 0, inv_mass = 0.5;
+  particle_arrays_t one = {&pos_x,   &pos_y,     &vel_x,
+                           &vel_y,   &force_x,   &force_y,
+                           &impulse_x, &impulse_y, &inv_mass};
+  vec_integrate_n(&one, 1, 2);
+  // v' = v + dt * F / m + J / m, x' = x + dt * (v + v') / 2
+  assert(isclose(vel_x, 7.5) && isclose(vel_y, -2));
+  assert(isclose(pos_x, 11.5) && isclose(pos_y, 0));
+  assert(force_x == 0 && force_y == 0 && impulse_x == 0 && impulse_y == 0);
+
+  for (size_t b = 1; b < N_BACKENDS; b++) {
+    for (size_t n = 0; n < MAX_N; n++) {
+      real_t expected[9 * MAX_N], actual[9 * MAX_N];
+      particle_arrays_t ep = random_particles(expected);
+      particle_arrays_t ap = random_particles(actual);
+      memcpy(actual, expected, sizeof(expected));
+      if (!vec_batch_set_backend(BACKENDS[b])) {
+        continue;
+      }
+      vec_integrate_n(&ap, n, 0.01);
+      assert(vec_batch_set_backend(VEC_BATCH_SCALAR));
+      vec_integrate_n(&ep, n, 0.01);
+      // Bit-exact, so that switching backends cannot change a simulation
+      assert(memcmp(actual, expected, sizeof(expected)) == 0);
+    }
+  }
+}
+
+// Pixel rounding must match round(), including halves and negative values
+void test_to_pixels_rounding() {
+  real_t xs[] = {0.5, 1.5, -0.5, -1.5, 2.49, -2.51, 0, 7};
+  real_t ys[] = {0.5, -0.5, 1.5, -1.5, -2.49, 2.51, 0, -7};
+  for (size_t b = 0; b < N_BACKENDS; b++) {
+    if (!vec_batch_set_backend(BACKENDS[b])) {
+      continue;
+    }
+    int16_t px[8], py[8];
+    vec_to_pixels_n(xs, ys, 1, 8, VEC_ZERO, 1, VEC_ZERO, px, py);
+    for (size_t i = 0; i < 8; i++) {
+      assert(px[i] == round(xs[i]));
+      assert(py[i] == round(-ys[i]));
+    }
+  }
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_backends)
+  DO_TEST(test_batch_known_values)
+  DO_TEST(test_batch_matches_scalar)
+  DO_TEST(test_to_pixels_rounding)
+  DO_TEST(test_integrate)
+
+  puts("vec_batch_test PASS");
+}
@@ -1,3 +1,4 @@
+#include "fixed.h"
 #include "test_util.h"
 #include "vector.h"
 #include <assert.h>
@@ -75,6 +76,53 @@ void test_vec_rotate() {
   assert(vec_isclose(vec_rotate(VEC_ZERO, 1.0), VEC_ZERO));
 }
 
+void test_rot() {
+  // A cached rotation gives the same result as rotating directly
+  rot_t rot = rot_init(0.7);
+  vector_t v = {5, 7};
+  assert(vec_isclose(vec_rotate_by(v, rot), vec_rotate(v, 0.7)));
+  assert(vec_isclose(vec_rotate_by(v, rot_init(0.5 * M_PI)), (vector_t){-7, 5}));
+  assert(isclose(rot.cos * rot.cos + rot.sin * rot.sin, 1));
+}
+
+void test_fast_sincos() {
+  // Covers every quadrant, negative angles and several turns
+  for (double angle = -100; angle <= 100; angle += 0.0137) {
+    real_t s, c;
+    fast_sincos(angle, &s, &c);
+    assert(isclose(s, sin(angle)));
+    assert(isclose(c, cos(angle)));
+  }
+  real_t s, c;
+  fast_sincos(0, &s, &c);
+  assert(s == 0 && c == 1);
+}
+
+void test_fixed() {
+  fixed_t half = FIXED_ONE / 2;
+  assert(fixed_from_double(0.5) == half);
+  assert(fixed_from_double(-2.25) == -9 * FIXED_ONE / 4);
+  assert(fixed_to_double(3 * half) == 1.5);
+  assert(fixed_mul(3 * half, -4 * FIXED_ONE) == -6 * FIXED_ONE);
+  assert(fixed_div(-3 * FIXED_ONE, 4 * FIXED_ONE) == -3 * FIXED_ONE / 4);
+  assert(fixed_sqrt(9 * FIXED_ONE / 4) == 3 * half);
+  assert(fixed_sqrt(0) == 0);
+
+  for (double x = -1000; x <= 1000; x += 13.7) {
+    fixed_t fx = fixed_from_double(x);
+    fixed_t fy = fixed_from_double(0.37);
+    assert(within(1e-6, fixed_to_double(fixed_mul(fx, fy)), x * 0.37));
+    assert(within(1e-7, fixed_to_double(fixed_div(fy, fx)), 0.37 / x));
+    assert(within(1e-8, fixed_to_double(fixed_sqrt(fixed_from_double(fabs(x)))),
+                  sqrt(fabs(x))));
+
+    fixed_t s, c;
+    fixed_sincos(fixed_from_double(x / 10), &s, &c);
+    assert(within(1e-8, fixed_to_double(s), sin(x / 10)));
+    assert(within(1e-8, fixed_to_double(c), cos(x / 10)));
+  }
+}
+
 int main(int argc, char *argv[]) {
   // Run all tests if there are no command-line arguments
   bool all_tests = argc == 1;
@@ -92,6 +140,9 @@ int main(int argc, char *argv[]) {
   DO_TEST(test_vec_dot)
   DO_TEST(test_vec_cross)
   DO_TEST(test_vec_rotate)
+  DO_TEST(test_rot)
+  DO_TEST(test_fast_sincos)
+  DO_TEST(test_fixed)
 
   puts("vector_test PASS");
 }
@@ -0,0 +1,96 @@
+#include "vertex_array.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdlib.h>
+
+void test_vertex_array_init() {
+  vertex_array_t *array = vertex_array_init(3);
+  assert(vertex_array_size(array) == 3);
+  for (size_t i = 0; i < 3; i++) {
+    assert(vec_equal(vertex_array_get(array, i), VEC_ZERO));
+  }
+  vertex_array_set(array, 1, (vector_t){1, 2});
+  assert(vec_equal(vertex_array_get(array, 1), (vector_t){1, 2}));
+  assert(vec_equal(array->data[1], (vector_t){1, 2}));
+  vertex_array_free(array);
+}
+
+void test_vertex_array_empty() {
+  vertex_array_t *array = vertex_array_init(0);
+  assert(vertex_array_size(array) == 0);
+  vertex_array_free(array);
+}
+
+void test_vertex_array_from() {
+  vector_t points[] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+  vertex_array_t *array = vertex_array_from(points, 4);
+  assert(vertex_array_size(array) == 4);
+  // The array owns its own copy of the points
+  points[0] = (vector_t){5, 5};
+  assert(vec_equal(vertex_array_get(array, 0), VEC_ZERO));
+  assert(vec_equal(vertex_array_get(array, 2), (vector_t){1, 1}));
+
+  vertex_array_t *copy = vertex_array_copy(array);
+  vertex_array_set(copy, 3, (vector_t){-1, -1});
+  assert(vec_equal(vertex_array_get(array, 3), (vector_t){0, 1}));
+  assert(vec_equal(vertex_array_get(copy, 3), (vector_t){-1, -1}));
+  vertex_array_free(copy);
+  vertex_array_free(array);
+}
+
+void test_vertex_array_list_round_trip() {
+  list_t *list = list_init(3, free);
+  for (size_t i = 0; i < 3; i++) {
+    vector_t *v = malloc(sizeof(*v));
+    *v = (vector_t){i, 2 * i};
+    list_add(list, v);
+  }
+  vertex_array_t *array = vertex_array_from_list(list);
+  assert(vertex_array_size(array) == 3);
+  for (size_t i = 0; i < 3; i++) {
+    assert(vec_equal(vertex_array_get(array, i), (vector_t){i, 2 * i}));
+  }
+  list_free(list);
+
+  list = vertex_array_to_list(array);
+  assert(list_size(list) == 3);
+  for (size_t i = 0; i < 3; i++) {
+    assert(vec_equal(*(vector_t *)list_get(list, i), (vector_t){i, 2 * i}));
+  }
+  list_free(list);
+  vertex_array_free(array);
+}
+
+typedef struct {
+  vertex_array_t *array;
+  size_t index;
+} array_access_t;
+void get_out_of_bounds(void *aux) {
+  array_access_t *access = aux;
+  vertex_array_get(access->array, access->index);
+}
+void test_vertex_array_out_of_bounds() {
+  array_access_t access = {.array = vertex_array_init(2), .index = 2};
+  assert(test_assert_fail(get_out_of_bounds, &access));
+  access.index = -1;
+  assert(test_assert_fail(get_out_of_bounds, &access));
+  vertex_array_free(access.array);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_vertex_array_init)
+  DO_TEST(test_vertex_array_empty)
+  DO_TEST(test_vertex_array_from)
+  DO_TEST(test_vertex_array_list_round_trip)
+  DO_TEST(test_vertex_array_out_of_bounds)
+
+  puts("vertex_array_test PASS");
+}